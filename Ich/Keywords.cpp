@@ -1,7 +1,15 @@
 ﻿#include "Keywords.hpp"
-#include <utility>
+#include "System/System/AlphabetPolicy.h"
+#include "System/System/DictionaryIndex.h"
 
-extern const Array<String> keywords = {
+#include <array>
+
+namespace
+{
+  /// <summary>
+  /// 辞書本体。文字列リテラルを指すだけなので、起動時の初期化処理もヒープ確保も発生しない。
+  /// </summary>
+  constexpr std::u32string_view kKeywordWords[] = {
 U"あいこくしん",
 U"あいさつ",
 U"あいだ",
@@ -2051,3 +2059,142 @@ U"わすれもの",
 U"わらう",
 U"われる"
 };
+
+  /// <summary>
+  /// 単語数と、SoA 列の長さ（単語数以上の DictionaryIndex::kColumnAlignment の倍数）
+  /// </summary>
+  constexpr size_t kKeywordCount = std::size(kKeywordWords);
+  constexpr size_t kKeywordColumnStride = (kKeywordCount + DictionaryIndex::kColumnAlignment - 1) / DictionaryIndex::kColumnAlignment * DictionaryIndex::kColumnAlignment;
+
+  /// <summary>
+  /// 全単語の表記の文字数の合計（正規化後の文字数の上限）
+  /// </summary>
+  constexpr size_t kKeywordCharacterCount = []()
+  {
+    size_t count = 0;
+    for (const auto word : kKeywordWords)
+    {
+      count += word.size();
+    }
+    return count;
+  }();
+
+  /// <summary>
+  /// 長さ順の並びを引くための表の大きさ（単語の長さは uint8 なので 0 ～ 255、その次に単語数が入る）
+  /// </summary>
+  constexpr size_t kLengthOffsetCount = 257;
+
+  /// <summary>
+  /// DictionaryIndex が使う表をすべてコンパイル時に計算したもの
+  /// </summary>
+  struct KeywordTables
+  {
+    std::array<KanaId, kKeywordCharacterCount> kana_ids{};
+    std::array<uint32, kKeywordCount + 1> offsets{};
+    std::array<KanaCounts, kKeywordCount> counts{};
+    std::array<uint8, kKeywordColumnStride> lengths{};
+    std::array<uint8, kKanaAlphabetSize * kKeywordColumnStride> columns{};
+    std::array<uint32, kKeywordCount> length_order{};
+    std::array<uint32, kLengthOffsetCount> length_offsets{};
+  };
+
+  /// <summary>
+  /// 各単語の文字を1回だけ正規化し、文字ID・単語ごとの文字数・SoA 列・長さ順の並びをまとめて作る。
+  /// ひらがな以外の文字や、255 文字を超える単語があればコンパイルエラーにする。
+  /// </summary>
+  constexpr KeywordTables kKeywordTables = []()
+  {
+    KeywordTables tables;
+    uint32 kanaCount = 0;
+
+    for (size_t word = 0; word < kKeywordCount; ++word)
+    {
+      for (const char32 ch : kKeywordWords[word])
+      {
+        const uint8 symbol = HiraganaAlphabet::ToSymbol(ch);
+        if (symbol == AlphabetPolicy::kInvalidSymbol)
+        {
+          throw "keywords must consist of hiragana only.";
+        }
+        if (symbol == AlphabetPolicy::kSkipSymbol)
+        {
+          continue;
+        }
+
+        tables.kana_ids[kanaCount++] = symbol;
+        ++tables.counts[word][symbol];
+        ++tables.columns[symbol * kKeywordColumnStride + word];
+      }
+
+      tables.offsets[word + 1] = kanaCount;
+
+      const uint32 length = kanaCount - tables.offsets[word];
+      if (length >= kLengthOffsetCount - 1)
+      {
+        throw "keywords must be shorter than 256 characters.";
+      }
+      tables.lengths[word] = static_cast<uint8>(length);
+      ++tables.length_offsets[length + 1];
+    }
+
+    // 長さごとに単語番号を並べる（計数ソート）。同じ長さの中では番号順になる。
+    for (size_t n = 1; n < kLengthOffsetCount; ++n)
+    {
+      tables.length_offsets[n] += tables.length_offsets[n - 1];
+    }
+
+    std::array<uint32, kLengthOffsetCount> cursor = tables.length_offsets;
+    for (size_t word = 0; word < kKeywordCount; ++word)
+    {
+      tables.length_order[cursor[tables.lengths[word]]++] = static_cast<uint32>(word);
+    }
+
+    return tables;
+  }();
+} // namespace
+
+std::span<const std::u32string_view> GetKeywordWords()
+{
+  return kKeywordWords;
+}
+
+std::span<const KanaId> GetKeywordKanaIds()
+{
+  return std::span<const KanaId>(kKeywordTables.kana_ids.data(), kKeywordTables.offsets.back());
+}
+
+std::span<const uint32> GetKeywordOffsets()
+{
+  return kKeywordTables.offsets;
+}
+
+DictionaryIndex::BorrowedTables GetKeywordTables()
+{
+  DictionaryIndex::BorrowedTables tables;
+  tables.words = kKeywordWords;
+  tables.counts = kKeywordTables.counts;
+  tables.lengths = kKeywordTables.lengths;
+  tables.columns = kKeywordTables.columns;
+  tables.column_stride = kKeywordColumnStride;
+  tables.length_order = kKeywordTables.length_order;
+  tables.length_offsets = kKeywordTables.length_offsets;
+  return tables;
+}
+
+const Array<String>& GetKeywords()
+{
+  static const Array<String> keywords = []()
+  {
+    Array<String> words;
+    words.reserve(std::size(kKeywordWords));
+
+    for (const auto word : kKeywordWords)
+    {
+      words << String(word);
+    }
+
+    return words;
+  }();
+
+  return keywords;
+}
@@ -1,4 +1,33 @@
 ﻿#pragma once
 #include <Siv3D.hpp>
 
-extern const Array<String> keywords;
+#include <span>
+#include <string_view>
+
+#include "System/System/DictionaryIndex.h"
+#include "System/System/KanaTable.h"
+
+/// <summary>
+/// 辞書の単語（辞書に記載されている表記）。コンパイル時に埋め込んだ読み取り専用のデータを指す。
+/// </summary>
+std::span<const std::u32string_view> GetKeywordWords();
+
+/// <summary>
+/// 全単語の正規化後の文字IDを続けて並べたもの。コンパイル時に計算済み。
+/// </summary>
+std::span<const KanaId> GetKeywordKanaIds();
+
+/// <summary>
+/// 単語 i の文字IDは GetKeywordKanaIds() の [offsets[i], offsets[i + 1]) 番目。要素数は単語数 + 1。
+/// </summary>
+std::span<const uint32> GetKeywordOffsets();
+
+/// <summary>
+/// コンパイル時に計算済みの単語ごとの文字数・SoA 列・長さ順の並び。DictionaryIndex に渡すとコピーせずに参照する。
+/// </summary>
+DictionaryIndex::BorrowedTables GetKeywordTables();
+
+/// <summary>
+/// String の配列として辞書を返す。最初の呼び出しで一度だけ作る。
+/// </summary>
+const Array<String>& GetKeywords();
@@ -7,6 +7,8 @@
 #include "Scenes/InGame.h"
 #include "System/Task/TaskManager.h"
 #include "System/Renderer/Renderer.h"
+#include "System/System/DictionaryCompiler.h"
+#include "System/System/WorkerPool.h"
 #include "System/SaveData/SaveData.hpp"
 
 // ステートの型は String
@@ -45,6 +47,12 @@ void DrawFrameRate()
 
 void Main()
 {
+  // 辞書の変換が指定された場合は、ゲームを起動せずに変換だけを行って終了する。
+  if (const Array<String> args = System::GetCommandLineArgs(); DictionaryCompiler::IsRequested(args)) {
+    DictionaryCompiler::Run(args);
+    return;
+  }
+
   PRINT << U"Hello, Siv3D!" << 123 << 45.67;
 
   // 画面サイズを1280x720に設定
@@ -69,26 +77,29 @@ void Main()
   std::shared_ptr<Renderer> renderer(Renderer::GetInstance(), [](Renderer*) {});
   task_manager->AddTask(renderer);
 
-  // シーンマネージャーを作成
-  App manager;
+  // シーンマネージャーはワーカープールより先に破棄する（シーンが持つ背景の処理がプールを使うことがある）
+  {
+    // シーンマネージャーを作成
+    App manager;
 
-  // 各シーンを登録する
-  manager.add<Game>(EnumScene::kInGame);
-  manager.add<Title>(EnumScene::kTitle);
+    // 各シーンを登録する
+    manager.add<Game>(EnumScene::kInGame);
+    manager.add<Title>(EnumScene::kTitle);
 
-  while (System::Update()) {
-    task_manager->UpdateTask(static_cast<float>(Scene::DeltaTime()));
+    while (System::Update()) {
+      task_manager->UpdateTask(static_cast<float>(Scene::DeltaTime()));
 
-    // 現在のシーンを実行する
-    // シーンに実装した .update() と .draw() が実行される
-    if (not manager.update()) {
-      break;
-    }
+      // 現在のシーンを実行する
+      // シーンに実装した .update() と .draw() が実行される
+      if (not manager.update()) {
+        break;
+      }
 
-    task_manager->RenderTask();
+      task_manager->RenderTask();
 
-    // フレームレートを描画（デバッグモードのみ）
-    DrawFrameRate();
+      // フレームレートを描画（デバッグモードのみ）
+      DrawFrameRate();
+    }
   }
 
 #if _DEBUG
@@ -97,5 +108,6 @@ void Main()
 #endif
 
   task_manager->Destroy();
+  WorkerPool::Destroy();
 }
 
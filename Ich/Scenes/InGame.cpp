@@ -6,6 +6,8 @@
 #include "System/SaveData/SaveData.hpp"
 #include "System/Menu/GameSettings.h"
 #include "System/System/BlockManager.h"
+#include "System/System/MappedDictionary.h"
+#include "System/System/WordPackingSolver.h"
 #include "Keywords.hpp"
 
 namespace InGameConstants {
@@ -26,6 +28,16 @@ namespace InGameConstants {
 
   // 文字収集パラメータ
   constexpr size_t kMaxCharacters = 5;            // 最大文字数
+
+  // 辞書パラメータ（このファイルがあれば、その単語を辞書に追加し、更新されるたびに反映する）
+  const String kUserDictionaryPath = U"Assets/Dictionary/words.txt";
+  // 単語の集め方ごとの辞書（DictionaryCompiler で書き出したファイル、WordMode の順）。ファイルがなければ埋め込みの辞書を使う
+  const Array<String> kModeDictionaryPaths = {
+    U"Assets/Dictionary/any_order.ichd",
+    U"Assets/Dictionary/ordered.ichd",
+    U"Assets/Dictionary/shiritori.ichd",
+    U"Assets/Dictionary/path.ichd",
+  };
   // UIパラメータ
   constexpr int32 kAirGaugeX = 900;               // エアゲージX座標
   constexpr int32 kAirGaugeY = 50;                // エアゲージY座標
@@ -56,6 +68,13 @@ namespace InGameConstants {
 
   constexpr double kHintUpdateInterval = 3.0;
 
+  // 経路モードで見つかる単語の一覧パラメータ
+  constexpr int32 kPathWordOverlayX = 20;
+  constexpr int32 kPathWordOverlayY = 650;
+  constexpr int32 kPathWordOverlayWidth = 680;
+  constexpr int32 kPathWordOverlayHeight = 50;
+  constexpr size_t kPathWordOverlayMaxWords = 12;
+
   // ブロックのイメージパス
   const Array<String> kBlockTexturePaths = {
     U"Assets/Image/block_blue.jpg",
@@ -94,6 +113,13 @@ Game::Game(const InitData& init)
   , ui_(std::make_shared<Ui>())
   , player_(std::make_shared<Player>())
   , air_amount_(1.0f)
+  , keyword_index_{ GetKeywordTables() }
+  , keyword_matcher_{ keyword_index_ }
+  , dictionary_reloader_{ InGameConstants::kUserDictionaryPath }
+  , ordered_automaton_{ keyword_index_ }
+  , shiritori_graph_{ std::make_shared<const ShiritoriGraph>(keyword_index_) }
+  , path_finder_{ keyword_index_ }
+  , next_block_advisor_{ keyword_index_ }
   , block_font_{ 40, Typeface::Bold }
   , completed_word_font_{ 16 }
   , hint_font_{ 20 }
@@ -130,19 +156,19 @@ Game::Game(const InitData& init)
   ui_->SetSideBoxVisible(true);
 
   // ブロックグリッドを生成（10行x6列、バッチサイズ20）
-  const Array<Array<String>> stringGrid = block_manager_.GenerateBlockGrid(
+  const Array<Array<KanaId>> kanaGrid = block_manager_.GenerateKanaGrid(
     InGameConstants::kGridRows,
     InGameConstants::kGridColumns,
     InGameConstants::kBatchSize,
-    keywords
+    keyword_index_
   );
 
-  // String配列をBlock配列に変換
-  block_grid_.resize(stringGrid.size());
-  for (size_t row = 0; row < stringGrid.size(); ++row) {
-    block_grid_[row].resize(stringGrid[row].size());
-    for (size_t col = 0; col < stringGrid[row].size(); ++col) {
-      block_grid_[row][col] = Block(stringGrid[row][col]);
+  // KanaId配列をBlock配列に変換
+  block_grid_.resize(kanaGrid.size());
+  for (size_t row = 0; row < kanaGrid.size(); ++row) {
+    block_grid_[row].resize(kanaGrid[row].size());
+    for (size_t col = 0; col < kanaGrid[row].size(); ++col) {
+      block_grid_[row][col] = Block(kanaGrid[row][col]);
       const float gridX = InGameConstants::kStartBlock.x + row * InGameConstants::kBlockSize;
       const float gridY = InGameConstants::kStartBlock.y + col * InGameConstants::kBlockSize;
       //block_grid_[row][col].position = Vec2(static_cast<int32>(gridX), static_cast<int32>(gridY));
@@ -160,7 +186,7 @@ Game::Game(const InitData& init)
   player_->SetMoveSpeed(InGameConstants::kPlayerMoveSpeed);  // 移動速度を200ピクセル/秒に設定
   
   for (size_t i = 0; i < max_string_; i++) {
-    have_words_.push_back(U"");
+    have_words_.push_back(kInvalidKanaId);
   }
 
   UpdateHint();
@@ -278,11 +304,32 @@ void Game::DestroyBlockUnderPlayer()
         block.is_destroyed = true;
         PRINT << U"Block destroyed (" << direction << U") at row: " << i << U", col: " << j;
 
+        // 経路モードでは、壊したブロックを通る経路で読めていた単語が完成
+        // （探索器は辞書の変更を反映するまで作り直さないので、その間に取り除かれた単語は数えない）
+        if (word_mode_ == WordMode::kPath) {
+          for (const uint32 wordId : path_finder_.ClearCell(static_cast<int32>(i), static_cast<int32>(j))) {
+            if (keyword_index_.IsRemoved(wordId)) {
+              continue;
+            }
+
+            const String word{ keyword_index_.GetWord(wordId) };
+            if (!completed_words_.includes(word)) {
+              completed_words_.push_back(word);
+            }
+          }
+        }
+
         // 文字を追加
         have_words_.push_back(block.value);
+        keyword_matcher_.Push(block.value);
+
+        if (word_mode_ == WordMode::kOrdered) {
+          AdvanceOrderedWords(block.value);
+        }
 
         // max_string_を超えたら先頭から削除
         while (have_words_.size() > max_string_) {
+          keyword_matcher_.Evict(have_words_.front());
           have_words_.erase(have_words_.begin());
           PRINT << U"Removed oldest character. Current size: " << have_words_.size();
         }
@@ -532,6 +579,51 @@ void Game::UpdatePlayerMovement(float delta_time)
 
 void Game::update()
 {
+  // 単語一覧ファイルが更新されていれば、辞書に差分を反映する（判定結果は次の Refresh で計算し直される）
+  if (dictionary_reloader_.Update(keyword_index_, keyword_matcher_)) {
+    is_ordered_automaton_stale_ = true;
+    is_shiritori_graph_stale_ = true;
+    is_path_finder_stale_ = true;
+    is_advisor_stale_ = true;
+  }
+
+  // 単語の集め方に合わせた辞書に差し替える（差分の反映中は索引を変更できないので、終わってから）
+  if (is_dictionary_stale_ && !dictionary_reloader_.IsBusy()) {
+    is_dictionary_stale_ = false;
+    SwitchDictionary();
+  }
+
+  // 順番モードのオートマトンは差分更新できないため、辞書の反映が終わってから作り直す
+  if (word_mode_ == WordMode::kOrdered && is_ordered_automaton_stale_ && !dictionary_reloader_.IsBusy()) {
+    ordered_automaton_ = OrderedWordAutomaton{ keyword_index_ };
+    ordered_state_ = OrderedWordAutomaton::kRootState;
+    is_ordered_automaton_stale_ = false;
+  }
+
+  // しりとりのグラフも同様に作り直す（つないだ単語の番号は辞書を変更しても変わらない）
+  if (word_mode_ == WordMode::kShiritori && is_shiritori_graph_stale_ && !dictionary_reloader_.IsBusy()) {
+    shiritori_graph_ = std::make_shared<const ShiritoriGraph>(keyword_index_);
+    is_shiritori_graph_stale_ = false;
+    RequestShiritoriChainSearch();
+  }
+
+  // 経路の探索器も同様に作り直す
+  if (word_mode_ == WordMode::kPath && is_path_finder_stale_ && !dictionary_reloader_.IsBusy()) {
+    path_finder_ = PathWordFinder{ keyword_index_ };
+    is_path_finder_stale_ = false;
+    ResetPathFinder();
+  }
+
+  // 提案器も同様に作り直す（次のフレームで探索し直す）
+  if (is_advisor_stale_ && !dictionary_reloader_.IsBusy()) {
+    next_block_advisor_ = NextBlockAdvisor{ keyword_index_ };
+    advisor_row_ = -1;
+    is_advisor_stale_ = false;
+  }
+
+  // 最長の鎖の探索が終わっていれば結果を受け取る
+  shiritori_searcher_.Update();
+
   // Esc キーでメニュー開閉
   if (KeyEscape.down()) {
     PRINT << U"Toggle Menu";
@@ -564,16 +656,17 @@ void Game::update()
 
   // have_words_を連結して1行で表示
   String concatenated;
-  for (const auto& word : have_words_) {
-    concatenated += word;
+  for (const KanaId word : have_words_) {
+    concatenated += GetKanaString(word);
   }
   PRINT << U"Concatenated: " << concatenated;
 
-  // 単語が完成したかチェック
-  Array<String> result = block_manager_.GetHitWords(have_words_, keywords);
-  if (!result.isEmpty()) {
-    // resultの各単語について処理
-    for (const auto& hitWord : result) {
+  // 単語が完成したかチェック（判定は手持ちが変わったときだけスナップショット内でやり直す）
+  // （順番モードでは、ブロックを壊したときに AdvanceOrderedWords で判定する）
+  word_state_.Refresh(keyword_matcher_, have_words_, completed_words_);
+  if (word_mode_ == WordMode::kAnyOrder) {
+    for (const uint32 hitId : word_state_.GetMatches().hit_ids) {
+      const String hitWord{ keyword_index_.GetWord(hitId) };
       // 完成した単語をcompleted_words_に追加（重複チェック）
       if (!completed_words_.includes(hitWord)) {
         completed_words_.push_back(hitWord);
@@ -581,12 +674,69 @@ void Game::update()
       }
     }
   }
+  else if (word_mode_ == WordMode::kShiritori) {
+    ExtendShiritoriChain();
+  }
+
+  // 完成した単語が増えた場合は、ブロックの色分けを更新する
+  word_state_.Refresh(keyword_matcher_, have_words_, completed_words_);
 
   // Zキーでブロック破壊
   if (KeyZ.pressed()) {
     DestroyBlockUnderPlayer();
   }
 
+  // Cキーで手持ちのブロックを換金する
+  if (KeyC.down()) {
+    CashInWords();
+  }
+
+  // Nキーで次に壊すブロックの提案を切り替える
+  if (KeyN.down()) {
+    is_advisor_enabled_ = !is_advisor_enabled_;
+    advisor_row_ = -1;
+    if (!is_advisor_enabled_) {
+      next_block_advisor_.Clear();
+    }
+    PRINT << U"Next block advisor: " << (is_advisor_enabled_ ? U"on" : U"off");
+  }
+
+  // Mキーで単語の集め方（順不同／順番どおり／しりとり／経路）を切り替える
+  if (KeyM.down()) {
+    switch (word_mode_) {
+    case WordMode::kAnyOrder:
+      word_mode_ = WordMode::kOrdered;
+      PRINT << U"Word mode: ordered";
+      break;
+    case WordMode::kOrdered:
+      word_mode_ = WordMode::kShiritori;
+      PRINT << U"Word mode: shiritori";
+      break;
+    case WordMode::kShiritori:
+      word_mode_ = WordMode::kPath;
+      PRINT << U"Word mode: path";
+      break;
+    default:
+      word_mode_ = WordMode::kAnyOrder;
+      PRINT << U"Word mode: any order";
+      break;
+    }
+    ordered_state_ = OrderedWordAutomaton::kRootState;
+    is_dictionary_stale_ = true;
+
+    // しりとりは鎖の先頭から始める
+    shiritori_chain_.clear();
+    shiritori_last_kana_ = kInvalidKanaId;
+    if (word_mode_ == WordMode::kShiritori && !is_shiritori_graph_stale_) {
+      RequestShiritoriChainSearch();
+    }
+
+    // 経路モードの間だけ盤面の変化を追うので、入るときに盤面を設定し直す
+    if (word_mode_ == WordMode::kPath && !is_path_finder_stale_) {
+      ResetPathFinder();
+    }
+  }
+
 
   if (!is_paused_) {
     hint_timer_ += Scene::DeltaTime();
@@ -630,6 +780,15 @@ void Game::update()
 
   // カメラ位置を更新（プレイヤーに追従）
   UpdateCamera();
+
+  // 経路モードでは、カメラの移動で見えている行が変わったときだけ探索し直す
+  if (word_mode_ == WordMode::kPath && !is_path_finder_stale_) {
+    UpdatePathFinderRows();
+  }
+
+  if (is_advisor_enabled_ && !is_advisor_stale_) {
+    UpdateNextBlockAdvisor();
+  }
 }
 
 void Game::DrawDebugInfo() const
@@ -730,8 +889,17 @@ void Game::draw() const
         // ブロック内のテキストを中央に描画
         constexpr Vec2 shadowOffset{ 3.0, 3.0 };
         const Vec2 shadowPos = blockCenter + shadowOffset;
-        block_font_(block.value).drawAt(shadowPos.x, shadowPos.y, ColorF{ 0.0, 0.0, 0.0, 0.9 });
-        block_font_(block.value).drawAt(blockCenter.x, blockCenter.y, ColorF{ 1.0 });
+        const String& blockText = GetKanaString(block.value);
+        block_font_(blockText).drawAt(shadowPos.x, shadowPos.y, ColorF{ 0.0, 0.0, 0.0, 0.9 });
+        block_font_(blockText).drawAt(blockCenter.x, blockCenter.y, ColorF{ 1.0 });
+      }
+    }
+
+    // 次に壊すと良いブロックを枠で強調
+    if (is_advisor_enabled_) {
+      if (const auto& advice = next_block_advisor_.GetAdvice()) {
+        const Vec2 adviceTopLeft = GetGridTopLeft(advice->row, advice->column);
+        RoundRect{ adviceTopLeft.x, adviceTopLeft.y, InGameConstants::kBlockSize, InGameConstants::kBlockSize, 15 }.drawFrame(5, ColorF{ 1.0, 0.9, 0.2, 0.9 });
       }
     }
 
@@ -790,21 +958,29 @@ void Game::draw() const
   // 明るさ設定を適用
   GameSettings::GetInstance()->ApplyBrightness();
 
-  //------- 文字表示（上部：現在収集中の文字）- もじぴったん風のボックス表示
-  Array<String> result = block_manager_.GetHitWords(have_words_, keywords);
+  // 経路モードでは、画面に見えているブロックからたどれる単語を一覧表示
+  if (word_mode_ == WordMode::kPath) {
+    const RectF overlay{ InGameConstants::kPathWordOverlayX, InGameConstants::kPathWordOverlayY, InGameConstants::kPathWordOverlayWidth, InGameConstants::kPathWordOverlayHeight };
+    overlay.draw(ColorF{ 0.0, 0.0, 0.0, 0.6 });
+
+    const Array<uint32>& foundWords = path_finder_.GetFoundWords();
+    String text = U"たどれる単語 {}: "_fmt(foundWords.size());
+    for (size_t i = 0; i < Min(foundWords.size(), InGameConstants::kPathWordOverlayMaxWords); ++i) {
+      text += keyword_index_.GetWord(foundWords[i]);
+      text += U" ";
+    }
+    if (foundWords.size() > InGameConstants::kPathWordOverlayMaxWords) {
+      text += U"…";
+    }
+    debug_font_(text).draw(overlay.pos.movedBy(10, 15), ColorF{ 1.0 });
+  }
 
+  //------- 文字表示（上部：現在収集中の文字）- もじぴったん風のボックス表示
   for (int i = 0; i < have_words_.size(); i++) {
-    const String& word = have_words_[i];
+    const String& word = GetKanaString(have_words_[i]);
 
-    // この文字が完成した単語に含まれているかチェック
-    bool isInCompletedWord = false;
-
-    for (const auto& completedWord : completed_words_) {
-      if (completedWord.includes(word)) {
-        isInCompletedWord = true;
-        break;
-      }
-    }
+    // この文字が完成した単語に含まれているかチェック（update で計算済みの結果を使う）
+    const bool isInCompletedWord = word_state_.IsInCompletedWord(i);
 
     // ボックスの位置を計算
     const int32 boxX = InGameConstants::kCharBoxStartX + i * (InGameConstants::kCharBoxSize + InGameConstants::kCharBoxSpacing);
@@ -851,6 +1027,16 @@ void Game::draw() const
     completed_word_font_(completed_words_[index]).draw(textX, textY, ColorF{ 0.0, 1.0, 0.0 });
   }
 
+  // しりとりモードでは、次に必要な文字と、ここから続けられる最長の単語数を表示
+  if (word_mode_ == WordMode::kShiritori) {
+    const String next = (shiritori_last_kana_ == kInvalidKanaId) ? String{ U"自由" } : GetKanaString(shiritori_last_kana_);
+    String longest = U"計算中";
+    if (const auto& result = shiritori_searcher_.GetResult()) {
+      longest = result->is_exact ? U"{}"_fmt(result->length) : U"{}以上"_fmt(result->length);
+    }
+    debug_font_(U"しりとり: 次「{}」 あと最長 {} 語"_fmt(next, longest)).draw(InGameConstants::kCompletedBoardX + 10, InGameConstants::kCompletedBoardY + InGameConstants::kCompletedBoardHeight - 50, ColorF{ 1.0 });
+  }
+
   // 完成した単語の数を表示
   debug_font_(U"完成数: {}"_fmt(completed_words_.size())).draw(InGameConstants::kCompletedBoardX + 10, InGameConstants::kCompletedBoardY + InGameConstants::kCompletedBoardHeight - 25, ColorF{ 1.0 });
 }
@@ -914,40 +1100,181 @@ void Game::UpdateCamera()
   }
 }
 
-void Game::UpdateHint()
+void Game::AdvanceOrderedWords(const KanaId id)
 {
-  const Array<std::pair<String, String>> reachWords = block_manager_.GetReachWords(have_words_, keywords);
+  ordered_state_ = ordered_automaton_.Next(ordered_state_, id);
 
-  if (reachWords.isEmpty()) {
-    current_hint_.clear();
+  ordered_automaton_.ForEachMatch(ordered_state_, [this](const uint32 wordId) {
+    // ホットリロードで取り除かれた単語は、オートマトンを作り直すまで残っているので除外する
+    if (keyword_index_.IsRemoved(wordId)) {
+      return;
+    }
+
+    const String word{ keyword_index_.GetWord(wordId) };
+    if (!completed_words_.includes(word)) {
+      completed_words_.push_back(word);
+    }
+  });
+}
+
+void Game::CashInWords()
+{
+  // 順不同モードでは作れた単語はすぐ完成済みになるので、完成済みかどうかに関係なく今の手持ちで作れる単語を換金する
+  const auto result = WordPackingSolver::CashIn(keyword_index_, keyword_matcher_, have_words_);
+  if (!result || result->word_ids.isEmpty()) {
     return;
   }
 
-  Array<String> candidates;
-  candidates.reserve(reachWords.size());
-  for (const auto& entry : reachWords) {
-    if (entry.first.isEmpty()) {
+  for (const uint32 wordId : result->word_ids) {
+    const String word{ keyword_index_.GetWord(wordId) };
+    if (!completed_words_.includes(word)) {
+      completed_words_.push_back(word);
+    }
+  }
+
+  // 手持ちの並びが変わるので、順番モードの途中経過は捨てる
+  ordered_state_ = OrderedWordAutomaton::kRootState;
+  PRINT << U"Cashed in " << result->word_ids.size() << U" words. Score: " << result->score;
+}
+
+void Game::ExtendShiritoriChain()
+{
+  bool isExtended = false;
+
+  for (const uint32 hitId : word_state_.GetMatches().hit_ids) {
+    if (shiritori_chain_.includes(hitId) || !shiritori_graph_->CanFollow(shiritori_last_kana_, hitId)) {
       continue;
     }
-    if (!entry.second.isEmpty()) {
-      String masked = entry.first;
-      for (char32& ch : masked) {
-        if (ch == entry.second.front()) {
-          ch = U'〇';
-        }
-      }
-      candidates << masked;
+
+    shiritori_chain_.push_back(hitId);
+    shiritori_last_kana_ = shiritori_graph_->GetLastKana(hitId);
+    isExtended = true;
+
+    const String word{ keyword_index_.GetWord(hitId) };
+    if (!completed_words_.includes(word)) {
+      completed_words_.push_back(word);
     }
-    else {
-      candidates << entry.first;
+  }
+
+  if (isExtended) {
+    RequestShiritoriChainSearch();
+  }
+}
+
+void Game::RequestShiritoriChainSearch()
+{
+  // 探索は背景スレッドで行い、毎フレームは結果を確認するだけにする
+  shiritori_searcher_.Request(shiritori_graph_, shiritori_last_kana_, shiritori_chain_);
+}
+
+void Game::SwitchDictionary()
+{
+  const FilePath& path = InGameConstants::kModeDictionaryPaths[static_cast<size_t>(word_mode_)];
+  if (path == dictionary_path_) {
+    return;
+  }
+
+  Optional<DictionaryIndex> mapped = MappedDictionary::OpenIndex(path);
+  const FilePath loadedPath = mapped ? path : FilePath{};
+  if (loadedPath == dictionary_path_) {
+    return;
+  }
+
+  keyword_index_ = mapped ? std::move(*mapped) : DictionaryIndex{ GetKeywordTables() };
+  dictionary_path_ = loadedPath;
+  PRINT << U"Dictionary: " << (dictionary_path_.isEmpty() ? String{ U"embedded" } : dictionary_path_);
+
+  // 判定器を作り直して手持ちを入れ直す
+  keyword_matcher_ = IncrementalWordMatcher{ keyword_index_ };
+  for (const KanaId kana : have_words_) {
+    keyword_matcher_.Push(kana);
+  }
+  word_state_.Invalidate();
+
+  // 単語番号を持つ構造は、このフレームのうちに作り直す
+  shiritori_chain_.clear();
+  shiritori_last_kana_ = kInvalidKanaId;
+  is_ordered_automaton_stale_ = true;
+  is_shiritori_graph_stale_ = true;
+  is_path_finder_stale_ = true;
+  is_advisor_stale_ = true;
+
+  // 単語一覧ファイルの単語を新しい辞書にも追加し直す（辞書の単語は取り除かない）
+  dictionary_reloader_.Reset();
+}
+
+void Game::ResetPathFinder()
+{
+  const int32 rowCount = static_cast<int32>(block_grid_.size());
+  const int32 columnCount = block_grid_.isEmpty() ? 0 : static_cast<int32>(block_grid_[0].size());
+
+  UpdatePathFinderRows();
+  path_finder_.SetGrid(rowCount, columnCount, MakeGridCells());
+}
+
+Array<KanaId> Game::MakeGridCells() const
+{
+  Array<KanaId> cells;
+  for (const auto& row : block_grid_) {
+    for (const Block& block : row) {
+      cells.push_back(block.isEmpty() ? kInvalidKanaId : block.value);
     }
   }
+  return cells;
+}
+
+void Game::UpdateNextBlockAdvisor()
+{
+  int32 gridRow = 0;
+  int32 gridCol = 0;
+  if (!GetPlayerGridPosition(gridRow, gridCol)) {
+    return;
+  }
+
+  // ブロックを壊すと手持ちが変わるので、盤面の変化も手持ちの更新番号で分かる
+  const uint64 revision = keyword_matcher_.GetRevision();
+  if (revision != advisor_revision_ || gridRow != advisor_row_ || gridCol != advisor_column_) {
+    advisor_revision_ = revision;
+    advisor_row_ = gridRow;
+    advisor_column_ = gridCol;
+
+    const int32 rowCount = static_cast<int32>(block_grid_.size());
+    const int32 columnCount = block_grid_.isEmpty() ? 0 : static_cast<int32>(block_grid_[0].size());
+    next_block_advisor_.Start(rowCount, columnCount, MakeGridCells(), gridRow, gridCol, have_words_, max_string_, completed_words_);
+  }
 
-  if (candidates.isEmpty()) {
+  // 探索は1フレームあたりの時間を区切って少しずつ進める
+  next_block_advisor_.Step(NextBlockAdvisor::kDefaultTimeSlice);
+}
+
+void Game::UpdatePathFinderRows()
+{
+  const double top = camera_offset_.y - InGameConstants::kStartY;
+  const int32 rowBegin = static_cast<int32>(Math::Floor(top / InGameConstants::kBlockSize));
+  const int32 rowEnd = static_cast<int32>(Math::Ceil((top + Scene::Height()) / InGameConstants::kBlockSize));
+  path_finder_.SetVisibleRows(rowBegin, rowEnd);
+}
+
+void Game::UpdateHint()
+{
+  // ヒントはリーチ単語の問い合わせと同じ走査の中で1件選ばれる
+  word_state_.Refresh(keyword_matcher_, have_words_, completed_words_, true);
+  const WordMatchBuffers& matches = word_state_.GetMatches();
+
+  if (!matches.hint) {
     current_hint_.clear();
     return;
   }
 
-  const size_t index = static_cast<size_t>(Random(0, static_cast<int32>(candidates.size() - 1)));
-  current_hint_ = candidates[index];
+  // 選ばれた1件だけ、不足している文字を〇に置き換えた文字列を作る。
+  const size_t hint = *matches.hint;
+  const uint32 wordId = matches.reach_ids[hint];
+  const String missing = keyword_index_.GetMissingCharacter(wordId, matches.reach_missing[hint], keyword_matcher_.GetHeldCounts());
+
+  current_hint_ = String{ keyword_index_.GetWord(wordId) };
+  for (char32& ch : current_hint_) {
+    if (ch == missing.front()) {
+      ch = U'〇';
+    }
+  }
 }
@@ -9,6 +9,15 @@
 #include "InGame/Ui.h"
 #include "Player.hpp"
 #include "System/System/BlockManager.h"
+#include "System/System/DictionaryHotReloader.h"
+#include "System/System/DictionaryIndex.h"
+#include "System/System/IncrementalWordMatcher.h"
+#include "System/System/NextBlockAdvisor.h"
+#include "System/System/OrderedWordAutomaton.h"
+#include "System/System/PathWordFinder.h"
+#include "System/System/ShiritoriChainSearcher.h"
+#include "System/System/ShiritoriGraph.h"
+#include "System/System/WordStateSnapshot.h"
 
 // ゲームシーン
 class Game : public SceneManager<EnumScene, SaveData>::Scene
@@ -117,6 +126,53 @@ private:
 
   void UpdateHint();
 
+  /// <summary>
+  /// 順番モードで、壊したブロックの文字でオートマトンを1つ進め、末尾に完成した単語を完成リストに追加する
+  /// </summary>
+  void AdvanceOrderedWords(KanaId id);
+
+  /// <summary>
+  /// 手持ちのブロックを重複なく分け合って作れる未完成の単語を、文字数の合計が最大になるよう選んで完成させ、
+  /// 使ったブロックを手持ちから取り除く（換金）
+  /// </summary>
+  void CashInWords();
+
+  /// <summary>
+  /// しりとりモードで、ヒットした単語のうち鎖に続けられるものを順につなぎ、完成リストに追加する
+  /// </summary>
+  void ExtendShiritoriChain();
+
+  /// <summary>
+  /// 今の鎖から続けられる最長の鎖の探索を依頼する
+  /// </summary>
+  void RequestShiritoriChainSearch();
+
+  /// <summary>
+  /// 経路モードの探索器に今の盤面を設定し、見えている範囲を探索し直す
+  /// </summary>
+  void ResetPathFinder();
+
+  /// <summary>
+  /// 今の単語の集め方の辞書ファイルに索引を差し替える（ファイルがなければ埋め込みの辞書）。
+  /// 単語番号が変わるので、判定器と単語番号を持つ構造をすべて作り直す
+  /// </summary>
+  void SwitchDictionary();
+
+  /// <summary>
+  /// 経路モードの探索器に、カメラから求めた見えている行の範囲を設定する（範囲が変わったときだけ探索し直す）
+  /// </summary>
+  void UpdatePathFinderRows();
+
+  /// <summary>
+  /// 盤面を行優先で並べた各マスの文字を返す（空きマス・壊したブロックは kInvalidKanaId）
+  /// </summary>
+  Array<KanaId> MakeGridCells() const;
+
+  /// <summary>
+  /// 手持ちかプレイヤーのマスが変わっていれば提案の探索をやり直し、このフレームの分だけ探索を進める
+  /// </summary>
+  void UpdateNextBlockAdvisor();
+
   /// <summary>
   /// ブロックのテクスチャ
   /// </summary>
@@ -151,19 +207,84 @@ private:
   // ブロックマネージャー
   BlockManager block_manager_;
 
+  // 単語判定用の辞書索引（コンパイル時に計算済みの表、または単語の集め方ごとの辞書ファイルを割り当てた列を参照する）
+  DictionaryIndex keyword_index_;
+
+  // 索引の元になっている辞書ファイル（空なら埋め込みの辞書）と、単語の集め方が変わって差し替えが必要か
+  FilePath dictionary_path_;
+  bool is_dictionary_stale_ = true;
+
+  // have_words_ の増減に合わせてヒット・リーチを差分更新する判定器
+  IncrementalWordMatcher keyword_matcher_;
+
+  // ヒット・リーチと手持ちブロックの色分けのスナップショット（手持ちが変わったときだけ計算し直す）
+  WordStateSnapshot word_state_;
+
+  // 単語一覧ファイルの単語を keyword_index_ / keyword_matcher_ に追加として重ねる
+  // （索引より後に宣言して先に破棄させ、読み込み中の背景処理が終わるのを待ってから索引が破棄されるようにする）
+  DictionaryHotReloader dictionary_reloader_;
+
+  // 単語の集め方
+  enum class WordMode
+  {
+    kAnyOrder,  // 手持ちの文字を並べ替えて作れれば完成
+    kOrdered,   // 壊した順に連続して集めた文字列が単語になったときだけ完成
+    kShiritori, // 直前に完成した単語の最後の文字で始まる単語だけが完成（しりとり）
+    kPath,      // 隣り合うブロックをたどって読める単語の経路上のブロックを壊すと完成（Boggle 形式）
+  };
+  WordMode word_mode_ = WordMode::kAnyOrder;
+
+  // 順番モードの判定用オートマトンと、壊したブロックの列に対する現在の状態
+  OrderedWordAutomaton ordered_automaton_;
+  OrderedWordAutomaton::State ordered_state_ = OrderedWordAutomaton::kRootState;
+
+  // 辞書が変更され、オートマトンを作り直す必要があるか
+  bool is_ordered_automaton_stale_ = false;
+
+  // しりとりモードの単語のつながり（背景の探索と共有するため shared_ptr で持つ）
+  std::shared_ptr<const ShiritoriGraph> shiritori_graph_;
+
+  // しりとりでつないだ単語と、次の単語が始まるべき文字（鎖の先頭なら kInvalidKanaId）
+  Array<uint32> shiritori_chain_;
+  KanaId shiritori_last_kana_ = kInvalidKanaId;
+
+  // 「ここから続けられる最長の鎖」を背景で求める
+  ShiritoriChainSearcher shiritori_searcher_;
+
+  // 辞書が変更され、しりとりのグラフを作り直す必要があるか
+  bool is_shiritori_graph_stale_ = false;
+
+  // 経路モードで、画面に見えているブロックからたどれる単語を探す（ブロックを壊したときだけ差分で探し直す）
+  PathWordFinder path_finder_;
+
+  // 辞書が変更され、経路の探索器を作り直す必要があるか
+  bool is_path_finder_stale_ = false;
+
+  // 次に壊すと良いブロックの提案（Nキーで切り替え、毎フレーム時間を区切って探索を進める）
+  NextBlockAdvisor next_block_advisor_;
+  bool is_advisor_enabled_ = false;
+
+  // 提案の探索を始めたときの手持ちの更新番号とプレイヤーのマス（変わったら探索し直す）
+  uint64 advisor_revision_ = 0;
+  int32 advisor_row_ = -1;
+  int32 advisor_column_ = -1;
+
+  // 辞書が変更され、提案器を作り直す必要があるか
+  bool is_advisor_stale_ = false;
+
   // ブロック構造体
   struct Block
   {
-    String value;           // ブロックに表示される文字列
+    KanaId value;           // ブロックに表示される文字（空きマスは kInvalidKanaId）
     bool is_destroyed;      // ブロックが破壊されているか
     Vec2 position;      // ブロックのピクセル位置（左上）
     
     Block() 
-      : value(U"")
+      : value(kInvalidKanaId)
       , is_destroyed(false)
     {}
     
-    Block(const String& val) 
+    Block(const KanaId val) 
       : value(val)
       , is_destroyed(false)
     {}
@@ -171,7 +292,7 @@ private:
     // ブロックが空かどうか
     bool isEmpty() const
     {
-      return value.isEmpty() || is_destroyed;
+      return value == kInvalidKanaId || is_destroyed;
     }
   };
 
@@ -194,7 +315,7 @@ private:
   // プレイヤーの移動入力
   Vec2 player_move_input_ = Vec2::Zero();
 
-  Array<String> have_words_;
+  Array<KanaId> have_words_;
 
   // 最大文字数
   size_t max_string_ = 7;
@@ -0,0 +1,145 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+#include <array>
+
+#include "./KanaTable.h"
+
+/// <summary>
+/// AlphabetWordEngine に渡す文字種ごとの規則（アルファベットポリシー）。
+/// 各ポリシーは次を持つ。
+/// ・kSize: 正規化後の記号の種類数
+/// ・Count: 1記号あたりの個数の型
+/// ・ToSymbol(ch): 文字を 0 ～ kSize-1 の記号番号に正規化する constexpr 関数（kSkipSymbol / kInvalidSymbol を返すこともある）
+/// ・FromSymbol(id): 記号番号を正規化後の文字に戻す
+/// </summary>
+namespace AlphabetPolicy
+{
+  /// <summary>
+  /// 長音記号など、数えずに読み飛ばす文字の記号番号。
+  /// </summary>
+  inline constexpr uint8 kSkipSymbol = 0xFE;
+
+  /// <summary>
+  /// アルファベット外の文字の記号番号。
+  /// </summary>
+  inline constexpr uint8 kInvalidSymbol = 0xFF;
+} // namespace AlphabetPolicy
+
+/// <summary>
+/// ひらがな（濁点・半濁点・小書きを清音に集約、長音記号は読み飛ばす）。記号番号は KanaId と同じ。
+/// </summary>
+struct HiraganaAlphabet
+{
+  static constexpr size_t kSize = kKanaAlphabetSize;
+  using Count = uint8;
+
+  static constexpr uint8 ToSymbol(const char32 ch)
+  {
+    const char32 normalized = NormalizeKanaCode(ch);
+    if (normalized == kSkipKanaCode)
+    {
+      return AlphabetPolicy::kSkipSymbol;
+    }
+    if (normalized < KanaTableDetail::kHiraganaFirst || KanaTableDetail::kHiraganaLast < normalized)
+    {
+      return AlphabetPolicy::kInvalidSymbol;
+    }
+
+    return kSymbolTable[normalized - KanaTableDetail::kHiraganaFirst];
+  }
+
+  static constexpr char32 FromSymbol(const uint8 id)
+  {
+    return KanaTableDetail::kKanaAlphabet[id];
+  }
+
+private:
+  /// <summary>
+  /// 正規化後の文字のひらがなブロック内オフセット -> 記号番号
+  /// </summary>
+  static constexpr auto kSymbolTable = []()
+  {
+    std::array<uint8, KanaTableDetail::kHiraganaLast - KanaTableDetail::kHiraganaFirst + 1> table{};
+    table.fill(AlphabetPolicy::kInvalidSymbol);
+
+    for (size_t i = 0; i < kKanaAlphabetSize; ++i)
+    {
+      table[KanaTableDetail::kKanaAlphabet[i] - KanaTableDetail::kHiraganaFirst] = static_cast<uint8>(i);
+    }
+
+    return table;
+  }();
+};
+
+/// <summary>
+/// カタカナ。ひらがなと同じ規則で正規化し、記号番号もひらがなと共通にする（ヴ・ヵ・ヶ も含む）。
+/// </summary>
+struct KatakanaAlphabet
+{
+  static constexpr size_t kSize = kKanaAlphabetSize;
+  using Count = uint8;
+
+  static constexpr uint8 ToSymbol(const char32 ch)
+  {
+    // カタカナブロック（U+30A1～U+30F6）はひらがなブロックと同じ並びなので、ずらしてひらがなの規則を使う。
+    if (kKatakanaFirst <= ch && ch <= kKatakanaLast)
+    {
+      return HiraganaAlphabet::ToSymbol(ch - kKatakanaFirst + KanaTableDetail::kHiraganaFirst);
+    }
+    return (NormalizeKanaCode(ch) == kSkipKanaCode) ? AlphabetPolicy::kSkipSymbol : AlphabetPolicy::kInvalidSymbol;
+  }
+
+  static constexpr char32 FromSymbol(const uint8 id)
+  {
+    return KanaTableDetail::kKanaAlphabet[id] - KanaTableDetail::kHiraganaFirst + kKatakanaFirst;
+  }
+
+private:
+  static constexpr char32 kKatakanaFirst = U'ァ';
+  static constexpr char32 kKatakanaLast = U'ヶ';
+};
+
+/// <summary>
+/// ラテン文字 A～Z（英語版イベント用）。小文字・全角は大文字に集約し、ハイフン・アポストロフィ・空白は読み飛ばす。
+/// </summary>
+struct LatinAlphabet
+{
+  static constexpr size_t kSize = 26;
+  using Count = uint8;
+
+  static constexpr uint8 ToSymbol(const char32 ch)
+  {
+    if (U'A' <= ch && ch <= U'Z')
+    {
+      return static_cast<uint8>(ch - U'A');
+    }
+    if (U'a' <= ch && ch <= U'z')
+    {
+      return static_cast<uint8>(ch - U'a');
+    }
+    if (U'Ａ' <= ch && ch <= U'Ｚ')
+    {
+      return static_cast<uint8>(ch - U'Ａ');
+    }
+    if (U'ａ' <= ch && ch <= U'ｚ')
+    {
+      return static_cast<uint8>(ch - U'ａ');
+    }
+
+    switch (ch)
+    {
+    case U'-':
+    case U'\'':
+    case U' ':
+      return AlphabetPolicy::kSkipSymbol;
+    default:
+      return AlphabetPolicy::kInvalidSymbol;
+    }
+  }
+
+  static constexpr char32 FromSymbol(const uint8 id)
+  {
+    return static_cast<char32>(U'A' + id);
+  }
+};
@@ -0,0 +1,203 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "./AlphabetPolicy.h"
+
+/// <summary>
+/// 文字種の規則（AlphabetPolicy.h のポリシー）を型引数に取るヒット・リーチ判定器。
+/// 文字数は Alphabet::kSize 要素の固定長配列で数えるため、比較ループの回数がコンパイル時に決まり、
+/// 文字種ごとの仮想関数やハッシュマップを使わずに済む。
+/// </summary>
+/// <remarks>
+/// ひらがなの高速な索引（DictionaryIndex と各バックエンド）は KanaId を前提にしているため、
+/// ここではそれ以外の文字種でも使える基本の判定だけを提供する。
+/// </remarks>
+template <class Alphabet>
+class AlphabetWordEngine
+{
+public:
+  using Count = typename Alphabet::Count;
+  using Counts = std::array<Count, Alphabet::kSize>;
+
+  /// <summary>
+  /// 辞書から単語ごとの文字数を前計算する。
+  /// </summary>
+  /// <exception cref="std::invalid_argument">アルファベット外の文字を含む単語がある場合。</exception>
+  explicit AlphabetWordEngine(const Array<String>& dictionary)
+  {
+    words_.reserve(dictionary.size());
+    counts_.reserve(dictionary.size());
+
+    for (const auto& word : dictionary)
+    {
+      Counts counts{};
+
+      for (const char32 ch : word)
+      {
+        const uint8 symbol = Alphabet::ToSymbol(ch);
+        if (symbol == AlphabetPolicy::kSkipSymbol)
+        {
+          continue;
+        }
+        if (symbol == AlphabetPolicy::kInvalidSymbol)
+        {
+          throw std::invalid_argument("dictionary words must consist of the alphabet of the engine only.");
+        }
+
+        IncrementSaturated(counts[symbol]);
+      }
+
+      words_ << word;
+      counts_ << counts;
+    }
+  }
+
+  /// <summary>
+  /// 登録されている単語数を返す。
+  /// </summary>
+  size_t GetWordCount() const { return words_.size(); }
+
+  /// <summary>
+  /// 辞書に記載されている表記のまま単語を返す。
+  /// </summary>
+  const String& GetWord(size_t index) const { return words_[index]; }
+
+  /// <summary>
+  /// 単語を組み立てるのに必要な、正規化後の記号ごとの個数を返す。
+  /// </summary>
+  const Counts& GetCounts(size_t index) const { return counts_[index]; }
+
+  /// <summary>
+  /// ブロック一覧から手持ちの記号数を数える。アルファベット外の文字は無視する。
+  /// </summary>
+  static Counts CountBlocks(const Array<String>& blocks)
+  {
+    Counts counts{};
+
+    for (const auto& token : blocks)
+    {
+      for (const char32 ch : token)
+      {
+        if (const uint8 symbol = Alphabet::ToSymbol(ch); symbol < Alphabet::kSize)
+        {
+          IncrementSaturated(counts[symbol]);
+        }
+      }
+    }
+
+    return counts;
+  }
+
+  /// <summary>
+  /// ブロックだけで完全に組み立てられる単語を辞書順で返す。BlockManager::GetHitWords と同じ規則。
+  /// </summary>
+  Array<String> GetHitWords(const Array<String>& blocks) const
+  {
+    const Counts held = CountBlocks(blocks);
+    Array<String> result;
+
+    for (size_t i = 0; i < counts_.size(); ++i)
+    {
+      if (CountDeficit(counts_[i], held) == 0)
+      {
+        result << words_[i];
+      }
+    }
+
+    return result;
+  }
+
+  /// <summary>
+  /// あと1文字で完成する単語と、足りない文字（辞書の表記に合わせた1文字）を辞書順で返す。
+  /// BlockManager::GetReachWords と同じ規則。
+  /// </summary>
+  Array<std::pair<String, String>> GetReachWords(const Array<String>& blocks) const
+  {
+    const Counts held = CountBlocks(blocks);
+    Array<std::pair<String, String>> result;
+
+    for (size_t i = 0; i < counts_.size(); ++i)
+    {
+      if (CountDeficit(counts_[i], held) == 1)
+      {
+        result.emplace_back(words_[i], GetMissingCharacter(i, held));
+      }
+    }
+
+    return result;
+  }
+
+private:
+  static void IncrementSaturated(Count& value)
+  {
+    if (value < std::numeric_limits<Count>::max())
+    {
+      ++value;
+    }
+  }
+
+  /// <summary>
+  /// 不足数（必要数が手持ちを上回る分の合計）を数える。回数は Alphabet::kSize で固定。
+  /// </summary>
+  static int32 CountDeficit(const Counts& required, const Counts& held)
+  {
+    int32 deficit = 0;
+
+    for (size_t i = 0; i < Alphabet::kSize; ++i)
+    {
+      const int32 diff = static_cast<int32>(required[i]) - static_cast<int32>(held[i]);
+      deficit += (diff > 0) ? diff : 0;
+    }
+
+    return deficit;
+  }
+
+  /// <summary>
+  /// リーチ状態の単語について、手持ちの数を使い切った次の出現位置の元の文字を返す。
+  /// </summary>
+  String GetMissingCharacter(const size_t index, const Counts& held) const
+  {
+    Counts remaining = held;
+
+    for (const char32 ch : words_[index])
+    {
+      const uint8 symbol = Alphabet::ToSymbol(ch);
+      if (symbol >= Alphabet::kSize)
+      {
+        continue;
+      }
+
+      if (remaining[symbol] == 0)
+      {
+        return String(1, ch);
+      }
+
+      --remaining[symbol];
+    }
+
+    return String{};
+  }
+
+  Array<String> words_;
+  Array<Counts> counts_;
+};
+
+/// <summary>
+/// ひらがな用の判定器
+/// </summary>
+using HiraganaWordEngine = AlphabetWordEngine<HiraganaAlphabet>;
+
+/// <summary>
+/// カタカナ用の判定器
+/// </summary>
+using KatakanaWordEngine = AlphabetWordEngine<KatakanaAlphabet>;
+
+/// <summary>
+/// ラテン文字 A～Z 用の判定器
+/// </summary>
+using LatinWordEngine = AlphabetWordEngine<LatinAlphabet>;
@@ -0,0 +1,115 @@
+﻿#include "./AnagramIndex.h"
+#include "./DictionaryIndex.h"
+
+#include <algorithm>
+
+AnagramIndex::AnagramIndex() = default;
+
+AnagramIndex::AnagramIndex(const DictionaryIndex& index)
+{
+  // 署名ごとに単語をまとめ、同じ署名の単語が辞書順で連続するよう並べる。
+  Array<std::pair<uint64, uint32>> entries;
+  entries.reserve(index.GetWordCount());
+
+  for (size_t word = 0; word < index.GetWordCount(); ++word)
+  {
+    if (const auto signature = MakeSignature(index.GetCounts(word)))
+    {
+      entries.emplace_back(*signature, static_cast<uint32>(word));
+    }
+    else
+    {
+      long_words_ << static_cast<uint32>(word);
+    }
+  }
+
+  std::sort(entries.begin(), entries.end());
+
+  class_words_.reserve(entries.size());
+  for (const auto& [signature, word] : entries)
+  {
+    auto [it, inserted] = classes_.try_emplace(signature, AnagramClass{ static_cast<uint32>(class_words_.size()), 0 });
+    ++(it->second.size);
+    class_words_ << word;
+  }
+}
+
+bool AnagramIndex::CollectHits(const DictionaryIndex& index, const KanaCounts& held, Array<uint32>& hits) const
+{
+  if (CountSubMultisets(held, kMaxProbeCount) > kMaxProbeCount)
+  {
+    return false;
+  }
+
+  const size_t first = hits.size();
+
+  ForEachSubSignature(held, [&](const uint64 signature)
+  {
+    if (const auto it = classes_.find(signature); it != classes_.end())
+    {
+      const AnagramClass& anagramClass = it->second;
+      hits.insert(hits.end(), class_words_.begin() + anagramClass.offset, class_words_.begin() + anagramClass.offset + anagramClass.size);
+    }
+  });
+
+  // 署名に収まらない長い単語は、文字数を直接比較する。
+  for (const uint32 word : long_words_)
+  {
+    const KanaCounts& required = index.GetCounts(word);
+    if (std::equal(required.begin(), required.end(), held.begin(), [](const uint8 r, const uint8 h) { return r <= h; }))
+    {
+      hits.push_back(word);
+    }
+  }
+
+  std::sort(hits.begin() + first, hits.end());
+  return true;
+}
+
+std::span<const uint32> AnagramIndex::FindWords(const uint64 signature) const
+{
+  const auto it = classes_.find(signature);
+  if (it == classes_.end())
+  {
+    return {};
+  }
+
+  return std::span<const uint32>(class_words_.data() + it->second.offset, it->second.size);
+}
+
+Optional<uint64> AnagramIndex::MakeSignature(const KanaCounts& counts)
+{
+  uint64 signature = 0;
+  size_t length = 0;
+
+  for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+  {
+    for (size_t i = 0; i < counts[id]; ++i)
+    {
+      if (++length > kMaxSignatureLength)
+      {
+        return none;
+      }
+
+      signature = AppendSymbol(signature, static_cast<KanaId>(id));
+    }
+  }
+
+  return signature;
+}
+
+size_t AnagramIndex::CountSubMultisets(const KanaCounts& held, const size_t limit)
+{
+  size_t count = 1;
+
+  for (const uint8 h : held)
+  {
+    count *= (static_cast<size_t>(h) + 1);
+    if (count > limit)
+    {
+      return limit + 1;
+    }
+  }
+
+  return count;
+}
@@ -0,0 +1,148 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./KanaTable.h"
+
+#include <span>
+
+class DictionaryIndex;
+
+/// <summary>
+/// 正規化後の文字を昇順に並べた「署名」をキーに、同じ文字の組み合わせ（アナグラム）の単語をまとめたハッシュ表。
+/// 手持ちの部分多重集合を列挙して署名を引くことで、辞書の大きさによらずヒット単語を求められる。
+/// 手持ちが max_string_ = 7 文字なら、部分多重集合は高々 2^7 = 128 通り。
+/// </summary>
+class AnagramIndex
+{
+public:
+  /// <summary>
+  /// ハッシュ表に登録する単語の最大長。署名は 1 文字 6 ビットで uint64 に詰めるため 10 文字まで。
+  /// これより長い単語は別の一覧に置き、都度文字数を比較する。
+  /// </summary>
+  static constexpr size_t kMaxSignatureLength = 10;
+
+  /// <summary>
+  /// 1 回の問い合わせで引く部分多重集合の上限。超える場合は CollectHits が false を返す。
+  /// </summary>
+  static constexpr size_t kMaxProbeCount = 4096;
+
+  AnagramIndex();
+
+  /// <summary>
+  /// 辞書索引からハッシュ表を構築する。
+  /// </summary>
+  explicit AnagramIndex(const DictionaryIndex& index);
+
+  /// <summary>
+  /// 手持ちの部分多重集合を列挙してヒット単語を集め、昇順（辞書順）で末尾に追加する。
+  /// </summary>
+  /// <param name="index">構築に使った辞書索引（長い単語の判定に使う）。</param>
+  /// <param name="held">手持ちブロックの文字数。</param>
+  /// <param name="hits">ヒットした単語番号の追加先。</param>
+  /// <returns>
+  /// 部分多重集合が kMaxProbeCount を超えるなど、この索引で判定しなかった場合は false（hits は変更しない）。
+  /// </returns>
+  bool CollectHits(const DictionaryIndex& index, const KanaCounts& held, Array<uint32>& hits) const;
+
+  /// <summary>
+  /// 署名が一致する単語（ちょうどその文字の組み合わせでできる単語）の番号を辞書順で返す。なければ空。
+  /// 長さが kMaxSignatureLength を超える単語は含まれない。
+  /// </summary>
+  std::span<const uint32> FindWords(uint64 signature) const;
+
+  /// <summary>
+  /// 文字数から署名を作る。長さが kMaxSignatureLength を超える場合は none。
+  /// </summary>
+  static Optional<uint64> MakeSignature(const KanaCounts& counts);
+
+  /// <summary>
+  /// 手持ちの部分多重集合の数（文字ごとの「手持ち数 + 1」の積）を返す。上限を超えたら limit + 1 で打ち切る。
+  /// </summary>
+  static size_t CountSubMultisets(const KanaCounts& held, size_t limit);
+
+  /// <summary>
+  /// 署名の末尾に文字を1つ追加する。昇順に追加すれば同じ多重集合は必ず同じ値になる。
+  /// 1 文字 6 ビットに KanaId + 1（1 ～ 48）を入れるので、空の署名は 0 になる。
+  /// </summary>
+  static constexpr uint64 AppendSymbol(const uint64 signature, const KanaId id)
+  {
+    return (signature << 6) | static_cast<uint64>(id + 1);
+  }
+
+  /// <summary>
+  /// 手持ちの部分多重集合のうち長さ kMaxSignatureLength 以下のものを列挙し、署名ごとに visit を呼ぶ。
+  /// 呼び出し側で CountSubMultisets を使って列挙数を確認しておくこと。
+  /// </summary>
+  template <class Visitor>
+  static void ForEachSubSignature(const KanaCounts& held, Visitor&& visit)
+  {
+    SubMultisetLanes lanes;
+    for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+    {
+      if (held[id] > 0)
+      {
+        lanes.ids[lanes.size] = static_cast<KanaId>(id);
+        lanes.counts[lanes.size] = held[id];
+        ++lanes.size;
+      }
+    }
+
+    EnumerateSignatures(lanes, 0, 0, 0, visit);
+  }
+
+private:
+  /// <summary>
+  /// 部分多重集合の列挙で使う状態
+  /// </summary>
+  struct SubMultisetLanes
+  {
+    KanaId ids[kKanaAlphabetSize];
+    uint8 counts[kKanaAlphabetSize];
+    size_t size = 0;
+  };
+
+  /// <summary>
+  /// lane 番目以降の文字について、それぞれ 0 ～ 手持ち数個を選ぶ組み合わせを列挙する。
+  /// </summary>
+  template <class Visitor>
+  static void EnumerateSignatures(const SubMultisetLanes& lanes, const size_t lane, const uint64 signature, const size_t length, Visitor& visit)
+  {
+    if (lane == lanes.size)
+    {
+      visit(signature);
+      return;
+    }
+
+    uint64 extended = signature;
+    for (size_t count = 0; count <= lanes.counts[lane] && length + count <= kMaxSignatureLength; ++count)
+    {
+      EnumerateSignatures(lanes, lane + 1, extended, length + count, visit);
+      extended = AppendSymbol(extended, lanes.ids[lane]);
+    }
+  }
+
+  /// <summary>
+  /// 署名が同じ単語の一覧（class_words_ 内の範囲）
+  /// </summary>
+  struct AnagramClass
+  {
+    uint32 offset;
+    uint32 size;
+  };
+
+  /// <summary>
+  /// 署名 -> 単語の一覧
+  /// </summary>
+  HashTable<uint64, AnagramClass> classes_;
+
+  /// <summary>
+  /// 同じ署名の単語が連続するように並べた単語番号
+  /// </summary>
+  Array<uint32> class_words_;
+
+  /// <summary>
+  /// 署名に収まらない長い単語の番号
+  /// </summary>
+  Array<uint32> long_words_;
+};
@@ -1,5 +1,13 @@
 ﻿#include "./BlockManager.h"
-
+#include "./DictionaryIndex.h"
+#include "./KanaAliasTable.h"
+#include "./KanaTable.h"
+#include "./PackedDictionary.h"
+#include "./WordMatchKernel.h"
+#include "./WorkerPool.h"
+
+#include <algorithm>
+#include <functional>
 #include <unordered_map>
 #include <stdexcept>
 
@@ -7,49 +15,6 @@ namespace
 {
   using FrequencyTable = std::unordered_map<char32, int32>;
 
-  /// <summary>
-  /// ひらがな1文字をゲーム内ルールに沿って正規化する。
-  /// ・濁点／半濁点付き文字は清音へ集約
-  /// ・小書き文字は通常サイズへ置換
-  /// ・長音記号は完全に無視（= none を返す）
-  /// </summary>
-  /// <param name="ch">入力された1文字</param>
-  /// <returns>正規化後の文字。長音記号の場合は none。</returns>
-  Optional<char32> NormalizeKanaChar(const char32 ch)
-  {
-    switch (ch)
-    {
-    case U'ー': // 一般的な長音符号
-    case U'－': // 全角ハイフン（長音として扱う）
-    case U'―': // ダッシュ（長音扱い）
-      return none;
-    default:
-      break;
-    }
-
-    static const std::unordered_map<char32, char32> kNormalizationMap = {
-      // 小書き文字 -> 通常字
-      { U'ぁ', U'あ' }, { U'ぃ', U'い' }, { U'ぅ', U'う' }, { U'ぇ', U'え' }, { U'ぉ', U'お' },
-      { U'っ', U'つ' }, { U'ゃ', U'や' }, { U'ゅ', U'ゆ' }, { U'ょ', U'よ' }, { U'ゎ', U'わ' },
-      { U'ゕ', U'か' }, { U'ゖ', U'け' },
-
-      // 濁点・半濁点付き文字 -> 清音
-      { U'が', U'か' }, { U'ぎ', U'き' }, { U'ぐ', U'く' }, { U'げ', U'け' }, { U'ご', U'こ' },
-      { U'ざ', U'さ' }, { U'じ', U'し' }, { U'ず', U'す' }, { U'ぜ', U'せ' }, { U'ぞ', U'そ' },
-      { U'だ', U'た' }, { U'ぢ', U'ち' }, { U'づ', U'つ' }, { U'で', U'て' }, { U'ど', U'と' },
-      { U'ば', U'は' }, { U'び', U'ひ' }, { U'ぶ', U'ふ' }, { U'べ', U'へ' }, { U'ぼ', U'ほ' },
-      { U'ぱ', U'は' }, { U'ぴ', U'ひ' }, { U'ぷ', U'ふ' }, { U'ぺ', U'へ' }, { U'ぽ', U'ほ' },
-      { U'ゔ', U'う' }
-    };
-
-    if (const auto it = kNormalizationMap.find(ch); it != kNormalizationMap.end())
-    {
-      return it->second;
-    }
-
-    return ch;
-  }
-
   /// <summary>
   /// 文字列配列から各文字の出現回数テーブルを構築する。
   /// ブロック（複数文字が含まれる可能性）を一括で処理する際に利用。
@@ -131,6 +96,55 @@ namespace
     // （辞書に想定外の表記が含まれていたケースのフォールバック）
     return String(1, missingNormalized);
   }
+
+  /// <summary>
+  /// 索引済みの単語について、手持ちで賄えない文字数の合計（不足数）を求める。
+  /// 固定長・分岐なしのループにしてあるため、コンパイラによるベクトル化が効く。
+  /// </summary>
+  int32 CountDeficit(const KanaCounts& required, const KanaCounts& held)
+  {
+    int32 deficit = 0;
+
+    for (size_t i = 0; i < kKanaAlphabetSize; ++i)
+    {
+      const int32 diff = static_cast<int32>(required[i]) - static_cast<int32>(held[i]);
+      deficit += (diff > 0) ? diff : 0;
+    }
+
+    return deficit;
+  }
+
+  /// <summary>
+  /// 走査型の実装（kScalar / kSimd）で [begin, end) の単語を判定する。
+  /// </summary>
+  void ScanRange(const BlockManager::MatchBackend scanBackend, const DictionaryIndex& index, const KanaCounts& held, const size_t begin, const size_t end, Array<uint32>* hits, Array<uint32>* reaches)
+  {
+    if (scanBackend == BlockManager::MatchBackend::kSimd)
+    {
+      WordMatchKernel::CollectMatches(index, held, begin, end, hits, reaches);
+      return;
+    }
+
+    // 単語ごとに固定幅の行を比較する基本実装。
+    for (size_t i = begin; i < end; ++i)
+    {
+      if (index.IsRemoved(i))
+      {
+        continue;
+      }
+
+      const int32 deficit = CountDeficit(index.GetCounts(i), held);
+
+      if (hits && deficit == 0)
+      {
+        hits->push_back(static_cast<uint32>(i));
+      }
+      else if (reaches && deficit == 1)
+      {
+        reaches->push_back(static_cast<uint32>(i));
+      }
+    }
+  }
 } // namespace
 
 BlockManager::BlockManager() = default;
@@ -210,100 +224,374 @@ Array<std::pair<String, String>> BlockManager::GetReachWords(const Array<String>
   return result;
 }
 
-Array<Array<String>> BlockManager::GenerateBlockGrid(const int32 row, const int32 column, const int32 batchSize, const Array<String>& dictionary) const
+Array<String> BlockManager::GetHitWords(const Array<String>& blocks, const DictionaryIndex& index) const
 {
-  Array<Array<String>> grid;
+  const KanaCounts held = DictionaryIndex::CountBlocks(blocks);
 
-  // 生成条件が満たされない場合は空配列を返却する（早期リターン）。
-  if (row <= 0 || column <= 0 || batchSize <= 0 || dictionary.isEmpty())
+  Array<uint32> hitIds;
+  CollectMatchIds(index, held, &hitIds, nullptr);
+
+  Array<String> result;
+  result.reserve(hitIds.size());
+
+  for (const uint32 id : hitIds)
   {
-    return grid;
+    result << String{ index.GetWord(id) };
   }
 
-  const int32 requiredSize = row * column;
-  if (requiredSize % batchSize != 0)
+  return result;
+}
+
+Array<std::pair<String, String>> BlockManager::GetReachWords(const Array<String>& blocks, const DictionaryIndex& index) const
+{
+  const KanaCounts held = DictionaryIndex::CountBlocks(blocks);
+
+  // 削除近傍の表からは足りない文字も一緒に求まるので、単語ごとの数え直しを省く。
+  if (ResolveBackend(index) == MatchBackend::kAnagram)
   {
-    throw std::invalid_argument("row * column must be a multiple of batchSize.");
+    Array<DeletionIndex::Reach> found;
+    if (index.GetDeletionIndex().CollectReaches(index, held, found))
+    {
+      Array<std::pair<String, String>> result;
+      result.reserve(found.size());
+
+      for (const auto& reach : found)
+      {
+        result.emplace_back(String{ index.GetWord(reach.word) }, String(1, reach.character));
+      }
+
+      return result;
+    }
   }
 
-  // 抽出した文字を一次元で蓄えるバッファ。後で二次元配列へ整形する。
-  Array<String> candidateChars;
-  candidateChars.reserve(requiredSize);
+  Array<uint32> reachIds;
+  CollectMatchIds(index, held, nullptr, &reachIds);
 
-  // 辞書語を都度シャッフルして利用するためのバッファと、一度のループで使用する語リスト。
-  Array<String> shuffledWords = dictionary;
-  Array<String> wordCandidates;
+  Array<std::pair<String, String>> result;
+  result.reserve(reachIds.size());
 
-  // 必要な文字数を満たすまで辞書語をシャッフルしながら候補文字を追加していく。
-  while (candidateChars.size() < requiredSize)
+  for (const uint32 id : reachIds)
   {
-    shuffledWords.shuffle();
-    wordCandidates.clear();
+    const KanaId missing = index.FindMissingKana(id, held);
+    result.emplace_back(String{ index.GetWord(id) }, index.GetMissingCharacter(id, missing, held));
+  }
 
-    int32 accumulated = 0;
+  return result;
+}
+
+Array<String> BlockManager::GetHitWords(const Array<String>& blocks, const PackedDictionary& dictionary) const
+{
+  Array<uint32> hitIds;
+  dictionary.CollectMatches(DictionaryIndex::CountBlocks(blocks), &hitIds, nullptr);
+
+  Array<String> result;
+  result.reserve(hitIds.size());
+
+  for (const uint32 id : hitIds)
+  {
+    result << dictionary.GetWord(id);
+  }
+
+  return result;
+}
+
+Array<std::pair<String, String>> BlockManager::GetReachWords(const Array<String>& blocks, const PackedDictionary& dictionary) const
+{
+  const KanaCounts held = DictionaryIndex::CountBlocks(blocks);
+
+  Array<uint32> reachIds;
+  dictionary.CollectMatches(held, nullptr, &reachIds);
+
+  Array<std::pair<String, String>> result;
+  result.reserve(reachIds.size());
+
+  for (const uint32 id : reachIds)
+  {
+    result.emplace_back(dictionary.GetWord(id), dictionary.GetMissingCharacter(id, held));
+  }
 
-    // batchSize に到達するまで辞書語を積み上げて候補リストに加える。
-    for (const auto& word : shuffledWords)
+  return result;
+}
+
+void BlockManager::QueryMatches(const Array<String>& blocks, const DictionaryIndex& index, WordMatchBuffers& buffers, const bool pickHint) const
+{
+  QueryMatches(DictionaryIndex::CountBlocks(blocks), index, buffers, pickHint);
+}
+
+void BlockManager::QueryMatches(const KanaCounts& held, const DictionaryIndex& index, WordMatchBuffers& buffers, const bool pickHint) const
+{
+  buffers.Clear();
+  CollectMatchIds(index, held, &buffers.hit_ids, &buffers.reach_ids);
+  FillReachDetails(index, held, buffers, pickHint);
+}
+
+void BlockManager::FillReachDetails(const DictionaryIndex& index, const KanaCounts& held, WordMatchBuffers& buffers, const bool pickHint)
+{
+  buffers.reach_missing.resize(buffers.reach_ids.size());
+
+  for (size_t i = 0; i < buffers.reach_ids.size(); ++i)
+  {
+    buffers.reach_missing[i] = index.FindMissingKana(buffers.reach_ids[i], held);
+
+    // リザーバサンプリング：i 件目を 1 / (i + 1) の確率で選び直すと、全件から一様に1件選んだことになる。
+    if (pickHint && Random(uint64{ 0 }, static_cast<uint64>(i)) == 0)
     {
-      wordCandidates << word;
-      accumulated += static_cast<int32>(word.size());
+      buffers.hint = i;
+    }
+  }
+}
 
-      if (accumulated >= batchSize)
-      {
-        break;
-      }
+Array<BlockManager::MissingWord> BlockManager::GetWordsWithinMissing(const Array<String>& blocks, const DictionaryIndex& index, const int32 maxMissing) const
+{
+  if (maxMissing < 0)
+  {
+    return {};
+  }
+
+  const KanaCounts held = DictionaryIndex::CountBlocks(blocks);
+
+  size_t heldTotal = 0;
+  for (const uint8 count : held)
+  {
+    heldTotal += count;
+  }
+
+  // 長さが 手持ち + maxMissing を超える単語は、不足数も必ず maxMissing を超える。
+  Array<uint32> ids;
+  for (const uint32 id : index.GetWordsUpToLength(heldTotal + static_cast<size_t>(maxMissing)))
+  {
+    const KanaCounts& required = index.GetCounts(id);
+    int32 deficit = 0;
+
+    for (size_t i = 0; i < kKanaAlphabetSize && deficit <= maxMissing; ++i)
+    {
+      deficit += std::max(static_cast<int32>(required[i]) - static_cast<int32>(held[i]), 0);
     }
 
-    if (wordCandidates.isEmpty())
+    if (deficit <= maxMissing)
     {
-      // 辞書が空、または有効な語を取得できない場合は処理を終了する。
-      break;
+      ids << id;
     }
+  }
 
-    // 候補語自体をシャッフルし、元となる単語の順序を均一化する。
-    wordCandidates.shuffle();
+  std::sort(ids.begin(), ids.end());
 
-    // 各候補語の文字を 1 文字ずつ取り出して候補文字リストに格納。
-    Array<String> charBatch;
-    charBatch.reserve(accumulated);
+  Array<MissingWord> result;
+  result.reserve(ids.size());
 
-    for (const auto& word : wordCandidates)
+  for (const uint32 id : ids)
+  {
+    result << MissingWord{ String{ index.GetWord(id) }, index.GetMissingCharacters(id, held) };
+  }
+
+  return result;
+}
+
+BlockManager::MatchBackend BlockManager::ResolveBackend(const DictionaryIndex& index) const
+{
+  if (index.IsPatched() && (backend_ == MatchBackend::kBitset || backend_ == MatchBackend::kAnagram))
+  {
+    return MatchBackend::kSimd;
+  }
+
+  return backend_;
+}
+
+void BlockManager::CollectMatchIds(const DictionaryIndex& index, const KanaCounts& held, Array<uint32>* hits, Array<uint32>* reaches) const
+{
+  const MatchBackend backend = ResolveBackend(index);
+
+  switch (backend)
+  {
+  case MatchBackend::kBitset:
+    index.GetBitsetIndex().CollectMatches(held, hits, reaches);
+    return;
+  case MatchBackend::kAnagram:
+    // 手持ちが多すぎて部分多重集合を列挙しきれない場合は SIMD 走査に任せる。
+    if (hits && !index.GetAnagramIndex().CollectHits(index, held, *hits))
     {
-      for (const char32 ch : word)
+      ScanMatchIds(MatchBackend::kSimd, index, held, hits, nullptr);
+    }
+    if (reaches)
+    {
+      if (!index.GetDeletionIndex().CollectReaches(index, held, *reaches))
       {
-        if (const auto normalized = NormalizeKanaChar(ch))
-        {
-          charBatch << String(1, *normalized);
-        }
+        ScanMatchIds(MatchBackend::kSimd, index, held, nullptr, reaches);
       }
     }
+    return;
+  case MatchBackend::kScalar:
+  case MatchBackend::kSimd:
+  default:
+    ScanMatchIds(backend, index, held, hits, reaches);
+    return;
+  }
+}
 
-    charBatch.shuffle();
+void BlockManager::ScanMatchIds(const MatchBackend scanBackend, const DictionaryIndex& index, const KanaCounts& held, Array<uint32>* hits, Array<uint32>* reaches) const
+{
+  const size_t wordCount = index.GetWordCount();
 
-    for (const auto& ch : charBatch)
+  if (wordCount < parallel_scan_.min_word_count)
+  {
+    ScanRange(scanBackend, index, held, 0, wordCount, hits, reaches);
+    return;
+  }
+
+  // 辞書をキャッシュに収まる大きさの区間に分けてワーカーで走査し、区間順に連結して辞書順を保つ。
+  const size_t alignment = DictionaryIndex::kColumnAlignment;
+  const size_t shardSize = std::max<size_t>((parallel_scan_.shard_word_count + alignment - 1) / alignment * alignment, alignment);
+  const size_t shardCount = (wordCount + shardSize - 1) / shardSize;
+
+  Array<Array<uint32>> shardHits(hits ? shardCount : 0);
+  Array<Array<uint32>> shardReaches(reaches ? shardCount : 0);
+
+  WorkerPool::GetInstance()->ParallelFor(shardCount, [&](const size_t shard)
+  {
+    const size_t begin = shard * shardSize;
+    const size_t end = std::min(begin + shardSize, wordCount);
+    ScanRange(scanBackend, index, held, begin, end, hits ? &shardHits[shard] : nullptr, reaches ? &shardReaches[shard] : nullptr);
+  });
+
+  for (size_t shard = 0; shard < shardCount; ++shard)
+  {
+    if (hits)
     {
-      candidateChars << ch;
+      hits->insert(hits->end(), shardHits[shard].begin(), shardHits[shard].end());
+    }
+    if (reaches)
+    {
+      reaches->insert(reaches->end(), shardReaches[shard].begin(), shardReaches[shard].end());
+    }
+  }
+}
 
-      if (candidateChars.size() >= requiredSize)
+Array<Array<KanaId>> BlockManager::GenerateKanaGrid(const int32 row, const int32 column, const int32 batchSize, const Array<String>& dictionary) const
+{
+  return SampleKanaGrid(row, column, batchSize, dictionary.size(), [&dictionary](const uint32 word, Array<KanaId>& charBatch)
+  {
+    // 各語の文字を 1 文字ずつ取り出して候補文字リストに格納。
+    for (const char32 ch : dictionary[word])
+    {
+      if (const KanaId id = ToKanaId(NormalizeKanaCode(ch)); id != kInvalidKanaId)
       {
-        // 必要数を満たしたら即座に外側のループへ抜ける。
-        break;
+        charBatch << id;
       }
     }
+    return static_cast<int32>(dictionary[word].size());
+  });
+}
+
+Array<Array<KanaId>> BlockManager::GenerateKanaGrid(const int32 row, const int32 column, const int32 batchSize, const DictionaryIndex& index) const
+{
+  return SampleKanaGrid(row, column, batchSize, index.GetWordCount(), [&index](const uint32 word, Array<KanaId>& charBatch)
+  {
+    if (index.IsRemoved(word))
+    {
+      return 0;
+    }
 
-    if (candidateChars.size() >= requiredSize)
+    // バッチ内の文字は後でシャッフルするので、単語中の順番は要らない。文字数の表から直接並べる。
+    const KanaCounts& counts = index.GetCounts(word);
+    for (size_t id = 0; id < kKanaAlphabetSize; ++id)
     {
+      charBatch.insert(charBatch.end(), counts[id], static_cast<KanaId>(id));
+    }
+    return static_cast<int32>(index.GetLength(word));
+  });
+}
+
+Array<Array<KanaId>> BlockManager::SampleKanaGrid(const int32 row, const int32 column, const int32 batchSize, const size_t dictionarySize, const std::function<int32(uint32, Array<KanaId>&)>& appendWord)
+{
+  // 生成条件が満たされない場合は空配列を返却する（早期リターン）。
+  if (row <= 0 || column <= 0 || batchSize <= 0 || dictionarySize == 0)
+  {
+    return {};
+  }
+
+  const int32 requiredSize = row * column;
+  if (requiredSize % batchSize != 0)
+  {
+    throw std::invalid_argument("row * column must be a multiple of batchSize.");
+  }
+
+  // 抽出した文字を一次元で蓄えるバッファ。後で二次元配列へ整形する。
+  Array<KanaId> candidateChars;
+  candidateChars.reserve(requiredSize);
+
+  // 辞書語は部分 Fisher–Yates で非復元抽出する。辞書をコピー・全体シャッフルする代わりに、
+  // 入れ替えた位置だけをハッシュ表に記録するので、1 回の抽出は辞書の大きさによらず O(1) になる。
+  const uint32 wordCount = static_cast<uint32>(dictionarySize);
+  HashTable<uint32, uint32> swappedPositions;
+  const auto positionAt = [&](const uint32 position)
+  {
+    const auto it = swappedPositions.find(position);
+    return (it == swappedPositions.end()) ? position : it->second;
+  };
+
+  Array<KanaId> charBatch;
+
+  // 必要な文字数を満たすまで、バッチごとに辞書語を抽出して候補文字を追加していく。
+  while (candidateChars.size() < static_cast<size_t>(requiredSize))
+  {
+    swappedPositions.clear();
+    charBatch.clear();
+
+    int32 accumulated = 0;
+
+    // batchSize に到達するまで（または辞書を使い切るまで）、まだ選んでいない辞書語を1つずつ選ぶ。
+    for (uint32 picked = 0; picked < wordCount && accumulated < batchSize; ++picked)
+    {
+      const uint32 target = Random(picked, wordCount - 1);
+      const uint32 word = positionAt(target);
+      swappedPositions[target] = positionAt(picked);
+
+      accumulated += appendWord(word, charBatch);
+    }
+
+    if (charBatch.isEmpty())
+    {
+      // 有効な文字を取得できない場合は処理を終了する。
       break;
     }
+
+    charBatch.shuffle();
+
+    // 必要数を満たしたら、残りは捨てる。
+    const size_t taken = std::min(charBatch.size(), requiredSize - candidateChars.size());
+    candidateChars.insert(candidateChars.end(), charBatch.begin(), charBatch.begin() + taken);
+  }
+
+  return ToKanaGrid(candidateChars, row, column);
+}
+
+Array<Array<KanaId>> BlockManager::GenerateKanaGrid(const int32 row, const int32 column, const KanaAliasTable& table) const
+{
+  if (row <= 0 || column <= 0 || table.IsEmpty())
+  {
+    return {};
+  }
+
+  // マスごとに独立に、辞書での出現頻度に比例した確率で文字を選ぶ。
+  Array<KanaId> candidateChars(static_cast<size_t>(row) * column);
+  for (KanaId& id : candidateChars)
+  {
+    id = table.Sample();
   }
 
+  return ToKanaGrid(candidateChars, row, column);
+}
+
+Array<Array<KanaId>> BlockManager::ToKanaGrid(const Array<KanaId>& candidateChars, const int32 row, const int32 column)
+{
   // 候補文字リストを行列構造に再配置する。
+  Array<Array<KanaId>> grid;
   grid.reserve(row);
   size_t index = 0;
 
   for (int32 r = 0; r < row; ++r)
   {
-    Array<String> line;
+    Array<KanaId> line;
     line.reserve(column);
 
     for (int32 c = 0; c < column; ++c)
@@ -314,8 +602,8 @@ Array<Array<String>> BlockManager::GenerateBlockGrid(const int32 row, const int3
       }
       else
       {
-        // 候補が不足した場合は空文字を詰めてサイズを合わせる。
-        line << String();
+        // 候補が不足した場合は空きマスを詰めてサイズを合わせる。
+        line << kInvalidKanaId;
       }
     }
 
@@ -324,3 +612,26 @@ Array<Array<String>> BlockManager::GenerateBlockGrid(const int32 row, const int3
 
   return grid;
 }
+
+Array<Array<String>> BlockManager::GenerateBlockGrid(const int32 row, const int32 column, const int32 batchSize, const Array<String>& dictionary) const
+{
+  const Array<Array<KanaId>> kanaGrid = GenerateKanaGrid(row, column, batchSize, dictionary);
+
+  Array<Array<String>> grid;
+  grid.reserve(kanaGrid.size());
+
+  for (const auto& kanaLine : kanaGrid)
+  {
+    Array<String> line;
+    line.reserve(kanaLine.size());
+
+    for (const KanaId id : kanaLine)
+    {
+      line << GetKanaString(id);
+    }
+
+    grid << std::move(line);
+  }
+
+  return grid;
+}
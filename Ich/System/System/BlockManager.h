@@ -1,8 +1,16 @@
 ﻿#pragma once
 
 #include <Siv3D.hpp>
+#include <functional>
 #include <utility>
 
+#include "./KanaTable.h"
+#include "./WordMatchBuffers.h"
+
+class DictionaryIndex;
+class KanaAliasTable;
+class PackedDictionary;
+
 /// <summary>
 /// ひらがなブロックの集合をもとに、辞書内の単語が成立するかどうかを判定するためのユーティリティ。
 /// ゲーム中では、手元のブロックと辞書を渡すだけでヒット・リーチの抽出が行えるようにする。
@@ -10,9 +18,53 @@
 class BlockManager
 {
 public:
+  /// <summary>
+  /// DictionaryIndex を使ったヒット・リーチ判定の実装方式。結果はどの方式でも同一。
+  /// </summary>
+  enum class MatchBackend
+  {
+    kScalar,  // 単語ごとに固定幅の行を比較する
+    kSimd,    // SoA 列を SIMD でまとめて比較する（CPU に応じて AVX2 / SSE2 / スカラーを自動選択）
+    kBitset,  // (文字, 必要数の下限) ごとのビット集合を OR して求める
+    kAnagram, // 手持ちの部分多重集合の署名でハッシュ表を引く（リーチは1文字削除した署名の表を引く）
+  };
+
+  /// <summary>
+  /// 走査型の実装（kScalar / kSimd）を辞書の区間ごとに並列実行するための設定。
+  /// </summary>
+  struct ParallelScanOptions
+  {
+    size_t min_word_count = 32768;    // この単語数未満の辞書は呼び出し元スレッドだけで走査する
+    size_t shard_word_count = 16384;  // 1 区間の単語数（kColumnAlignment の倍数に切り上げる）
+  };
+
+  /// <summary>
+  /// GetWordsWithinMissing の結果1件分。
+  /// </summary>
+  struct MissingWord
+  {
+    String word;            // 単語そのもの
+    Array<String> missing;  // 足りない文字（辞書の表記に合わせた1文字ずつ、単語中の順番）
+  };
+
   BlockManager();
   ~BlockManager();
 
+  /// <summary>
+  /// 索引版の GetHitWords / GetReachWords で使う実装方式を設定する。
+  /// </summary>
+  void SetMatchBackend(MatchBackend backend) { backend_ = backend; }
+
+  /// <summary>
+  /// 索引版の GetHitWords / GetReachWords で使う実装方式を取得する。
+  /// </summary>
+  MatchBackend GetMatchBackend() const { return backend_; }
+
+  /// <summary>
+  /// 並列走査の設定を変更する。
+  /// </summary>
+  void SetParallelScanOptions(const ParallelScanOptions& options) { parallel_scan_ = options; }
+
   /// <summary>
   /// ブロックだけで完全に組み立てられる（=ヒットする）単語を抽出する。
   /// ブロックと辞書内の単語は、濁点・半濁点・小文字を区別せずに突き合わせる。
@@ -34,13 +86,147 @@ public:
   Array<std::pair<String, String>> GetReachWords(const Array<String>& blocks, const Array<String>& dictionary) const;
 
   /// <summary>
-  /// ブロックにあと1文字加えるだけで完成する（=リーチ状態の）単語を抽出する。
-  /// 足りない文字は正規化後ではなく「辞書に記載されている元の文字」を返却する。
+  /// GetHitWords の索引版。辞書語の文字数は DictionaryIndex に前計算済みのものを使うため、
+  /// 呼び出しごとのハッシュマップ構築やヒープ確保（結果配列を除く）が発生しない。
   /// </summary>
   /// <param name="blocks">現在保持しているブロック一覧。</param>
-  /// <param name="dictionary">判定対象の単語一覧。</param>
+  /// <param name="index">判定対象の辞書から構築した索引。</param>
+  /// <returns>ヒットした単語を辞書順のまま返す。</returns>
+  Array<String> GetHitWords(const Array<String>& blocks, const DictionaryIndex& index) const;
+
+  /// <summary>
+  /// GetReachWords の索引版。結果は配列版の GetReachWords と同一。
+  /// </summary>
+  /// <param name="blocks">現在保持しているブロック一覧。</param>
+  /// <param name="index">判定対象の辞書から構築した索引。</param>
   /// <returns>
   /// first: 単語そのもの / second: 足りない文字（辞書の表記に合わせた1文字）。
   /// </returns>
+  Array<std::pair<String, String>> GetReachWords(const Array<String>& blocks, const DictionaryIndex& index) const;
+
+  /// <summary>
+  /// GetHitWords の省メモリ版。6 ビットに詰めた辞書を展開せずに判定する。結果は配列版の GetHitWords と同一。
+  /// 単語ごとの文字数や SoA 列を持たないぶん辞書のメモリは小さいが、判定のたびに詰めた文字を読み直す。
+  /// </summary>
+  /// <param name="blocks">現在保持しているブロック一覧。</param>
+  /// <param name="dictionary">判定対象の辞書を詰めた表現。</param>
+  /// <returns>ヒットした単語を辞書順のまま返す。</returns>
+  Array<String> GetHitWords(const Array<String>& blocks, const PackedDictionary& dictionary) const;
+
+  /// <summary>
+  /// GetReachWords の省メモリ版。結果は配列版の GetReachWords と同一。
+  /// </summary>
+  /// <param name="blocks">現在保持しているブロック一覧。</param>
+  /// <param name="dictionary">判定対象の辞書を詰めた表現。</param>
+  /// <returns>
+  /// first: 単語そのもの / second: 足りない文字（辞書の表記に合わせた1文字）。
+  /// </returns>
+  Array<std::pair<String, String>> GetReachWords(const Array<String>& blocks, const PackedDictionary& dictionary) const;
+
+  /// <summary>
+  /// ヒット・リーチ・ヒントを1回の問い合わせでまとめて求め、呼び出し側の buffers に単語番号で書き込む。
+  /// 文字列を作らず buffers の容量を使い回すため、毎フレーム呼んでもヒープ確保が発生しない。
+  /// </summary>
+  /// <param name="blocks">現在保持しているブロック一覧。</param>
+  /// <param name="index">判定対象の辞書から構築した索引。</param>
+  /// <param name="buffers">結果の格納先。呼び出しのたびに中身を入れ替える。</param>
+  /// <param name="pickHint">true ならリーチ単語から一様に1件選び buffers.hint に入れる。</param>
+  void QueryMatches(const Array<String>& blocks, const DictionaryIndex& index, WordMatchBuffers& buffers, bool pickHint) const;
+
+  /// <summary>
+  /// QueryMatches の手持ち文字数版。
+  /// </summary>
+  void QueryMatches(const KanaCounts& held, const DictionaryIndex& index, WordMatchBuffers& buffers, bool pickHint) const;
+
+  /// <summary>
+  /// buffers.reach_ids から不足文字の ID を埋め、pickHint なら1件をリザーバサンプリングで選ぶ。
+  /// </summary>
+  static void FillReachDetails(const DictionaryIndex& index, const KanaCounts& held, WordMatchBuffers& buffers, bool pickHint);
+
+  /// <summary>
+  /// ブロックにあと maxMissing 文字まで加えれば完成する単語を抽出する（0 文字ならヒット、1 文字ならリーチ）。
+  /// 何の文字にでもなるジョーカーブロックを k 個持っている場合も、maxMissing = k で同じ判定になる。
+  /// 単語の長さが「手持ちの枚数 + maxMissing」を超えるものは、長さ順の索引で最初から候補に含めない。
+  /// </summary>
+  /// <param name="blocks">現在保持しているブロック一覧（ジョーカーは含めない）。</param>
+  /// <param name="index">判定対象の辞書から構築した索引。</param>
+  /// <param name="maxMissing">許容する不足文字数。</param>
+  /// <returns>条件を満たす単語と足りない文字を、辞書順のまま返す。</returns>
+  Array<MissingWord> GetWordsWithinMissing(const Array<String>& blocks, const DictionaryIndex& index, int32 maxMissing) const;
+
+  /// <summary>
+  /// 辞書語を分解した正規化済みの文字を、row 行 column 列のブロック配置として生成する。
+  /// 各マスは KanaId で、文字が足りない場合は kInvalidKanaId（空きマス）になる。
+  /// 辞書語はバッチごとに部分 Fisher–Yates で非復元抽出するため、辞書のコピーを作らず、計算量はマス数に比例する。
+  /// </summary>
+  /// <param name="row">行数。</param>
+  /// <param name="column">列数。</param>
+  /// <param name="batchSize">一度に分解する辞書語の文字数の目安。row * column はこの倍数であること。</param>
+  /// <param name="dictionary">配置する文字の元になる単語一覧。</param>
+  Array<Array<KanaId>> GenerateKanaGrid(int32 row, int32 column, int32 batchSize, const Array<String>& dictionary) const;
+
+  /// <summary>
+  /// GenerateKanaGrid の索引版。単語ごとの文字数の表から文字を取り出すので、辞書を String の配列にしておく必要がない。
+  /// 取り除かれた単語は使わない。バッチの大きさは表記ではなく正規化後の長さで数える。
+  /// </summary>
+  /// <param name="row">行数。</param>
+  /// <param name="column">列数。</param>
+  /// <param name="batchSize">一度に分解する辞書語の文字数の目安。row * column はこの倍数であること。</param>
+  /// <param name="index">配置する文字の元になる辞書の索引。</param>
+  Array<Array<KanaId>> GenerateKanaGrid(int32 row, int32 column, int32 batchSize, const DictionaryIndex& index) const;
+
+  /// <summary>
+  /// 別名表から1マスずつ独立に文字を選び、row 行 column 列のブロック配置として生成する（1マス O(1)）。
+  /// 単語がそのまま揃う保証はないが、文字の出現頻度は表の重み（辞書での出現回数など）に従う。
+  /// </summary>
+  /// <param name="row">行数。</param>
+  /// <param name="column">列数。</param>
+  /// <param name="table">文字を選ぶ別名表。空の表なら空配列を返す。</param>
+  Array<Array<KanaId>> GenerateKanaGrid(int32 row, int32 column, const KanaAliasTable& table) const;
+
+  /// <summary>
+  /// GenerateKanaGrid の結果を、マスごとの文字列に変換して返す。
+  /// </summary>
+  /// <param name="row">行数。</param>
+  /// <param name="column">列数。</param>
+  /// <param name="batchSize">一度に分解する辞書語の文字数の目安。row * column はこの倍数であること。</param>
+  /// <param name="dictionary">配置する文字の元になる単語一覧。</param>
   Array<Array<String>> GenerateBlockGrid(int32 row, int32 column, int32 batchSize, const Array<String>& dictionary) const;
+
+private:
+  /// <summary>
+  /// 辞書語をバッチごとに部分 Fisher–Yates で非復元抽出し、row 行 column 列の文字の配置を作る。
+  /// appendWord は単語番号の文字を charBatch の末尾に追加し、バッチの大きさとして数える文字数を返す。
+  /// </summary>
+  static Array<Array<KanaId>> SampleKanaGrid(int32 row, int32 column, int32 batchSize, size_t dictionarySize, const std::function<int32(uint32, Array<KanaId>&)>& appendWord);
+
+  /// <summary>
+  /// 一次元に並べた文字を row 行 column 列に整形する。足りないマスは kInvalidKanaId で埋める。
+  /// </summary>
+  static Array<Array<KanaId>> ToKanaGrid(const Array<KanaId>& candidateChars, int32 row, int32 column);
+
+  /// <summary>
+  /// 索引に対して実際に使う実装方式を返す。AddWord / RemoveWord で変更された索引では補助索引が古いため、SIMD 走査に切り替える。
+  /// </summary>
+  MatchBackend ResolveBackend(const DictionaryIndex& index) const;
+
+  /// <summary>
+  /// 設定中の実装方式で、ヒット（不足数 0）とリーチ（不足数 1）の単語番号を辞書順に集める。
+  /// </summary>
+  void CollectMatchIds(const DictionaryIndex& index, const KanaCounts& held, Array<uint32>* hits, Array<uint32>* reaches) const;
+
+  /// <summary>
+  /// 走査型の実装で全単語を判定する。大きな辞書は区間に分けて WorkerPool で並列に走査する。
+  /// </summary>
+  void ScanMatchIds(MatchBackend scanBackend, const DictionaryIndex& index, const KanaCounts& held, Array<uint32>* hits, Array<uint32>* reaches) const;
+
+  /// <summary>
+  /// 索引版の判定で使う実装方式
+  /// </summary>
+  MatchBackend backend_ = MatchBackend::kSimd;
+
+  /// <summary>
+  /// 並列走査の設定
+  /// </summary>
+  ParallelScanOptions parallel_scan_;
 };
@@ -0,0 +1,136 @@
+﻿#include "./DeletionIndex.h"
+#include "./AnagramIndex.h"
+#include "./DictionaryIndex.h"
+
+#include <algorithm>
+#include <tuple>
+
+DeletionIndex::DeletionIndex() = default;
+
+DeletionIndex::DeletionIndex(const DictionaryIndex& index)
+{
+  Array<std::pair<uint64, Entry>> keyed;
+
+  for (size_t word = 0; word < index.GetWordCount(); ++word)
+  {
+    const KanaCounts& counts = index.GetCounts(word);
+
+    if (index.GetLength(word) > AnagramIndex::kMaxSignatureLength + 1)
+    {
+      long_words_ << static_cast<uint32>(word);
+      continue;
+    }
+
+    // 同じ文字のどの出現を取り除いても署名は同じなので、文字の種類ごとに1項目だけ作る。
+    for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+    {
+      if (counts[id] == 0)
+      {
+        continue;
+      }
+
+      KanaCounts deleted = counts;
+      --deleted[id];
+
+      // リーチなら手持ちはちょうど counts[id] - 1 個なので、足りないのは最後の出現位置の文字になる。
+      KanaCounts held{};
+      held[id] = static_cast<uint8>(counts[id] - 1);
+      const String character = index.GetMissingCharacter(word, static_cast<KanaId>(id), held);
+
+      keyed.emplace_back(*AnagramIndex::MakeSignature(deleted), Entry{ static_cast<uint32>(word), static_cast<KanaId>(id), character.front() });
+    }
+  }
+
+  std::sort(keyed.begin(), keyed.end(), [](const auto& a, const auto& b)
+  {
+    return std::tie(a.first, a.second.word) < std::tie(b.first, b.second.word);
+  });
+
+  entries_.reserve(keyed.size());
+  for (const auto& [signature, entry] : keyed)
+  {
+    auto [it, inserted] = ranges_.try_emplace(signature, EntryRange{ static_cast<uint32>(entries_.size()), 0 });
+    ++(it->second.size);
+    entries_ << entry;
+  }
+}
+
+template <class Emit>
+bool DeletionIndex::VisitReaches(const DictionaryIndex& index, const KanaCounts& held, Emit&& emit) const
+{
+  if (AnagramIndex::CountSubMultisets(held, AnagramIndex::kMaxProbeCount) > AnagramIndex::kMaxProbeCount)
+  {
+    return false;
+  }
+
+  // 残りが手持ちに含まれる単語のうち、取り除いた文字まで手持ちで賄えるものはヒットなので除く。
+  // リーチ単語は足りない文字が1つに決まるため、同じ単語が二度見つかることはない。
+  AnagramIndex::ForEachSubSignature(held, [&](const uint64 signature)
+  {
+    if (const auto it = ranges_.find(signature); it != ranges_.end())
+    {
+      const EntryRange& range = it->second;
+      for (size_t i = range.offset; i < range.offset + range.size; ++i)
+      {
+        const Entry& entry = entries_[i];
+        if (held[entry.missing] < index.GetCounts(entry.word)[entry.missing])
+        {
+          emit(entry.word, &entry);
+        }
+      }
+    }
+  });
+
+  // 署名に収まらない長い単語は、文字数を直接比較する（足りない文字は呼び出し側で求める）。
+  for (const uint32 word : long_words_)
+  {
+    const KanaCounts& required = index.GetCounts(word);
+    int32 deficit = 0;
+
+    for (size_t id = 0; id < kKanaAlphabetSize && deficit <= 1; ++id)
+    {
+      deficit += std::max(static_cast<int32>(required[id]) - static_cast<int32>(held[id]), 0);
+    }
+
+    if (deficit == 1)
+    {
+      emit(word, nullptr);
+    }
+  }
+
+  return true;
+}
+
+bool DeletionIndex::CollectReaches(const DictionaryIndex& index, const KanaCounts& held, Array<Reach>& reaches) const
+{
+  const size_t first = reaches.size();
+
+  const bool collected = VisitReaches(index, held, [&](const uint32 word, const Entry* entry)
+  {
+    if (entry)
+    {
+      reaches.push_back(Reach{ word, entry->character });
+    }
+    else
+    {
+      const KanaId missing = index.FindMissingKana(word, held);
+      reaches.push_back(Reach{ word, index.GetMissingCharacter(word, missing, held).front() });
+    }
+  });
+
+  std::sort(reaches.begin() + first, reaches.end(), [](const Reach& a, const Reach& b) { return a.word < b.word; });
+  return collected;
+}
+
+bool DeletionIndex::CollectReaches(const DictionaryIndex& index, const KanaCounts& held, Array<uint32>& reaches) const
+{
+  const size_t first = reaches.size();
+
+  const bool collected = VisitReaches(index, held, [&](const uint32 word, const Entry*)
+  {
+    reaches.push_back(word);
+  });
+
+  std::sort(reaches.begin() + first, reaches.end());
+  return collected;
+}
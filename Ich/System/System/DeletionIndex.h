@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./KanaTable.h"
+
+class DictionaryIndex;
+
+/// <summary>
+/// 単語から正規化後の文字を1つ取り除いた署名（削除近傍）をキーに、(単語, 取り除いた文字) を引けるハッシュ表。
+/// 手持ちの部分多重集合の署名で引けば、あと1文字で完成するリーチ単語と足りない文字が直接求まる。
+/// </summary>
+class DeletionIndex
+{
+public:
+  /// <summary>
+  /// リーチ単語1件分の結果
+  /// </summary>
+  struct Reach
+  {
+    uint32 word;        // 単語番号
+    char32 character;   // 足りない文字（辞書に記載されている元の表記）
+  };
+
+  DeletionIndex();
+
+  /// <summary>
+  /// 辞書索引から削除近傍のハッシュ表を構築する。
+  /// </summary>
+  explicit DeletionIndex(const DictionaryIndex& index);
+
+  /// <summary>
+  /// 手持ちの部分多重集合を列挙してリーチ単語を集め、単語番号の昇順（辞書順）で末尾に追加する。
+  /// </summary>
+  /// <param name="index">構築に使った辞書索引（長い単語の判定に使う）。</param>
+  /// <param name="held">手持ちブロックの文字数。</param>
+  /// <param name="reaches">リーチ単語の追加先。</param>
+  /// <returns>
+  /// 部分多重集合が AnagramIndex::kMaxProbeCount を超えるなど、この索引で判定しなかった場合は false（reaches は変更しない）。
+  /// </returns>
+  bool CollectReaches(const DictionaryIndex& index, const KanaCounts& held, Array<Reach>& reaches) const;
+
+  /// <summary>
+  /// CollectReaches の単語番号だけを返す版。足りない文字が不要な場合に使う。
+  /// </summary>
+  bool CollectReaches(const DictionaryIndex& index, const KanaCounts& held, Array<uint32>& reaches) const;
+
+private:
+  /// <summary>
+  /// リーチ単語ごとに emit(単語番号, 項目) を呼ぶ。順番は不定。署名に収まらない長い単語では項目は nullptr。
+  /// </summary>
+  template <class Emit>
+  bool VisitReaches(const DictionaryIndex& index, const KanaCounts& held, Emit&& emit) const;
+
+  /// <summary>
+  /// ハッシュ表の1項目。取り除いた文字が手持ちで賄えない場合だけリーチになる。
+  /// </summary>
+  struct Entry
+  {
+    uint32 word;
+    KanaId missing;
+    char32 character;  // missing の最後の出現位置にある元の文字
+  };
+
+  /// <summary>
+  /// 署名が同じ項目の一覧（entries_ 内の範囲）
+  /// </summary>
+  struct EntryRange
+  {
+    uint32 offset;
+    uint32 size;
+  };
+
+  /// <summary>
+  /// 削除後の署名 -> 項目の一覧
+  /// </summary>
+  HashTable<uint64, EntryRange> ranges_;
+
+  /// <summary>
+  /// 同じ署名の項目が連続するように並べた一覧
+  /// </summary>
+  Array<Entry> entries_;
+
+  /// <summary>
+  /// 1文字取り除いても署名に収まらない長い単語の番号
+  /// </summary>
+  Array<uint32> long_words_;
+};
@@ -0,0 +1,52 @@
+﻿#include "./DictionaryCompiler.h"
+#include "./DictionaryLoader.h"
+#include "./MappedDictionary.h"
+
+#include <algorithm>
+
+namespace DictionaryCompiler
+{
+  Optional<size_t> Compile(const FilePathView input, const FilePathView output)
+  {
+    const Optional<DictionaryLoader::WordList> wordList = DictionaryLoader::LoadWordList(input);
+    if (!wordList)
+    {
+      return none;
+    }
+
+    if (!MappedDictionary::Write(output, DictionaryLoader::BuildIndex(*wordList)))
+    {
+      return none;
+    }
+
+    return wordList->rejected_line_count;
+  }
+
+  bool IsRequested(const Array<String>& args)
+  {
+    return std::find(args.begin(), args.end(), kCommandLineOption) != args.end();
+  }
+
+  bool Run(const Array<String>& args)
+  {
+    const auto option = std::find(args.begin(), args.end(), kCommandLineOption);
+    if (option == args.end() || std::distance(option, args.end()) < 3)
+    {
+      Console << (U"usage: " + String{ kCommandLineOption } + U" <input.txt> <output.ichd>");
+      return false;
+    }
+
+    const String& input = *(option + 1);
+    const String& output = *(option + 2);
+
+    const Optional<size_t> rejectedLineCount = Compile(input, output);
+    if (!rejectedLineCount)
+    {
+      Console << (U"failed to compile dictionary: " + input);
+      return false;
+    }
+
+    Console << (U"compiled dictionary: " + input + U" -> " + output + U" (skipped " + Format(*rejectedLineCount) + U" lines)");
+    return true;
+  }
+}
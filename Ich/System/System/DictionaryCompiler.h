@@ -0,0 +1,33 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+/// <summary>
+/// 単語一覧のテキストファイルを MappedDictionary のバイナリ形式（.ichd）に変換する処理。
+/// ゲームの実行ファイルに --compile-dictionary 入力.txt 出力.ichd を渡すと、ゲームを起動せずにこの処理だけを行う。
+/// </summary>
+namespace DictionaryCompiler
+{
+  /// <summary>
+  /// 変換を指示するコマンドライン引数
+  /// </summary>
+  inline constexpr StringView kCommandLineOption = U"--compile-dictionary";
+
+  /// <summary>
+  /// 単語一覧のテキストファイル（UTF-8）を DictionaryLoader で読み込み、バイナリ形式で書き出す。
+  /// ホットリロードと同じ規則で読むので、ひらがな以外の文字を含む行は読み飛ばし、重複した単語は最初のものだけを残す。
+  /// </summary>
+  /// <returns>書き出しに成功した場合は読み飛ばした行の数。ファイルを読めない・空・書き出せない場合は none。</returns>
+  Optional<size_t> Compile(FilePathView input, FilePathView output);
+
+  /// <summary>
+  /// コマンドライン引数に kCommandLineOption が含まれているか。
+  /// </summary>
+  bool IsRequested(const Array<String>& args);
+
+  /// <summary>
+  /// コマンドライン引数に従って変換を行い、結果をコンソールに表示する。
+  /// </summary>
+  /// <returns>変換に成功した場合は true。</returns>
+  bool Run(const Array<String>& args);
+}
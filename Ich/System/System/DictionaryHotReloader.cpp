@@ -0,0 +1,176 @@
+﻿#include "./DictionaryHotReloader.h"
+#include "./DictionaryIndex.h"
+#include "./IncrementalWordMatcher.h"
+
+#include <algorithm>
+#include <span>
+#include <string_view>
+
+DictionaryHotReloader::DictionaryHotReloader(FilePath path, const std::chrono::milliseconds pollInterval)
+  : path_(std::move(path))
+  , poll_interval_(pollInterval)
+{
+}
+
+DictionaryHotReloader::~DictionaryHotReloader()
+{
+  if (pending_.valid())
+  {
+    pending_.wait();
+  }
+}
+
+bool DictionaryHotReloader::Update(DictionaryIndex& index, IncrementalWordMatcher& matcher)
+{
+  if (pending_.valid())
+  {
+    if (pending_.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready)
+    {
+      return false;
+    }
+
+    patch_ = pending_.get();
+    if (!patch_)
+    {
+      return false;
+    }
+    rejected_line_count_ = patch_->rejected_line_count;
+  }
+
+  if (patch_)
+  {
+    ApplyPatch(index, matcher);
+    return true;
+  }
+
+  const Clock::time_point now = Clock::now();
+  if (!is_reload_requested_ && now < next_poll_time_)
+  {
+    return false;
+  }
+  next_poll_time_ = now + poll_interval_;
+
+  const Optional<DateTime> writeTime = FileSystem::WriteTime(path_);
+  if (!is_reload_requested_ && (!writeTime || writeTime == last_write_time_))
+  {
+    return false;
+  }
+
+  is_reload_requested_ = false;
+  last_write_time_ = writeTime;
+
+  // 読み込みが終わるまで索引は変更しないので、背景スレッドからは読み取りだけを行う。
+  pending_ = std::async(std::launch::async, [this, &index]() { return LoadPatch(index); });
+  return false;
+}
+
+void DictionaryHotReloader::Reset()
+{
+  word_ids_.clear();
+  has_word_ids_ = false;
+  added_words_.clear();
+  is_reload_requested_ = true;
+}
+
+Optional<DictionaryHotReloader::Patch> DictionaryHotReloader::LoadPatch(const DictionaryIndex& index)
+{
+  if (!has_word_ids_)
+  {
+    word_ids_.reserve(index.GetWordCount());
+    for (size_t word = 0; word < index.GetWordCount(); ++word)
+    {
+      if (!index.IsRemoved(word))
+      {
+        word_ids_.emplace(index.GetWord(word), static_cast<uint32>(word));
+      }
+    }
+    has_word_ids_ = true;
+  }
+
+  // ゲームの並列処理（WorkerPool）を待たせないよう、背景スレッドでは分割せずにこのスレッドだけで読み取る。
+  const Optional<DictionaryLoader::WordList> wordList = DictionaryLoader::LoadWordList(path_, DictionaryLoader::kNoSplit);
+  if (!wordList)
+  {
+    return none;
+  }
+
+  Patch patch;
+  patch.rejected_line_count = wordList->rejected_line_count;
+
+  HashSet<std::u32string_view> listed;
+  listed.reserve(wordList->GetWordCount());
+  for (size_t i = 0; i < wordList->GetWordCount(); ++i)
+  {
+    listed.insert(wordList->GetWord(i));
+  }
+
+  // 元の辞書の単語はファイルになくても残し、ファイルから消えた単語はここで追加したものだけ取り除く。
+  for (const String& word : added_words_)
+  {
+    if (!listed.contains(std::u32string_view{ word.data(), word.size() }))
+    {
+      patch.removed_ids << word_ids_.at(word);
+    }
+  }
+  std::sort(patch.removed_ids.begin(), patch.removed_ids.end());
+
+  HashSet<std::u32string_view> current;
+  current.reserve(word_ids_.size());
+  for (const auto& [word, id] : word_ids_)
+  {
+    current.insert(std::u32string_view{ word.data(), word.size() });
+  }
+
+  for (size_t i = 0; i < wordList->GetWordCount(); ++i)
+  {
+    if (!current.contains(wordList->GetWord(i)))
+    {
+      patch.added_words << String(wordList->GetWord(i));
+    }
+  }
+
+  return patch;
+}
+
+void DictionaryHotReloader::ApplyPatch(DictionaryIndex& index, IncrementalWordMatcher& matcher)
+{
+  Patch& patch = *patch_;
+  const size_t total = patch.removed_ids.size() + patch.added_words.size();
+  const size_t last = std::min(total, patch.applied + kMaxPatchOperationsPerFrame);
+
+  // このフレームの分をまとめて反映し、索引と判定器の並びの作り直しをそれぞれ1回で済ませる。
+  const size_t removedCount = patch.removed_ids.size();
+  if (patch.applied < removedCount)
+  {
+    const size_t end = std::min(last, removedCount);
+    const std::span<const uint32> ids(patch.removed_ids.data() + patch.applied, end - patch.applied);
+    for (const uint32 id : ids)
+    {
+      const String word{ index.GetWord(id) };
+      word_ids_.erase(word);
+      added_words_.erase(word);
+    }
+    matcher.RemoveWords(ids);
+    index.RemoveWords(ids);
+    patch.applied = end;
+  }
+
+  if (patch.applied < last)
+  {
+    // 読み込み時に文字を確かめているので、AddWords が例外を投げることはない。
+    const std::span<const String> words(patch.added_words.data() + (patch.applied - removedCount), last - patch.applied);
+    const Array<uint32> ids = index.AddWords(words);
+    matcher.AddWords(ids);
+    for (size_t i = 0; i < words.size(); ++i)
+    {
+      word_ids_.emplace(words[i], ids[i]);
+      added_words_.insert(words[i]);
+    }
+    patch.applied = last;
+  }
+
+  if (patch.applied == total)
+  {
+    patch_.reset();
+  }
+}
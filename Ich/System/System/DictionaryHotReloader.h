@@ -0,0 +1,159 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./DictionaryLoader.h"
+
+#include <chrono>
+#include <future>
+
+class DictionaryIndex;
+class IncrementalWordMatcher;
+
+/// <summary>
+/// 単語一覧ファイルを監視し、ゲームを止めずにその単語を辞書へ重ねる。
+/// ファイルの単語は元の辞書への追加分として扱い、元の辞書の単語は取り除かない（ファイルから消えた単語は、ここで追加したものだけ取り除く）。
+/// ファイルの更新を見つけたら背景スレッドで読み込み、今の辞書との差分（追加・削除する単語）を求める。
+/// 差分は DictionaryIndex と IncrementalWordMatcher にフレームごとにまとめて反映し、索引は作り直さない。
+/// 反映は Update の中で行い、1フレームあたりの件数には上限がある。
+/// </summary>
+/// <remarks>
+/// 読み込み中は背景スレッドが索引の単語を参照するので、その間は索引を他から変更しないこと。
+/// </remarks>
+class DictionaryHotReloader
+{
+public:
+  /// <summary>
+  /// 1フレームで反映する追加・削除の上限。大きな変更は数フレームに分けて反映する。
+  /// </summary>
+  static constexpr size_t kMaxPatchOperationsPerFrame = 2048;
+
+  /// <summary>
+  /// ファイルの更新日時を調べる既定の間隔
+  /// </summary>
+  static constexpr std::chrono::milliseconds kDefaultPollInterval{ 500 };
+
+  /// <summary>
+  /// コンストラクタ
+  /// </summary>
+  /// <param name="path">監視する単語一覧ファイル（UTF-8、1行1語）。存在しない間は何もしない。</param>
+  /// <param name="pollInterval">ファイルの更新日時を調べる間隔。</param>
+  explicit DictionaryHotReloader(FilePath path, std::chrono::milliseconds pollInterval = kDefaultPollInterval);
+
+  /// <summary>
+  /// デストラクタ（読み込み中なら終わるまで待つ）
+  /// </summary>
+  ~DictionaryHotReloader();
+
+  DictionaryHotReloader(const DictionaryHotReloader&) = delete;
+  DictionaryHotReloader& operator=(const DictionaryHotReloader&) = delete;
+
+  /// <summary>
+  /// 毎フレーム呼ぶ。
+  /// ファイルの更新を見つけたら背景での読み込みを始め、読み込みが終わっていれば差分を反映する。
+  /// 反映後の辞書は、元の辞書の単語とファイルの単語を合わせたものになる。
+  /// </summary>
+  /// <returns>このフレームで辞書を変更した場合は true。</returns>
+  bool Update(DictionaryIndex& index, IncrementalWordMatcher& matcher);
+
+  /// <summary>
+  /// 更新日時に関係なく、次の Update でファイルを読み込み直す。
+  /// </summary>
+  void RequestReload() { is_reload_requested_ = true; }
+
+  /// <summary>
+  /// 索引を別の辞書に差し替えたときに呼ぶ（IsBusy() が false の間だけ）。
+  /// 単語と番号の対応と追加した単語の記録を捨て、次の Update でファイルを読み込み直して新しい辞書にファイルの単語を重ねる。
+  /// </summary>
+  void Reset();
+
+  /// <summary>
+  /// 読み込み中、または反映していない差分が残っているか。
+  /// </summary>
+  bool IsBusy() const { return pending_.valid() || patch_.has_value(); }
+
+  /// <summary>
+  /// 直前に読み込んだファイルで、ひらがな以外の文字を含むなどの理由で読み飛ばした行の数
+  /// </summary>
+  size_t GetRejectedLineCount() const { return rejected_line_count_; }
+
+private:
+  /// <summary>
+  /// 今の辞書にファイルの単語を重ねるための差分
+  /// </summary>
+  struct Patch
+  {
+    /// <summary>
+    /// 取り除く単語の番号（昇順）。以前ファイルから追加し、今はファイルにない単語だけ。
+    /// </summary>
+    Array<uint32> removed_ids;
+
+    /// <summary>
+    /// 追加する単語（ファイルでの順）。今の辞書にない単語だけ。
+    /// </summary>
+    Array<String> added_words;
+
+    /// <summary>
+    /// 読み飛ばした行の数
+    /// </summary>
+    size_t rejected_line_count = 0;
+
+    /// <summary>
+    /// 反映済みの件数（removed_ids、added_words の順に数える）
+    /// </summary>
+    size_t applied = 0;
+  };
+
+  /// <summary>
+  /// 背景スレッドの処理。ファイルを読み込み、差分を求める。
+  /// </summary>
+  Optional<Patch> LoadPatch(const DictionaryIndex& index);
+
+  /// <summary>
+  /// 差分を最大 kMaxPatchOperationsPerFrame 件だけ反映する。
+  /// </summary>
+  void ApplyPatch(DictionaryIndex& index, IncrementalWordMatcher& matcher);
+
+  using Clock = std::chrono::steady_clock;
+
+  /// <summary>
+  /// 監視するファイル
+  /// </summary>
+  FilePath path_;
+
+  /// <summary>
+  /// 更新日時を調べる間隔と、次に調べる時刻
+  /// </summary>
+  Clock::duration poll_interval_;
+  Clock::time_point next_poll_time_{};
+
+  /// <summary>
+  /// 最後に読み込んだときのファイルの更新日時
+  /// </summary>
+  Optional<DateTime> last_write_time_;
+
+  bool is_reload_requested_ = false;
+
+  /// <summary>
+  /// 背景スレッドで実行中の読み込み
+  /// </summary>
+  std::future<Optional<Patch>> pending_;
+
+  /// <summary>
+  /// 反映中の差分
+  /// </summary>
+  Optional<Patch> patch_;
+
+  /// <summary>
+  /// 表記 -> 単語番号（取り除いた単語を除く）。最初の読み込み時に背景スレッドで作り、以降は差分の反映に合わせて更新する。
+  /// </summary>
+  HashTable<String, uint32> word_ids_;
+  bool has_word_ids_ = false;
+
+  /// <summary>
+  /// ファイルから追加し、まだ辞書に残っている単語。取り除いてよいのはこの単語だけ。
+  /// </summary>
+  HashSet<String> added_words_;
+
+  size_t rejected_line_count_ = 0;
+};
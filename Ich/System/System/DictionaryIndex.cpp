@@ -0,0 +1,495 @@
+﻿#include "./DictionaryIndex.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+  /// <summary>
+  /// uint8 の上限で頭打ちにしながら1加算する。
+  /// </summary>
+  void IncrementSaturated(uint8& value)
+  {
+    if (value < std::numeric_limits<uint8>::max())
+    {
+      ++value;
+    }
+  }
+
+  /// <summary>
+  /// 単語を正規化して文字ごとの個数と長さを数える。
+  /// </summary>
+  /// <param name="normalized">正規化の作業領域（単語より短ければ広げる）。</param>
+  /// <exception cref="std::invalid_argument">ひらがな（と長音記号）以外の文字を含む場合。</exception>
+  std::pair<KanaCounts, uint8> CountWord(const String& word, Array<char32>& normalized)
+  {
+    KanaCounts counts{};
+    uint8 length = 0;
+
+    if (normalized.size() < word.size())
+    {
+      normalized.resize(word.size());
+    }
+    const size_t normalizedLength = NormalizeKana(std::span<const char32>(word.data(), word.size()), normalized);
+
+    for (size_t i = 0; i < normalizedLength; ++i)
+    {
+      const KanaId id = ToKanaId(normalized[i]);
+      if (id == kInvalidKanaId)
+      {
+        throw std::invalid_argument("dictionary words must consist of hiragana only.");
+      }
+
+      IncrementSaturated(counts[id]);
+      IncrementSaturated(length);
+    }
+
+    return { counts, length };
+  }
+} // namespace
+
+DictionaryIndex::DictionaryIndex() = default;
+
+DictionaryIndex::DictionaryIndex(const Array<String>& dictionary)
+{
+  words_.reserve(dictionary.size());
+  counts_.reserve(dictionary.size());
+  lengths_.reserve(dictionary.size());
+
+  // 単語ごとに一括で正規化する作業領域（最長の単語に合わせて使い回す）
+  Array<char32> normalized;
+
+  for (const auto& word : dictionary)
+  {
+    const auto [counts, length] = CountWord(word, normalized);
+
+    words_ << word;
+    counts_ << counts;
+    lengths_ << length;
+  }
+
+  BuildDerivedTables();
+}
+
+DictionaryIndex::DictionaryIndex(const std::span<const std::u32string_view> words, const std::span<const KanaId> kanaIds, const std::span<const uint32> offsets)
+{
+  if (offsets.size() != words.size() + 1)
+  {
+    throw std::invalid_argument("offsets must have one more element than words.");
+  }
+
+  words_.reserve(words.size());
+  counts_.reserve(words.size());
+  lengths_.reserve(words.size());
+
+  for (size_t i = 0; i < words.size(); ++i)
+  {
+    KanaCounts counts{};
+    uint8 length = 0;
+
+    for (const KanaId id : kanaIds.subspan(offsets[i], offsets[i + 1] - offsets[i]))
+    {
+      if (id >= kKanaAlphabetSize)
+      {
+        throw std::invalid_argument("kana ids must be less than kKanaAlphabetSize.");
+      }
+
+      IncrementSaturated(counts[id]);
+      IncrementSaturated(length);
+    }
+
+    words_ << String(words[i]);
+    counts_ << counts;
+    lengths_ << length;
+  }
+
+  BuildDerivedTables();
+}
+
+DictionaryIndex::DictionaryIndex(BorrowedTables tables)
+{
+  const size_t wordCount = tables.words.size();
+  const size_t stride = tables.column_stride;
+
+  const bool isValid = (tables.counts.size() == wordCount)
+    && (stride >= wordCount)
+    && (stride % kColumnAlignment == 0)
+    && (tables.lengths.size() >= stride)
+    && (tables.columns.size() >= kKanaAlphabetSize * stride)
+    && (tables.length_order.size() <= wordCount)
+    && (tables.length_offsets.size() == static_cast<size_t>(std::numeric_limits<uint8>::max()) + 2)
+    && std::is_sorted(tables.length_offsets.begin(), tables.length_offsets.end())
+    && (tables.length_offsets.back() == tables.length_order.size());
+  if (!isValid)
+  {
+    throw std::invalid_argument("borrowed tables do not match the word count.");
+  }
+
+  borrowed_words_ = tables.words;
+  column_stride_ = stride;
+  length_offsets_.assign(tables.length_offsets.begin(), tables.length_offsets.end());
+  borrowed_ = std::move(tables);
+  is_borrowed_ = true;
+
+  BuildAuxiliaryIndexes();
+}
+
+void DictionaryIndex::BuildDerivedTables()
+{
+  // 行（単語ごと）の表を、文字ごとの列へ並べ替えた SoA 表も作っておく。
+  column_stride_ = (words_.size() + kColumnAlignment - 1) / kColumnAlignment * kColumnAlignment;
+  columns_.assign(kKanaAlphabetSize * column_stride_, 0);
+  lengths_.resize(column_stride_, 0);
+
+  for (size_t i = 0; i < counts_.size(); ++i)
+  {
+    for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+    {
+      columns_[id * column_stride_ + i] = counts_[i][id];
+    }
+  }
+
+  // 長さごとに単語番号を並べ（計数ソート）、長さの上限で候補を切り出せるようにする。
+  const uint8 maxLength = counts_.isEmpty() ? 0 : *std::max_element(lengths_.begin(), lengths_.end());
+  length_offsets_.assign(static_cast<size_t>(maxLength) + 2, 0);
+
+  for (size_t i = 0; i < counts_.size(); ++i)
+  {
+    ++length_offsets_[static_cast<size_t>(lengths_[i]) + 1];
+  }
+  for (size_t n = 1; n < length_offsets_.size(); ++n)
+  {
+    length_offsets_[n] += length_offsets_[n - 1];
+  }
+
+  length_order_.resize(counts_.size());
+  Array<uint32> cursor(length_offsets_.begin(), length_offsets_.end() - 1);
+  for (size_t i = 0; i < counts_.size(); ++i)
+  {
+    length_order_[cursor[lengths_[i]]++] = static_cast<uint32>(i);
+  }
+
+  BuildAuxiliaryIndexes();
+}
+
+void DictionaryIndex::BuildAuxiliaryIndexes()
+{
+  removed_.assign(GetWordCount(), false);
+  is_patched_ = false;
+
+  // 借りた表（書き出したファイルなど）は取り除いた単語を長さ kRemovedLength の欠番として含むことがある。
+  // 欠番があると補助索引は番号の対応が崩れるので、差分を当てた後と同じく使わない扱いにする。
+  if (is_borrowed_)
+  {
+    for (size_t i = 0; i < GetWordCount(); ++i)
+    {
+      if (borrowed_.lengths[i] == kRemovedLength)
+      {
+        removed_[i] = true;
+        is_patched_ = true;
+      }
+    }
+  }
+
+  auxiliary_ = std::make_shared<AuxiliaryIndexes>();
+}
+
+const KanaBitsetIndex& DictionaryIndex::GetBitsetIndex() const
+{
+  std::call_once(auxiliary_->bitset_flag, [this]() { auxiliary_->bitset = KanaBitsetIndex(*this); });
+  return auxiliary_->bitset;
+}
+
+const AnagramIndex& DictionaryIndex::GetAnagramIndex() const
+{
+  std::call_once(auxiliary_->anagram_flag, [this]() { auxiliary_->anagram = AnagramIndex(*this); });
+  return auxiliary_->anagram;
+}
+
+const DeletionIndex& DictionaryIndex::GetDeletionIndex() const
+{
+  std::call_once(auxiliary_->deletion_flag, [this]() { auxiliary_->deletion = DeletionIndex(*this); });
+  return auxiliary_->deletion;
+}
+
+void DictionaryIndex::MakeTablesOwned()
+{
+  if (!is_borrowed_)
+  {
+    return;
+  }
+
+  counts_.assign(borrowed_.counts.begin(), borrowed_.counts.end());
+  lengths_.assign(borrowed_.lengths.begin(), borrowed_.lengths.begin() + column_stride_);
+  columns_.assign(borrowed_.columns.begin(), borrowed_.columns.begin() + kKanaAlphabetSize * column_stride_);
+  length_order_.assign(borrowed_.length_order.begin(), borrowed_.length_order.end());
+
+  // 単語の表記は借りたまま使うので、領域の持ち主だけは手放さない。
+  borrowed_ = BorrowedTables{ .words = borrowed_.words, .owner = std::move(borrowed_.owner) };
+  is_borrowed_ = false;
+}
+
+void DictionaryIndex::GrowColumns(const size_t minimumStride)
+{
+  // 追加のたびに並べ直さずに済むよう、1/4 ずつ余裕を持たせて広げる。
+  const size_t target = std::max(minimumStride, column_stride_ + column_stride_ / 4);
+  const size_t stride = (target + kColumnAlignment - 1) / kColumnAlignment * kColumnAlignment;
+
+  Array<uint8> columns(kKanaAlphabetSize * stride, 0);
+  for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+  {
+    std::copy_n(columns_.begin() + id * column_stride_, column_stride_, columns.begin() + id * stride);
+  }
+
+  columns_ = std::move(columns);
+  lengths_.resize(stride, 0);
+  column_stride_ = stride;
+}
+
+uint32 DictionaryIndex::AddWord(const String& word)
+{
+  return AddWords(std::span<const String>(&word, 1)).front();
+}
+
+Array<uint32> DictionaryIndex::AddWords(const std::span<const String> words)
+{
+  // 先にすべての単語を数え、ひらがな以外を含む単語があれば何も変更せずに例外を投げる。
+  Array<char32> normalized;
+  Array<std::pair<KanaCounts, uint8>> counted;
+  counted.reserve(words.size());
+  for (const String& word : words)
+  {
+    counted << CountWord(word, normalized);
+  }
+
+  if (words.empty())
+  {
+    return {};
+  }
+
+  MakeTablesOwned();
+
+  const size_t first = GetWordCount();
+  if (first + words.size() > column_stride_)
+  {
+    GrowColumns(first + words.size());
+  }
+
+  Array<uint32> ids;
+  ids.reserve(words.size());
+  uint8 maxLength = 0;
+
+  for (size_t i = 0; i < words.size(); ++i)
+  {
+    const size_t index = first + i;
+    const auto& [counts, length] = counted[i];
+
+    words_ << words[i];
+    counts_ << counts;
+    removed_ << false;
+    lengths_[index] = length;
+
+    for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+    {
+      columns_[id * column_stride_ + index] = counts[id];
+    }
+
+    ids << static_cast<uint32>(index);
+    maxLength = std::max(maxLength, length);
+  }
+
+  if (length_offsets_.size() < static_cast<size_t>(maxLength) + 2)
+  {
+    const uint32 total = length_offsets_.isEmpty() ? 0 : length_offsets_.back();
+    length_offsets_.resize(static_cast<size_t>(maxLength) + 2, total);
+  }
+
+  // 新しい単語の番号はどれも既存より大きいので、長さごとに既存の単語の後ろへ続ければ長さ順・番号順が保たれる。
+  // 1語ずつ挿入すると毎回後ろをずらすことになるため、並びは追加した単語の分をまとめて1回で作り直す。
+  Array<uint32> added = ids;
+  std::stable_sort(added.begin(), added.end(), [this](const uint32 a, const uint32 b) { return lengths_[a] < lengths_[b]; });
+
+  Array<uint32> order;
+  order.reserve(length_order_.size() + added.size());
+  Array<uint32> offsets(length_offsets_.size(), 0);
+  size_t cursor = 0;
+
+  for (size_t length = 0; length + 1 < length_offsets_.size(); ++length)
+  {
+    offsets[length] = static_cast<uint32>(order.size());
+    order.insert(order.end(), length_order_.begin() + length_offsets_[length], length_order_.begin() + length_offsets_[length + 1]);
+    for (; cursor < added.size() && lengths_[added[cursor]] == length; ++cursor)
+    {
+      order << added[cursor];
+    }
+  }
+  offsets.back() = static_cast<uint32>(order.size());
+
+  length_order_ = std::move(order);
+  length_offsets_ = std::move(offsets);
+
+  // コピー元の索引と共有している補助索引は、変更前の表から作ったものなので切り離す。
+  auxiliary_ = std::make_shared<AuxiliaryIndexes>();
+  is_patched_ = true;
+  return ids;
+}
+
+bool DictionaryIndex::RemoveWord(const uint32 index)
+{
+  return RemoveWords(std::span<const uint32>(&index, 1)) == 1;
+}
+
+size_t DictionaryIndex::RemoveWords(const std::span<const uint32> indices)
+{
+  const auto isRemovable = [this](const uint32 index) { return index < GetWordCount() && !removed_[index]; };
+  if (std::none_of(indices.begin(), indices.end(), isRemovable))
+  {
+    return 0;
+  }
+
+  MakeTablesOwned();
+
+  size_t removedCount = 0;
+  for (const uint32 index : indices)
+  {
+    if (!isRemovable(index))
+    {
+      continue;
+    }
+
+    for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+    {
+      columns_[id * column_stride_ + index] = 0;
+    }
+    lengths_[index] = kRemovedLength;
+    removed_[index] = true;
+    ++removedCount;
+  }
+
+  // 長さ順の並びから取り除いた単語をまとめて詰め、長さごとの開始位置を数え直す。
+  Array<uint32> offsets(length_offsets_.size(), 0);
+  size_t written = 0;
+  for (size_t length = 0; length + 1 < length_offsets_.size(); ++length)
+  {
+    offsets[length] = static_cast<uint32>(written);
+    for (size_t position = length_offsets_[length]; position < length_offsets_[length + 1]; ++position)
+    {
+      if (!removed_[length_order_[position]])
+      {
+        length_order_[written++] = length_order_[position];
+      }
+    }
+  }
+  if (!offsets.isEmpty())
+  {
+    offsets.back() = static_cast<uint32>(written);
+  }
+
+  length_order_.resize(written);
+  length_offsets_ = std::move(offsets);
+
+  auxiliary_ = std::make_shared<AuxiliaryIndexes>();
+  is_patched_ = true;
+  return removedCount;
+}
+
+KanaId DictionaryIndex::FindMissingKana(const size_t index, const KanaCounts& held) const
+{
+  const KanaCounts& required = GetCounts(index);
+
+  for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+  {
+    if (required[id] > held[id])
+    {
+      return static_cast<KanaId>(id);
+    }
+  }
+
+  return kInvalidKanaId;
+}
+
+String DictionaryIndex::GetMissingCharacter(const size_t index, const KanaId missing, const KanaCounts& held) const
+{
+  // 手持ちで賄える分（held[missing] 個）を読み飛ばし、その次の出現位置の文字を返す。
+  int32 remaining = held[missing];
+
+  for (const char32 ch : GetWord(index))
+  {
+    const auto normalized = NormalizeKanaChar(ch);
+    if (!normalized || ToKanaId(*normalized) != missing)
+    {
+      continue;
+    }
+
+    if (remaining == 0)
+    {
+      return String(1, ch);
+    }
+
+    --remaining;
+  }
+
+  // 上記ループで返却できなかった場合は、正規化後の文字をそのまま返す。
+  return String(1, FromKanaId(missing));
+}
+
+Array<String> DictionaryIndex::GetMissingCharacters(const size_t index, const KanaCounts& held) const
+{
+  Array<String> result;
+  KanaCounts remaining = held;
+
+  for (const char32 ch : GetWord(index))
+  {
+    const auto normalized = NormalizeKanaChar(ch);
+    if (!normalized)
+    {
+      continue;
+    }
+
+    const KanaId id = ToKanaId(*normalized);
+    if (remaining[id] == 0)
+    {
+      result << String(1, ch);
+    }
+    else
+    {
+      --remaining[id];
+    }
+  }
+
+  return result;
+}
+
+std::span<const uint32> DictionaryIndex::GetWordsUpToLength(const size_t maxLength) const
+{
+  if (length_offsets_.isEmpty())
+  {
+    return {};
+  }
+
+  const size_t bucket = std::min(maxLength + 1, length_offsets_.size() - 1);
+  return std::span<const uint32>(is_borrowed_ ? borrowed_.length_order.data() : length_order_.data(), length_offsets_[bucket]);
+}
+
+KanaCounts DictionaryIndex::CountBlocks(const Array<String>& blocks)
+{
+  KanaCounts counts{};
+
+  for (const auto& token : blocks)
+  {
+    for (const char32 ch : token)
+    {
+      if (const auto normalized = NormalizeKanaChar(ch))
+      {
+        if (const KanaId id = ToKanaId(*normalized); id != kInvalidKanaId)
+        {
+          IncrementSaturated(counts[id]);
+        }
+      }
+    }
+  }
+
+  return counts;
+}
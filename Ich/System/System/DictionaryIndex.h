@@ -0,0 +1,311 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./AnagramIndex.h"
+#include "./DeletionIndex.h"
+#include "./KanaBitsetIndex.h"
+#include "./KanaTable.h"
+#include "./WordMatchKernel.h"
+
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+
+/// <summary>
+/// 辞書を一度だけ前処理し、単語ごとの文字数を固定幅の KanaCounts として保持する索引。
+/// ヒット・リーチ判定のたびに辞書語をハッシュマップへ変換し直さずに済むよう、
+/// ゲーム開始時などに構築しておき BlockManager へ渡して使う。
+/// </summary>
+class DictionaryIndex
+{
+public:
+  /// <summary>
+  /// 呼び出し側が持つ領域（コンパイル時に埋め込んだ表や、割り当てたファイルなど）にある、前計算済みの表。
+  /// この表から作った索引は表をコピーせずに参照する。AddWord / RemoveWord を初めて呼んだときだけ、書き換える表を索引側に写す。
+  /// </summary>
+  struct BorrowedTables
+  {
+    std::span<const std::u32string_view> words;  // 辞書に記載されている表記
+    std::span<const KanaCounts> counts;          // 単語ごとの必要文字数
+    std::span<const uint8> lengths;              // 単語の長さの列（column_stride 個、超過分は 0、欠番は kRemovedLength）
+    std::span<const uint8> columns;              // 文字ごとの必要数の列（kKanaAlphabetSize 本 × column_stride）
+    size_t column_stride = 0;                    // 列の長さ（単語数以上の kColumnAlignment の倍数）
+    std::span<const uint32> length_order;        // 単語番号を長さの昇順（同じ長さの中では番号順）に並べたもの
+    std::span<const uint32> length_offsets;      // length_order のうち長さが n 以上の単語が始まる位置（添字 0 ～ 256）。末尾は length_order の個数
+    std::shared_ptr<const void> owner;           // 領域の持ち主。索引（とそのコピー）が生きている間は手放さない
+  };
+
+  DictionaryIndex();
+
+  /// <summary>
+  /// 辞書から索引を構築する。
+  /// </summary>
+  /// <param name="dictionary">ひらがなで構成された単語一覧。</param>
+  /// <exception cref="std::invalid_argument">ひらがな（と長音記号）以外の文字を含む単語がある場合。</exception>
+  explicit DictionaryIndex(const Array<String>& dictionary);
+
+  /// <summary>
+  /// 正規化済みの文字IDが用意されている辞書（コンパイル時に埋め込んだ辞書など）から索引を構築する。
+  /// 文字の正規化を行わずに単語ごとの文字数を数える。
+  /// </summary>
+  /// <param name="words">辞書に記載されている表記の単語一覧。</param>
+  /// <param name="kanaIds">全単語の正規化後の文字IDを続けて並べたもの。</param>
+  /// <param name="offsets">単語 i の文字IDは kanaIds の [offsets[i], offsets[i + 1]) 番目。要素数は単語数 + 1。</param>
+  /// <exception cref="std::invalid_argument">offsets の要素数が合わない場合や、範囲外の文字IDがある場合。</exception>
+  DictionaryIndex(std::span<const std::u32string_view> words, std::span<const KanaId> kanaIds, std::span<const uint32> offsets);
+
+  /// <summary>
+  /// 前計算済みの表を参照する索引を作る。単語の表記・文字数・SoA 列・長さ順の並びはコピーせず、
+  /// ここでは欠番の表だけを作る（補助索引は使う方式が初めて参照したときに作る）。
+  /// </summary>
+  /// <exception cref="std::invalid_argument">表の大きさが単語数と合わない場合。</exception>
+  explicit DictionaryIndex(BorrowedTables tables);
+
+  /// <summary>
+  /// 登録されている単語数を返す。
+  /// </summary>
+  size_t GetWordCount() const { return borrowed_words_.size() + words_.size(); }
+
+  /// <summary>
+  /// 単語が1つも登録されていないか。
+  /// </summary>
+  bool IsEmpty() const { return GetWordCount() == 0; }
+
+  /// <summary>
+  /// 辞書に記載されている表記のまま単語を返す。索引が持つ文字列（借りた表の場合はその領域）を指す。
+  /// </summary>
+  StringView GetWord(const size_t index) const
+  {
+    return (index < borrowed_words_.size()) ? StringView{ borrowed_words_[index] } : StringView{ words_[index - borrowed_words_.size()] };
+  }
+
+  /// <summary>
+  /// 単語を組み立てるのに必要な、正規化後の文字ごとの個数を返す。
+  /// </summary>
+  const KanaCounts& GetCounts(const size_t index) const { return is_borrowed_ ? borrowed_.counts[index] : counts_[index]; }
+
+  /// <summary>
+  /// 単語の長さ（正規化後、長音記号を除いた文字数）を返す。
+  /// </summary>
+  uint8 GetLength(const size_t index) const { return GetLengthColumn()[index]; }
+
+  /// <summary>
+  /// 文字ごとに全単語の必要数を並べた列（構造体配列ではなく配列構造体＝SoA）の先頭を返す。
+  /// 列の長さは GetColumnStride() で、単語数を超える部分は 0 で埋めてある。
+  /// </summary>
+  const uint8* GetColumn(const KanaId id) const
+  {
+    return (is_borrowed_ ? borrowed_.columns.data() : columns_.data()) + static_cast<size_t>(id) * column_stride_;
+  }
+
+  /// <summary>
+  /// 単語の長さを並べた列の先頭を返す。GetColumn と同じく GetColumnStride() 個分（超過分は 0）ある。
+  /// </summary>
+  const uint8* GetLengthColumn() const { return is_borrowed_ ? borrowed_.lengths.data() : lengths_.data(); }
+
+  /// <summary>
+  /// 各列の長さ。単語数以上の kColumnAlignment の倍数（AddWord で単語を追加した後は余裕を持たせた値になる）。
+  /// </summary>
+  size_t GetColumnStride() const { return column_stride_; }
+
+  /// <summary>
+  /// 列の長さの切り上げ単位。SIMD で一度に比較する単語数（AVX2 の 32 バイト）に合わせる。
+  /// </summary>
+  static constexpr size_t kColumnAlignment = 32;
+
+  /// <summary>
+  /// SoA 列と長さの列をまとめた参照を返す。
+  /// </summary>
+  WordMatchKernel::ColumnView GetColumnView() const { return { GetColumn(0), GetLengthColumn(), column_stride_, GetWordCount() }; }
+
+  /// <summary>
+  /// (文字, 必要数の下限) ごとのビット集合による転置索引を返す。初めて呼んだときに作る。
+  /// </summary>
+  const KanaBitsetIndex& GetBitsetIndex() const;
+
+  /// <summary>
+  /// 署名（正規化後の文字を昇順に並べたもの）ごとに単語をまとめたハッシュ表を返す。初めて呼んだときに作る。
+  /// </summary>
+  const AnagramIndex& GetAnagramIndex() const;
+
+  /// <summary>
+  /// 単語から1文字取り除いた署名ごとに (単語, 足りない文字) をまとめたハッシュ表を返す。初めて呼んだときに作る。
+  /// </summary>
+  const DeletionIndex& GetDeletionIndex() const;
+
+  /// <summary>
+  /// 手持ちで賄えない文字のうち、最も小さいIDを返す。リーチ状態の単語なら不足している唯一の文字になる。
+  /// </summary>
+  /// <returns>不足している文字のID。不足がなければ kInvalidKanaId。</returns>
+  KanaId FindMissingKana(size_t index, const KanaCounts& held) const;
+
+  /// <summary>
+  /// リーチ状態の単語について、不足している「元の文字（濁点付き等）」を返す。
+  /// 単語を頭から走査し、手持ちの数を使い切った次の出現位置の文字が不足分になる。
+  /// </summary>
+  /// <param name="index">単語の位置。</param>
+  /// <param name="missing">不足している文字のID。</param>
+  /// <param name="held">手持ちブロックの文字数。</param>
+  String GetMissingCharacter(size_t index, KanaId missing, const KanaCounts& held) const;
+
+  /// <summary>
+  /// 不足している文字（手持ちの数を使い切った後の出現位置にある元の文字）を、単語中の順番で返す。
+  /// </summary>
+  /// <param name="index">単語の位置。</param>
+  /// <param name="held">手持ちブロックの文字数。</param>
+  Array<String> GetMissingCharacters(size_t index, const KanaCounts& held) const;
+
+  /// <summary>
+  /// 長さが maxLength 以下の単語の番号を、短い順（同じ長さの中では辞書順）に返す。
+  /// 手持ちの枚数から長さの上限が決まる問い合わせで、候補を先頭から切り出すのに使う。
+  /// </summary>
+  std::span<const uint32> GetWordsUpToLength(size_t maxLength) const;
+
+  /// <summary>
+  /// 単語を末尾に追加し、ヒット・リーチ判定に使う SoA 列と長さ順の並びをその単語の分だけ更新する。
+  /// ビット集合・署名などの補助索引は更新しないため、追加後は IsPatched() が true になる。
+  /// </summary>
+  /// <returns>追加した単語の番号。</returns>
+  /// <exception cref="std::invalid_argument">ひらがな（と長音記号）以外の文字を含む場合。</exception>
+  uint32 AddWord(const String& word);
+
+  /// <summary>
+  /// 複数の単語を末尾に追加する。AddWord を繰り返すのと同じ結果になるが、長さ順の並びは最後に1回だけ作り直す。
+  /// </summary>
+  /// <returns>追加した単語の番号（words の順）。</returns>
+  /// <exception cref="std::invalid_argument">ひらがな（と長音記号）以外の文字を含む単語がある場合（索引は変更しない）。</exception>
+  Array<uint32> AddWords(std::span<const String> words);
+
+  /// <summary>
+  /// 単語を取り除く。番号は詰めずに欠番とし、SoA 列の必要数を 0・長さを kRemovedLength にして判定から外す。
+  /// GetWord と GetCounts は、IncrementalWordMatcher::RemoveWord などの後始末のためにそのまま残す。
+  /// </summary>
+  /// <returns>取り除いた場合は true。範囲外の番号や、既に取り除かれていた場合は false。</returns>
+  bool RemoveWord(uint32 index);
+
+  /// <summary>
+  /// 複数の単語を取り除く。RemoveWord を繰り返すのと同じ結果になるが、長さ順の並びは最後に1回だけ詰め直す。
+  /// </summary>
+  /// <returns>取り除いた単語の数（範囲外・取り除き済みの番号は数えない）。</returns>
+  size_t RemoveWords(std::span<const uint32> indices);
+
+  /// <summary>
+  /// RemoveWord で取り除かれた単語か。
+  /// </summary>
+  bool IsRemoved(size_t index) const { return removed_[index]; }
+
+  /// <summary>
+  /// AddWord / RemoveWord で変更されたか。変更後の補助索引（ビット集合・署名・削除近傍）は古いままなので使わないこと。
+  /// </summary>
+  bool IsPatched() const { return is_patched_; }
+
+  /// <summary>
+  /// 単語の文字数・SoA 列・長さ順の並びを、BorrowedTables から借りたまま参照しているか。
+  /// </summary>
+  bool IsBorrowed() const { return is_borrowed_; }
+
+  /// <summary>
+  /// 取り除いた単語の長さ。SoA 列の必要数が 0 なので不足数は常にこの値になり、ヒットにもリーチにもならない。
+  /// </summary>
+  static constexpr uint8 kRemovedLength = 0xFF;
+
+  /// <summary>
+  /// ブロック一覧から手持ちの文字数を数える。
+  /// アルファベット外の文字はどの単語にも使われないため無視する。
+  /// </summary>
+  static KanaCounts CountBlocks(const Array<String>& blocks);
+
+private:
+  /// <summary>
+  /// words_ / counts_ / lengths_ から SoA 列・長さ順の並び・各補助索引を作る。
+  /// </summary>
+  void BuildDerivedTables();
+
+  /// <summary>
+  /// 欠番の表を作り、補助索引を未作成に戻す（SoA 列と長さ順の並びは作成済みであること）。
+  /// </summary>
+  void BuildAuxiliaryIndexes();
+
+  /// <summary>
+  /// 借りている表を索引側に写し、書き換えられるようにする。単語の表記は借りたまま使う。
+  /// </summary>
+  void MakeTablesOwned();
+
+  /// <summary>
+  /// 列の長さを minimumStride 以上に広げ、既存の列を並べ直す。
+  /// </summary>
+  void GrowColumns(size_t minimumStride);
+
+  /// <summary>
+  /// 借りている表（is_borrowed_ の間だけ使う。単語の表記は borrowed_words_ で、写した後も借りたまま）
+  /// </summary>
+  BorrowedTables borrowed_;
+  std::span<const std::u32string_view> borrowed_words_;
+  bool is_borrowed_ = false;
+
+  /// <summary>
+  /// 辞書に記載されている表記（borrowed_words_ に続く単語）
+  /// </summary>
+  Array<String> words_;
+
+  /// <summary>
+  /// 単語ごとの必要文字数
+  /// </summary>
+  Array<KanaCounts> counts_;
+
+  /// <summary>
+  /// 単語ごとの長さ（正規化後）。SoA 列と同じ長さまで 0 で埋める。
+  /// </summary>
+  Array<uint8> lengths_;
+
+  /// <summary>
+  /// 文字ごとの必要数の列（kKanaAlphabetSize 本 × column_stride_）
+  /// </summary>
+  Array<uint8> columns_;
+
+  /// <summary>
+  /// 列の長さ
+  /// </summary>
+  size_t column_stride_ = 0;
+
+  /// <summary>
+  /// 単語番号を長さの昇順に並べたもの
+  /// </summary>
+  Array<uint32> length_order_;
+
+  /// <summary>
+  /// length_order_ のうち、長さが n 以上の単語が始まる位置（添字 n）。末尾は単語数。
+  /// </summary>
+  Array<uint32> length_offsets_;
+
+  /// <summary>
+  /// 単語ごとの、RemoveWord で取り除かれたかどうか
+  /// </summary>
+  Array<bool> removed_;
+
+  /// <summary>
+  /// AddWord / RemoveWord で変更されたか
+  /// </summary>
+  bool is_patched_ = false;
+
+  /// <summary>
+  /// ビット集合・署名・削除近傍の補助索引。SIMD 走査など使わない方式では作らずに済むよう、それぞれ初めて参照したときに作る。
+  /// 複数のスレッドから参照されても1回だけ作るよう once_flag で守る。
+  /// </summary>
+  struct AuxiliaryIndexes
+  {
+    std::once_flag bitset_flag;
+    KanaBitsetIndex bitset;
+    std::once_flag anagram_flag;
+    AnagramIndex anagram;
+    std::once_flag deletion_flag;
+    DeletionIndex deletion;
+  };
+
+  /// <summary>
+  /// 補助索引。コピーした索引とは共有し、どちらかを変更したときに新しいもの（未作成）に差し替える。
+  /// </summary>
+  std::shared_ptr<AuxiliaryIndexes> auxiliary_ = std::make_shared<AuxiliaryIndexes>();
+};
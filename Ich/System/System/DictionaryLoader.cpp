@@ -0,0 +1,271 @@
+﻿#include "./DictionaryLoader.h"
+#include "./MemoryMappedFile.h"
+#include "./WorkerPool.h"
+
+#include <algorithm>
+#include <string_view>
+
+namespace
+{
+  /// <summary>
+  /// 1つの塊を読み取った結果。単語の終わりの位置だけを持ち、結合時に通しの位置へ直す。
+  /// </summary>
+  struct ChunkResult
+  {
+    Array<char32> characters;
+    Array<uint32> word_ends;
+    Array<KanaId> kana_ids;
+    Array<uint32> kana_ends;
+    size_t rejected_line_count = 0;
+  };
+
+  /// <summary>
+  /// 取り除く前後の空白（半角空白・タブ・全角空白）か。
+  /// </summary>
+  constexpr bool IsBlank(const char32 ch)
+  {
+    return ch == U' ' || ch == U'\t' || ch == U'\r' || ch == U'　';
+  }
+
+  /// <summary>
+  /// [pos, end) の先頭から UTF-8 の1文字を復号して pos を進める。不正な並びは U+FFFD として1バイト進める。
+  /// </summary>
+  char32 DecodeUtf8(const uint8*& pos, const uint8* end)
+  {
+    const uint8 lead = *pos;
+    if (lead < 0x80)
+    {
+      ++pos;
+      return lead;
+    }
+
+    size_t length = 0;
+    char32 ch = 0;
+    if ((lead & 0xE0) == 0xC0)
+    {
+      length = 2;
+      ch = lead & 0x1F;
+    }
+    else if ((lead & 0xF0) == 0xE0)
+    {
+      length = 3;
+      ch = lead & 0x0F;
+    }
+    else if ((lead & 0xF8) == 0xF0)
+    {
+      length = 4;
+      ch = lead & 0x07;
+    }
+
+    if (length == 0 || static_cast<size_t>(end - pos) < length)
+    {
+      ++pos;
+      return U'\uFFFD';
+    }
+
+    for (size_t i = 1; i < length; ++i)
+    {
+      if ((pos[i] & 0xC0) != 0x80)
+      {
+        ++pos;
+        return U'\uFFFD';
+      }
+      ch = (ch << 6) | (pos[i] & 0x3F);
+    }
+
+    pos += length;
+    return ch;
+  }
+
+  /// <summary>
+  /// 1行（改行を含まない）を復号・正規化して塊の結果に追加する。
+  /// </summary>
+  void ParseLine(const uint8* begin, const uint8* end, ChunkResult& result)
+  {
+    const size_t wordStart = result.characters.size();
+    const size_t kanaStart = result.kana_ids.size();
+
+    while (begin != end)
+    {
+      result.characters << DecodeUtf8(begin, end);
+    }
+
+    // 前後の空白を取り除く。
+    auto first = result.characters.begin() + wordStart;
+    auto last = result.characters.end();
+    while (first != last && IsBlank(*first))
+    {
+      ++first;
+    }
+    while (first != last && IsBlank(*(last - 1)))
+    {
+      --last;
+    }
+    result.characters.erase(last, result.characters.end());
+    result.characters.erase(result.characters.begin() + wordStart, first);
+
+    if (result.characters.size() == wordStart || result.characters[wordStart] == U'#')
+    {
+      result.characters.resize(wordStart);
+      return;
+    }
+
+    bool isValid = true;
+    for (size_t i = wordStart; i < result.characters.size(); ++i)
+    {
+      const char32 normalized = NormalizeKanaCode(result.characters[i]);
+      if (normalized == kSkipKanaCode)
+      {
+        continue;
+      }
+
+      const KanaId id = ToKanaId(normalized);
+      if (id == kInvalidKanaId)
+      {
+        isValid = false;
+        break;
+      }
+
+      result.kana_ids << id;
+    }
+
+    // 長さは uint8 で数え、255 は取り除いた単語の印（DictionaryIndex::kRemovedLength）なので、
+    // 文字が1つもない単語と 255 文字以上の単語も読み飛ばす。
+    const size_t kanaLength = result.kana_ids.size() - kanaStart;
+    if (!isValid || kanaLength == 0 || kanaLength >= DictionaryIndex::kRemovedLength)
+    {
+      result.characters.resize(wordStart);
+      result.kana_ids.resize(kanaStart);
+      ++result.rejected_line_count;
+      return;
+    }
+
+    result.word_ends << static_cast<uint32>(result.characters.size());
+    result.kana_ends << static_cast<uint32>(result.kana_ids.size());
+  }
+
+  /// <summary>
+  /// [begin, end) の行をすべて読み取る。
+  /// </summary>
+  void ParseChunk(const uint8* begin, const uint8* end, ChunkResult& result)
+  {
+    // 1行あたり数文字の単語が多いので、バイト数の半分程度を目安に確保しておく。
+    result.characters.reserve((end - begin) / 2);
+    result.kana_ids.reserve((end - begin) / 2);
+
+    while (begin < end)
+    {
+      const uint8* lineEnd = std::find(begin, end, static_cast<uint8>('\n'));
+      ParseLine(begin, lineEnd, result);
+      begin = (lineEnd == end) ? end : lineEnd + 1;
+    }
+  }
+} // namespace
+
+namespace DictionaryLoader
+{
+  WordList ParseWordList(std::span<const uint8> text, const size_t minChunkBytes)
+  {
+    constexpr uint8 kByteOrderMark[] = { 0xEF, 0xBB, 0xBF };
+    if (text.size() >= 3 && std::equal(std::begin(kByteOrderMark), std::end(kByteOrderMark), text.begin()))
+    {
+      text = text.subspan(3);
+    }
+
+    // 塊が1つで済むなら WorkerPool は使わず、このスレッドで処理する。
+    const size_t splitCount = text.size() / std::max<size_t>(minChunkBytes, 1);
+    WorkerPool* pool = (splitCount > 1) ? WorkerPool::GetInstance() : nullptr;
+    const size_t chunkCount = (pool != nullptr) ? std::min(splitCount, pool->GetConcurrency() * 4) : 1;
+
+    // 行の途中で切らないよう、おおよその等分位置から次の改行の直後まで境界をずらす。
+
+    Array<size_t> bounds{ 0 };
+    for (size_t i = 1; i < chunkCount; ++i)
+    {
+      const size_t target = std::max(text.size() * i / chunkCount, bounds.back());
+      const auto newline = std::find(text.begin() + target, text.end(), static_cast<uint8>('\n'));
+      bounds << ((newline == text.end()) ? text.size() : static_cast<size_t>(newline - text.begin()) + 1);
+    }
+    bounds << text.size();
+
+    Array<ChunkResult> chunks(chunkCount);
+    if (pool != nullptr)
+    {
+      pool->ParallelFor(chunkCount, [&](const size_t chunk)
+      {
+        ParseChunk(text.data() + bounds[chunk], text.data() + bounds[chunk + 1], chunks[chunk]);
+      });
+    }
+    else
+    {
+      ParseChunk(text.data(), text.data() + text.size(), chunks[0]);
+    }
+
+    // 塊の順に結合し、同じ表記の単語は最初のものだけを残す。
+    size_t totalWords = 0;
+    size_t totalCharacters = 0;
+    size_t totalKana = 0;
+    for (const auto& chunk : chunks)
+    {
+      totalWords += chunk.word_ends.size();
+      totalCharacters += chunk.characters.size();
+      totalKana += chunk.kana_ids.size();
+    }
+
+    WordList wordList;
+    wordList.characters.reserve(totalCharacters);
+    wordList.word_offsets.reserve(totalWords + 1);
+    wordList.kana_ids.reserve(totalKana);
+    wordList.kana_offsets.reserve(totalWords + 1);
+
+    HashSet<std::u32string_view> seen;
+    seen.reserve(totalWords);
+
+    for (const auto& chunk : chunks)
+    {
+      wordList.rejected_line_count += chunk.rejected_line_count;
+
+      uint32 wordBegin = 0;
+      uint32 kanaBegin = 0;
+      for (size_t i = 0; i < chunk.word_ends.size(); ++i)
+      {
+        const std::u32string_view word{ chunk.characters.data() + wordBegin, static_cast<size_t>(chunk.word_ends[i] - wordBegin) };
+        if (seen.insert(word).second)
+        {
+          wordList.characters.insert(wordList.characters.end(), word.begin(), word.end());
+          wordList.word_offsets << static_cast<uint32>(wordList.characters.size());
+          wordList.kana_ids.insert(wordList.kana_ids.end(), chunk.kana_ids.begin() + kanaBegin, chunk.kana_ids.begin() + chunk.kana_ends[i]);
+          wordList.kana_offsets << static_cast<uint32>(wordList.kana_ids.size());
+        }
+
+        wordBegin = chunk.word_ends[i];
+        kanaBegin = chunk.kana_ends[i];
+      }
+    }
+
+    return wordList;
+  }
+
+  Optional<WordList> LoadWordList(const FilePathView path, const size_t minChunkBytes)
+  {
+    MemoryMappedFile file;
+    if (!file.Open(path))
+    {
+      return none;
+    }
+
+    return ParseWordList(std::span<const uint8>(file.GetData(), file.GetSize()), minChunkBytes);
+  }
+
+  DictionaryIndex BuildIndex(const WordList& wordList)
+  {
+    Array<std::u32string_view> words;
+    words.reserve(wordList.GetWordCount());
+    for (size_t i = 0; i < wordList.GetWordCount(); ++i)
+    {
+      words << wordList.GetWord(i);
+    }
+
+    return DictionaryIndex{ words, wordList.kana_ids, wordList.kana_offsets };
+  }
+}
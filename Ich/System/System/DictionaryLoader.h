@@ -0,0 +1,93 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./DictionaryIndex.h"
+#include "./KanaTable.h"
+
+#include <limits>
+#include <span>
+#include <string_view>
+
+/// <summary>
+/// ユーザーや MOD が用意した単語一覧（UTF-8、1行1語）を高速に読み込む処理。
+/// ファイルを割り当てて改行位置で複数の塊に分け、塊ごとに WorkerPool 上で UTF-8 の復号と正規化を行ってから、
+/// 重複を取り除いて DictionaryIndex に渡せる形へまとめる。行ごとに String を作らないので、数十万行でも場面の読み込み中に収まる。
+/// </summary>
+namespace DictionaryLoader
+{
+  /// <summary>
+  /// 1つの塊の最小バイト数。これより小さいファイルは分割せずに処理する。
+  /// </summary>
+  inline constexpr size_t kMinChunkBytes = 64 * 1024;
+
+  /// <summary>
+  /// minChunkBytes に渡すと、分割せずに呼び出し元スレッドだけで処理する（WorkerPool を使わない）。
+  /// 背景スレッドで読み込むときに、メインスレッドの並列処理を待たせないために使う。
+  /// </summary>
+  inline constexpr size_t kNoSplit = std::numeric_limits<size_t>::max();
+
+  /// <summary>
+  /// 読み込んだ単語一覧。表記と正規化後の文字IDをそれぞれ1つの配列に続けて並べる。
+  /// </summary>
+  struct WordList
+  {
+    /// <summary>
+    /// 全単語の表記を続けて並べたもの
+    /// </summary>
+    Array<char32> characters;
+
+    /// <summary>
+    /// 単語 i の表記は characters の [word_offsets[i], word_offsets[i + 1]) 番目（要素数は単語数 + 1）
+    /// </summary>
+    Array<uint32> word_offsets{ 0 };
+
+    /// <summary>
+    /// 全単語の正規化後の文字IDを続けて並べたもの（長音記号は含まない）
+    /// </summary>
+    Array<KanaId> kana_ids;
+
+    /// <summary>
+    /// 単語 i の文字IDは kana_ids の [kana_offsets[i], kana_offsets[i + 1]) 番目（要素数は単語数 + 1）
+    /// </summary>
+    Array<uint32> kana_offsets{ 0 };
+
+    /// <summary>
+    /// ひらがな以外の文字を含む・文字が1つもないなどの理由で読み飛ばした行の数（空行・# で始まる行は数えない）
+    /// </summary>
+    size_t rejected_line_count = 0;
+
+    /// <summary>
+    /// 単語数を返す。
+    /// </summary>
+    size_t GetWordCount() const { return word_offsets.size() - 1; }
+
+    /// <summary>
+    /// 単語の表記を返す。
+    /// </summary>
+    std::u32string_view GetWord(const size_t index) const
+    {
+      return std::u32string_view{ characters.data() + word_offsets[index], static_cast<size_t>(word_offsets[index + 1] - word_offsets[index]) };
+    }
+  };
+
+  /// <summary>
+  /// UTF-8 のテキストを1行1語として読み取る。先頭の BOM・行末の CR・前後の空白を取り除き、空行と # で始まる行は無視する。
+  /// 同じ表記の単語は最初に現れたものだけを残す。
+  /// </summary>
+  /// <param name="text">UTF-8 のテキスト。</param>
+  /// <param name="minChunkBytes">1つの塊の最小バイト数。</param>
+  WordList ParseWordList(std::span<const uint8> text, size_t minChunkBytes = kMinChunkBytes);
+
+  /// <summary>
+  /// ファイルを割り当てて ParseWordList で読み取る。
+  /// </summary>
+  /// <param name="minChunkBytes">1つの塊の最小バイト数。</param>
+  /// <returns>ファイルを開けない、または空の場合は none。</returns>
+  Optional<WordList> LoadWordList(FilePathView path, size_t minChunkBytes = kMinChunkBytes);
+
+  /// <summary>
+  /// 読み込んだ単語一覧から辞書索引を作る。正規化は済んでいるので、文字IDから文字数を数えるだけで済む。
+  /// </summary>
+  DictionaryIndex BuildIndex(const WordList& wordList);
+}
@@ -0,0 +1,366 @@
+﻿#include "./IncrementalWordMatcher.h"
+#include "./BlockManager.h"
+#include "./DictionaryIndex.h"
+
+#include <algorithm>
+
+namespace
+{
+  /// <summary>
+  /// 集合に含まれていないことを表す格納位置
+  /// </summary>
+  constexpr uint32 kNoSlot = 0xFFFFFFFFu;
+
+  /// <summary>
+  /// ブロック内の各文字を正規化し、アルファベット内の文字ごとに処理を呼び出す。
+  /// </summary>
+  template <class Function>
+  void ForEachKana(const String& block, Function function)
+  {
+    for (const char32 ch : block)
+    {
+      if (const auto normalized = NormalizeKanaChar(ch))
+      {
+        if (const KanaId id = ToKanaId(*normalized); id != kInvalidKanaId)
+        {
+          function(id);
+        }
+      }
+    }
+  }
+} // namespace
+
+IncrementalWordMatcher::IncrementalWordMatcher(const DictionaryIndex& index)
+  : index_(&index)
+{
+  const size_t wordCount = index.GetWordCount();
+
+  // 文字ごとの転置リストを作る（件数を数えてから詰める）。取り除かれた単語は含めない。
+  std::array<uint32, kKanaAlphabetSize> sizes{};
+  for (size_t word = 0; word < wordCount; ++word)
+  {
+    if (index.IsRemoved(word))
+    {
+      continue;
+    }
+
+    const KanaCounts& counts = index.GetCounts(word);
+    for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+    {
+      sizes[id] += (counts[id] > 0) ? 1 : 0;
+    }
+  }
+
+  for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+  {
+    postings_[id].reserve(sizes[id]);
+  }
+
+  for (size_t word = 0; word < wordCount; ++word)
+  {
+    if (index.IsRemoved(word))
+    {
+      continue;
+    }
+
+    const KanaCounts& counts = index.GetCounts(word);
+    for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+    {
+      if (counts[id] > 0)
+      {
+        postings_[id] << Posting{ static_cast<uint32>(word), counts[id] };
+      }
+    }
+  }
+
+  for (auto& postings : postings_)
+  {
+    std::stable_sort(postings.begin(), postings.end(),
+      [](const Posting& a, const Posting& b) { return a.required > b.required; });
+  }
+
+  deficits_.resize(wordCount);
+  hit_slots_.resize(wordCount);
+  reach_slots_.resize(wordCount);
+
+  Reset();
+}
+
+void IncrementalWordMatcher::Push(const String& block)
+{
+  ForEachKana(block, [this](const KanaId id) { Push(id); });
+}
+
+void IncrementalWordMatcher::Evict(const String& block)
+{
+  ForEachKana(block, [this](const KanaId id) { Evict(id); });
+}
+
+void IncrementalWordMatcher::Push(const KanaId id)
+{
+  if (id >= kKanaAlphabetSize || held_[id] == 0xFF)
+  {
+    return;
+  }
+
+  // 手持ちが h 個になったとき、その文字を h 個以上必要とする単語だけ不足数が 1 減る。
+  const uint8 held = ++held_[id];
+
+  for (const Posting& posting : postings_[id])
+  {
+    if (posting.required < held)
+    {
+      break;
+    }
+
+    UpdateDeficit(posting.word, static_cast<uint8>(deficits_[posting.word] - 1));
+  }
+
+  ++revision_;
+}
+
+void IncrementalWordMatcher::Evict(const KanaId id)
+{
+  if (id >= kKanaAlphabetSize || held_[id] == 0)
+  {
+    return;
+  }
+
+  // 手持ちが h 個から減ったとき、その文字を h 個以上必要とする単語だけ不足数が 1 増える。
+  const uint8 held = held_[id]--;
+
+  for (const Posting& posting : postings_[id])
+  {
+    if (posting.required < held)
+    {
+      break;
+    }
+
+    UpdateDeficit(posting.word, static_cast<uint8>(deficits_[posting.word] + 1));
+  }
+
+  ++revision_;
+}
+
+void IncrementalWordMatcher::Reset()
+{
+  held_.fill(0);
+  hit_ids_.clear();
+  reach_ids_.clear();
+  std::fill(hit_slots_.begin(), hit_slots_.end(), kNoSlot);
+  std::fill(reach_slots_.begin(), reach_slots_.end(), kNoSlot);
+
+  for (size_t word = 0; word < deficits_.size(); ++word)
+  {
+    // 手持ちが空なら不足数は単語の長さそのもの。
+    deficits_[word] = index_->GetLength(word);
+
+    if (deficits_[word] == 0)
+    {
+      AddToSet(hit_ids_, hit_slots_, static_cast<uint32>(word));
+    }
+    else if (deficits_[word] == 1)
+    {
+      AddToSet(reach_ids_, reach_slots_, static_cast<uint32>(word));
+    }
+  }
+
+  ++revision_;
+}
+
+void IncrementalWordMatcher::AddWord(const uint32 word)
+{
+  AddWords(std::span<const uint32>(&word, 1));
+}
+
+void IncrementalWordMatcher::AddWords(const std::span<const uint32> words)
+{
+  // 転置リストには末尾にまとめて足し、最後に文字ごとに1回だけ並べ直す（1語ずつ挿入すると毎回後ろをずらすことになる）。
+  std::array<size_t, kKanaAlphabetSize> sortedSizes{};
+  for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+  {
+    sortedSizes[id] = postings_[id].size();
+  }
+
+  for (const uint32 word : words)
+  {
+    if (word >= deficits_.size())
+    {
+      deficits_.resize(word + 1, DictionaryIndex::kRemovedLength);
+      hit_slots_.resize(word + 1, kNoSlot);
+      reach_slots_.resize(word + 1, kNoSlot);
+    }
+
+    const KanaCounts& counts = index_->GetCounts(word);
+    uint8 deficit = 0;
+
+    for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+    {
+      if (counts[id] == 0)
+      {
+        continue;
+      }
+
+      postings_[id] << Posting{ word, counts[id] };
+
+      if (counts[id] > held_[id])
+      {
+        deficit = static_cast<uint8>(std::min<int32>(deficit + counts[id] - held_[id], DictionaryIndex::kRemovedLength - 1));
+      }
+    }
+
+    // 追加前は集合に入っていない状態（不足数 kRemovedLength）から移す。
+    deficits_[word] = DictionaryIndex::kRemovedLength;
+    UpdateDeficit(word, deficit);
+  }
+
+  for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+  {
+    auto& postings = postings_[id];
+    if (postings.size() == sortedSizes[id])
+    {
+      continue;
+    }
+
+    const auto middle = postings.begin() + sortedSizes[id];
+    std::sort(middle, postings.end(), PostingBefore);
+    std::inplace_merge(postings.begin(), middle, postings.end(), PostingBefore);
+  }
+
+  ++revision_;
+}
+
+void IncrementalWordMatcher::RemoveWord(const uint32 word)
+{
+  RemoveWords(std::span<const uint32>(&word, 1));
+}
+
+void IncrementalWordMatcher::RemoveWords(const std::span<const uint32> words)
+{
+  // 取り除く単語を集合から外して不足数を kRemovedLength にしておき、転置リストは文字ごとに1回だけ詰める。
+  std::array<bool, kKanaAlphabetSize> touched{};
+  bool removedAny = false;
+
+  for (const uint32 word : words)
+  {
+    if (word >= deficits_.size() || deficits_[word] == DictionaryIndex::kRemovedLength)
+    {
+      continue;
+    }
+
+    const KanaCounts& counts = index_->GetCounts(word);
+    for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+    {
+      touched[id] |= (counts[id] != 0);
+    }
+
+    UpdateDeficit(word, DictionaryIndex::kRemovedLength);
+    removedAny = true;
+  }
+
+  if (!removedAny)
+  {
+    return;
+  }
+
+  for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+  {
+    if (!touched[id])
+    {
+      continue;
+    }
+
+    auto& postings = postings_[id];
+    postings.erase(std::remove_if(postings.begin(), postings.end(),
+      [this](const Posting& posting) { return deficits_[posting.word] == DictionaryIndex::kRemovedLength; }), postings.end());
+  }
+
+  ++revision_;
+}
+
+Array<String> IncrementalWordMatcher::GetHitWords() const
+{
+  Array<uint32> ids = hit_ids_;
+  std::sort(ids.begin(), ids.end());
+
+  Array<String> result;
+  result.reserve(ids.size());
+
+  for (const uint32 id : ids)
+  {
+    result << String{ index_->GetWord(id) };
+  }
+
+  return result;
+}
+
+Array<std::pair<String, String>> IncrementalWordMatcher::GetReachWords() const
+{
+  Array<uint32> ids = reach_ids_;
+  std::sort(ids.begin(), ids.end());
+
+  Array<std::pair<String, String>> result;
+  result.reserve(ids.size());
+
+  for (const uint32 id : ids)
+  {
+    const KanaId missing = index_->FindMissingKana(id, held_);
+    result.emplace_back(String{ index_->GetWord(id) }, index_->GetMissingCharacter(id, missing, held_));
+  }
+
+  return result;
+}
+
+void IncrementalWordMatcher::QueryMatches(WordMatchBuffers& buffers, const bool pickHint) const
+{
+  buffers.Clear();
+
+  buffers.hit_ids.assign(hit_ids_.begin(), hit_ids_.end());
+  std::sort(buffers.hit_ids.begin(), buffers.hit_ids.end());
+
+  buffers.reach_ids.assign(reach_ids_.begin(), reach_ids_.end());
+  std::sort(buffers.reach_ids.begin(), buffers.reach_ids.end());
+
+  BlockManager::FillReachDetails(*index_, held_, buffers, pickHint);
+}
+
+void IncrementalWordMatcher::UpdateDeficit(const uint32 word, const uint8 deficit)
+{
+  const uint8 previous = deficits_[word];
+  deficits_[word] = deficit;
+
+  if (previous == 0)
+  {
+    RemoveFromSet(hit_ids_, hit_slots_, word);
+  }
+  else if (previous == 1)
+  {
+    RemoveFromSet(reach_ids_, reach_slots_, word);
+  }
+
+  if (deficit == 0)
+  {
+    AddToSet(hit_ids_, hit_slots_, word);
+  }
+  else if (deficit == 1)
+  {
+    AddToSet(reach_ids_, reach_slots_, word);
+  }
+}
+
+void IncrementalWordMatcher::AddToSet(Array<uint32>& ids, Array<uint32>& slots, const uint32 word)
+{
+  slots[word] = static_cast<uint32>(ids.size());
+  ids.push_back(word);
+}
+
+void IncrementalWordMatcher::RemoveFromSet(Array<uint32>& ids, Array<uint32>& slots, const uint32 word)
+{
+  // 末尾の要素を空いた位置へ移して O(1) で取り除く。
+  const uint32 slot = slots[word];
+  const uint32 last = ids.back();
+  ids[slot] = last;
+  slots[last] = slot;
+  ids.pop_back();
+  slots[word] = kNoSlot;
+}
@@ -0,0 +1,160 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+#include <span>
+#include <utility>
+
+#include "./KanaTable.h"
+#include "./WordMatchBuffers.h"
+
+class DictionaryIndex;
+
+/// <summary>
+/// 手持ちブロックの増減（1 文字追加・先頭 1 文字削除）に合わせて、ヒット／リーチの単語集合を差分更新する判定器。
+/// 単語ごとに「あと何文字足りないか（不足数）」を保持し、変化した文字を含む単語だけを更新するため、
+/// 1 回の更新コストは辞書全体ではなく変化した文字を含む単語数に比例する。
+/// </summary>
+/// <remarks>
+/// 構築に使った DictionaryIndex は、この判定器より長く生存している必要がある。
+/// </remarks>
+class IncrementalWordMatcher
+{
+public:
+  /// <summary>
+  /// 手持ちが空の状態で判定器を構築する。
+  /// </summary>
+  explicit IncrementalWordMatcher(const DictionaryIndex& index);
+
+  /// <summary>
+  /// ブロックを手持ちに加える。ブロック内の各文字を正規化して数える（長音記号・アルファベット外の文字は無視）。
+  /// </summary>
+  void Push(const String& block);
+
+  /// <summary>
+  /// ブロックを手持ちから取り除く。Push したブロックと同じものを渡すこと。
+  /// </summary>
+  void Evict(const String& block);
+
+  /// <summary>
+  /// 正規化済みの文字を1つ手持ちに加える。
+  /// </summary>
+  void Push(KanaId id);
+
+  /// <summary>
+  /// 正規化済みの文字を1つ手持ちから取り除く。手持ちにない文字は無視する。
+  /// </summary>
+  void Evict(KanaId id);
+
+  /// <summary>
+  /// 手持ちを空に戻す。
+  /// </summary>
+  void Reset();
+
+  /// <summary>
+  /// DictionaryIndex::AddWord で追加した単語を判定対象に加える。索引への追加を済ませてから呼ぶこと。
+  /// 転置リストへの挿入と、現在の手持ちに対する不足数の計算だけを行う。
+  /// </summary>
+  void AddWord(uint32 word);
+
+  /// <summary>
+  /// DictionaryIndex::AddWords で追加した単語をまとめて判定対象に加える。転置リストは文字ごとに1回だけ並べ直す。
+  /// </summary>
+  void AddWords(std::span<const uint32> words);
+
+  /// <summary>
+  /// 単語を判定対象から外す。DictionaryIndex::RemoveWord の前後どちらで呼んでもよい（文字数は索引に残っている）。
+  /// </summary>
+  void RemoveWord(uint32 word);
+
+  /// <summary>
+  /// 複数の単語をまとめて判定対象から外す。転置リストは文字ごとに1回だけ詰め直す。
+  /// </summary>
+  void RemoveWords(std::span<const uint32> words);
+
+  /// <summary>
+  /// 現在の手持ちの文字数を返す。
+  /// </summary>
+  const KanaCounts& GetHeldCounts() const { return held_; }
+
+  /// <summary>
+  /// 手持ちが変化するたびに増える番号。判定結果をキャッシュする側で変化の検出に使う。
+  /// </summary>
+  uint64 GetRevision() const { return revision_; }
+
+  /// <summary>
+  /// ヒットしている単語番号の一覧（順不同）。
+  /// </summary>
+  const Array<uint32>& GetHitIds() const { return hit_ids_; }
+
+  /// <summary>
+  /// リーチ状態の単語番号の一覧（順不同）。
+  /// </summary>
+  const Array<uint32>& GetReachIds() const { return reach_ids_; }
+
+  /// <summary>
+  /// ヒットしている単語を辞書順で返す。BlockManager::GetHitWords と同じ結果になる。
+  /// </summary>
+  Array<String> GetHitWords() const;
+
+  /// <summary>
+  /// リーチ状態の単語と不足文字（辞書の表記に合わせた1文字）を辞書順で返す。
+  /// BlockManager::GetReachWords と同じ結果になる。
+  /// </summary>
+  Array<std::pair<String, String>> GetReachWords() const;
+
+  /// <summary>
+  /// 現在のヒット・リーチ（とヒント）を辞書順の単語番号で buffers に書き込む。BlockManager::QueryMatches と同じ結果になる。
+  /// </summary>
+  void QueryMatches(WordMatchBuffers& buffers, bool pickHint) const;
+
+private:
+  /// <summary>
+  /// 文字ごとの転置リストの1要素（その文字を含む単語と必要数）
+  /// </summary>
+  struct Posting
+  {
+    uint32 word;
+    uint8 required;
+  };
+
+  /// <summary>
+  /// 単語の不足数を変更し、ヒット／リーチ集合への出入りを反映する。
+  /// </summary>
+  void UpdateDeficit(uint32 word, uint8 deficit);
+
+  /// <summary>
+  /// 集合（順不同の配列 + 単語ごとの格納位置）に単語を加える／取り除く。
+  /// </summary>
+  static void AddToSet(Array<uint32>& ids, Array<uint32>& slots, uint32 word);
+  static void RemoveFromSet(Array<uint32>& ids, Array<uint32>& slots, uint32 word);
+
+  const DictionaryIndex* index_;
+
+  /// <summary>
+  /// 並び順（必要数の多い順、同じ必要数の中では単語番号順）で a が b より前か。
+  /// </summary>
+  static bool PostingBefore(const Posting& a, const Posting& b)
+  {
+    return (a.required != b.required) ? (a.required > b.required) : (a.word < b.word);
+  }
+
+  /// <summary>
+  /// 文字ごとの転置リスト。必要数の多い順に並べ、更新時に途中で打ち切れるようにする。
+  /// 単語の追加・削除で1つのリストだけを挿入・削除できるよう、文字ごとに別の配列で持つ。
+  /// </summary>
+  std::array<Array<Posting>, kKanaAlphabetSize> postings_;
+
+  /// <summary>
+  /// 単語ごとの不足数
+  /// </summary>
+  Array<uint8> deficits_;
+
+  KanaCounts held_{};
+
+  Array<uint32> hit_ids_;
+  Array<uint32> hit_slots_;
+  Array<uint32> reach_ids_;
+  Array<uint32> reach_slots_;
+
+  uint64 revision_ = 0;
+};
@@ -0,0 +1,131 @@
+﻿#include "./KanaAliasTable.h"
+#include "./DictionaryIndex.h"
+
+#include <algorithm>
+
+namespace
+{
+  /// <summary>
+  /// 辞書全体での文字の出現回数
+  /// </summary>
+  std::array<uint64, kKanaAlphabetSize> CountKana(const DictionaryIndex& index)
+  {
+    std::array<uint64, kKanaAlphabetSize> weights{};
+
+    for (size_t word = 0; word < index.GetWordCount(); ++word)
+    {
+      if (index.IsRemoved(word))
+      {
+        continue;
+      }
+
+      const KanaCounts& counts = index.GetCounts(word);
+      for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+      {
+        weights[id] += counts[id];
+      }
+    }
+
+    return weights;
+  }
+} // namespace
+
+KanaAliasTable::KanaAliasTable()
+{
+  for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+  {
+    aliases_[id] = static_cast<KanaId>(id);
+  }
+}
+
+KanaAliasTable::KanaAliasTable(const std::array<uint64, kKanaAlphabetSize>& weights)
+  : KanaAliasTable()
+{
+  uint64 total = 0;
+  for (const uint64 weight : weights)
+  {
+    total += weight;
+  }
+
+  if (total == 0)
+  {
+    return;
+  }
+  is_empty_ = false;
+
+  // 各列の平均が 1 になるよう重みを拡大し、1 未満の列に 1 を超える列の余りを割り当てる（Vose の方法）。
+  std::array<double, kKanaAlphabetSize> scaled{};
+  Array<KanaId> small;
+  Array<KanaId> large;
+
+  for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+  {
+    scaled[id] = static_cast<double>(weights[id]) * kKanaAlphabetSize / static_cast<double>(total);
+    ((scaled[id] < 1.0) ? small : large) << static_cast<KanaId>(id);
+  }
+
+  while (!small.isEmpty() && !large.isEmpty())
+  {
+    const KanaId less = small.back();
+    small.pop_back();
+    const KanaId more = large.back();
+
+    thresholds_[less] = scaled[less];
+    aliases_[less] = more;
+
+    scaled[more] -= (1.0 - scaled[less]);
+    if (scaled[more] < 1.0)
+    {
+      large.pop_back();
+      small << more;
+    }
+  }
+
+  // 丸め誤差で残った列は、その列の文字を必ず選ぶ（重み 0 の文字は選ばない）。
+  const KanaId fallback = static_cast<KanaId>(std::find_if(weights.begin(), weights.end(), [](const uint64 weight) { return weight > 0; }) - weights.begin());
+  for (const KanaId id : large)
+  {
+    thresholds_[id] = 1.0;
+  }
+  for (const KanaId id : small)
+  {
+    thresholds_[id] = (weights[id] > 0) ? 1.0 : 0.0;
+    aliases_[id] = (weights[id] > 0) ? id : fallback;
+  }
+}
+
+KanaAliasTable::KanaAliasTable(const DictionaryIndex& index)
+  : KanaAliasTable(CountKana(index))
+{
+}
+
+KanaId KanaAliasTable::Sample() const
+{
+  if (is_empty_)
+  {
+    return kInvalidKanaId;
+  }
+
+  const size_t column = Random(size_t{ 0 }, kKanaAlphabetSize - 1);
+  return (Random() < thresholds_[column]) ? static_cast<KanaId>(column) : aliases_[column];
+}
+
+double KanaAliasTable::GetProbability(const KanaId id) const
+{
+  if (is_empty_ || id >= kKanaAlphabetSize)
+  {
+    return 0.0;
+  }
+
+  // 自分の列で選ばれる確率と、他の列の別名として選ばれる確率の和
+  double probability = thresholds_[id];
+  for (size_t column = 0; column < kKanaAlphabetSize; ++column)
+  {
+    if (column != id && aliases_[column] == id)
+    {
+      probability += 1.0 - thresholds_[column];
+    }
+  }
+
+  return probability / kKanaAlphabetSize;
+}
@@ -0,0 +1,56 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./KanaTable.h"
+
+#include <array>
+
+class DictionaryIndex;
+
+/// <summary>
+/// 文字ごとの重みに比例した確率で、正規化済みの文字を1つ O(1) で選ぶための別名表（Walker の alias method）。
+/// 表は文字の種類数（48）分だけなので、一度作れば辞書の大きさによらず使い回せる。
+/// </summary>
+class KanaAliasTable
+{
+public:
+  /// <summary>
+  /// 空の表。IsEmpty() が true になり、Sample は kInvalidKanaId を返す。
+  /// </summary>
+  KanaAliasTable();
+
+  /// <summary>
+  /// 文字ごとの重みから表を作る。
+  /// </summary>
+  explicit KanaAliasTable(const std::array<uint64, kKanaAlphabetSize>& weights);
+
+  /// <summary>
+  /// 辞書全体での文字の出現回数（取り除かれた単語を除く）を重みにして表を作る。
+  /// </summary>
+  explicit KanaAliasTable(const DictionaryIndex& index);
+
+  /// <summary>
+  /// 重みがすべて 0 か。
+  /// </summary>
+  bool IsEmpty() const { return is_empty_; }
+
+  /// <summary>
+  /// 重みに比例した確率で文字を1つ選ぶ。
+  /// </summary>
+  KanaId Sample() const;
+
+  /// <summary>
+  /// 文字が選ばれる確率を返す。
+  /// </summary>
+  double GetProbability(KanaId id) const;
+
+private:
+  /// <summary>
+  /// 列ごとに、その列の文字を選ぶ確率と、選ばなかったときの別名の文字
+  /// </summary>
+  std::array<double, kKanaAlphabetSize> thresholds_{};
+  std::array<KanaId, kKanaAlphabetSize> aliases_{};
+
+  bool is_empty_ = true;
+};
@@ -0,0 +1,107 @@
+﻿#include "./KanaBitsetIndex.h"
+#include "./DictionaryIndex.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace
+{
+  /// <summary>
+  /// 一度にまとめて処理する uint64 の個数（= 512 単語）。途中結果をスタック上に置ける大きさにする。
+  /// </summary>
+  constexpr size_t kChunkLength = 8;
+
+  /// <summary>
+  /// ビットが立っている位置を単語番号として書き出す。
+  /// </summary>
+  void EmitBits(uint64 bits, const size_t base, Array<uint32>* output)
+  {
+    while (bits != 0)
+    {
+      output->push_back(static_cast<uint32>(base + std::countr_zero(bits)));
+      bits &= (bits - 1);
+    }
+  }
+} // namespace
+
+KanaBitsetIndex::KanaBitsetIndex() = default;
+
+KanaBitsetIndex::KanaBitsetIndex(const DictionaryIndex& index)
+  : word_count_(index.GetWordCount())
+  , bitset_length_((index.GetWordCount() + 63) / 64)
+{
+  for (size_t word = 0; word < word_count_; ++word)
+  {
+    const KanaCounts& counts = index.GetCounts(word);
+    for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+    {
+      max_counts_[id] = std::max(max_counts_[id], counts[id]);
+    }
+  }
+
+  uint32 bitsetCount = 0;
+  for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+  {
+    first_bitsets_[id] = bitsetCount;
+    bitsetCount += max_counts_[id];
+  }
+
+  bits_.assign(bitsetCount * bitset_length_, 0);
+
+  for (size_t word = 0; word < word_count_; ++word)
+  {
+    const KanaCounts& counts = index.GetCounts(word);
+    const uint64 bit = uint64{ 1 } << (word % 64);
+
+    for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+    {
+      // 必要数が c の単語は、下限 1 ～ c のすべてのビット集合に含まれる。
+      for (size_t threshold = 1; threshold <= counts[id]; ++threshold)
+      {
+        bits_[(first_bitsets_[id] + threshold - 1) * bitset_length_ + word / 64] |= bit;
+      }
+    }
+  }
+}
+
+void KanaBitsetIndex::CollectMatches(const KanaCounts& held, Array<uint32>* hits, Array<uint32>* reaches) const
+{
+  for (size_t chunk = 0; chunk < bitset_length_; chunk += kChunkLength)
+  {
+    const size_t length = std::min(kChunkLength, bitset_length_ - chunk);
+
+    // ones: 1 つ以上の「満たせない下限」に含まれる単語 / twos: 2 つ以上に含まれる単語
+    uint64 ones[kChunkLength] = {};
+    uint64 twos[kChunkLength] = {};
+
+    for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+    {
+      for (size_t threshold = held[id] + 1; threshold <= max_counts_[id]; ++threshold)
+      {
+        const uint64* bitset = GetBitset(id, threshold) + chunk;
+
+        for (size_t i = 0; i < length; ++i)
+        {
+          twos[i] |= ones[i] & bitset[i];
+          ones[i] |= bitset[i];
+        }
+      }
+    }
+
+    for (size_t i = 0; i < length; ++i)
+    {
+      const size_t base = (chunk + i) * 64;
+      const size_t valid = std::min<size_t>(word_count_ - base, 64);
+      const uint64 validMask = (valid == 64) ? ~uint64{ 0 } : ((uint64{ 1 } << valid) - 1);
+
+      if (hits)
+      {
+        EmitBits(~ones[i] & validMask, base, hits);
+      }
+      if (reaches)
+      {
+        EmitBits(ones[i] & ~twos[i] & validMask, base, reaches);
+      }
+    }
+  }
+}
@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./KanaTable.h"
+
+class DictionaryIndex;
+
+/// <summary>
+/// (文字, 必要数の下限 t) ごとに「その文字を t 個以上必要とする単語」のビット集合を持つ転置索引。
+/// 単語の不足数は「手持ち数 h より大きい t について、単語を含むビット集合の数」に等しいため、
+/// ヒット（どれにも含まれない）とリーチ（ちょうど1つに含まれる）を 64 単語単位のビット演算で求められる。
+/// </summary>
+class KanaBitsetIndex
+{
+public:
+  KanaBitsetIndex();
+
+  /// <summary>
+  /// 辞書索引からビット集合を構築する。
+  /// </summary>
+  explicit KanaBitsetIndex(const DictionaryIndex& index);
+
+  /// <summary>
+  /// ヒットとリーチの単語番号を、それぞれ昇順で末尾に追加する。
+  /// </summary>
+  /// <param name="held">手持ちブロックの文字数。</param>
+  /// <param name="hits">ヒットした単語番号の追加先。不要なら nullptr。</param>
+  /// <param name="reaches">リーチの単語番号の追加先。不要なら nullptr。</param>
+  void CollectMatches(const KanaCounts& held, Array<uint32>* hits, Array<uint32>* reaches) const;
+
+private:
+  /// <summary>
+  /// 文字 id・下限 threshold（1 以上）のビット集合の先頭を返す。
+  /// </summary>
+  const uint64* GetBitset(size_t id, size_t threshold) const
+  {
+    return bits_.data() + (first_bitsets_[id] + threshold - 1) * bitset_length_;
+  }
+
+  /// <summary>
+  /// 単語数
+  /// </summary>
+  size_t word_count_ = 0;
+
+  /// <summary>
+  /// 1 つのビット集合の長さ（uint64 の個数）
+  /// </summary>
+  size_t bitset_length_ = 0;
+
+  /// <summary>
+  /// 文字ごとの必要数の最大値（= その文字のビット集合の数）
+  /// </summary>
+  KanaCounts max_counts_{};
+
+  /// <summary>
+  /// 文字ごとに、下限 1 のビット集合が何番目のビット集合か
+  /// </summary>
+  std::array<uint32, kKanaAlphabetSize> first_bitsets_{};
+
+  /// <summary>
+  /// 全ビット集合を連結したもの
+  /// </summary>
+  Array<uint64> bits_;
+};
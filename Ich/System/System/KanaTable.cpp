@@ -0,0 +1,84 @@
+﻿#include "./KanaTable.h"
+
+#include <cassert>
+
+namespace
+{
+  using KanaTableDetail::kKanaAlphabet;
+  using KanaTableDetail::kHiraganaFirst;
+  using KanaTableDetail::kHiraganaLast;
+
+  /// <summary>
+  /// 文字コードのひらがなブロック内オフセット -> KanaId の変換表。
+  /// </summary>
+  constexpr auto kKanaIdTable = []()
+  {
+    std::array<KanaId, kHiraganaLast - kHiraganaFirst + 1> table{};
+    table.fill(kInvalidKanaId);
+
+    for (size_t i = 0; i < kKanaAlphabetSize; ++i)
+    {
+      table[kKanaAlphabet[i] - kHiraganaFirst] = static_cast<KanaId>(i);
+    }
+
+    return table;
+  }();
+} // namespace
+
+Optional<char32> NormalizeKanaChar(const char32 ch)
+{
+  const char32 normalized = NormalizeKanaCode(ch);
+  if (normalized == kSkipKanaCode)
+  {
+    return none;
+  }
+
+  return normalized;
+}
+
+size_t NormalizeKana(const std::span<const char32> input, const std::span<char32> output)
+{
+  assert(input.size() <= output.size());
+
+  // 読み飛ばす文字も一旦書き込み、書き込み位置だけを進めないことで分岐をなくす。
+  size_t count = 0;
+  for (const char32 ch : input)
+  {
+    const char32 normalized = NormalizeKanaCode(ch);
+    output[count] = normalized;
+    count += (normalized != kSkipKanaCode);
+  }
+
+  return count;
+}
+
+KanaId ToKanaId(const char32 normalized)
+{
+  if (normalized < kHiraganaFirst || kHiraganaLast < normalized)
+  {
+    return kInvalidKanaId;
+  }
+
+  return kKanaIdTable[normalized - kHiraganaFirst];
+}
+
+char32 FromKanaId(const KanaId id)
+{
+  return (id < kKanaAlphabetSize) ? kKanaAlphabet[id] : U'\0';
+}
+
+const String& GetKanaString(const KanaId id)
+{
+  static const Array<String> kKanaStrings = []()
+  {
+    Array<String> strings;
+    for (size_t i = 0; i < kKanaAlphabetSize; ++i)
+    {
+      strings << String(1, kKanaAlphabet[i]);
+    }
+    strings << String();
+    return strings;
+  }();
+
+  return kKanaStrings[(id < kKanaAlphabetSize) ? id : kKanaAlphabetSize];
+}
@@ -0,0 +1,140 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+#include <array>
+#include <span>
+#include <utility>
+
+/// <summary>
+/// 正規化後のひらがなを 0 ～ kKanaAlphabetSize-1 の小さな整数に割り当てたID。
+/// 単語判定では、このIDを添字にした固定長配列で文字数を数える。
+/// </summary>
+using KanaId = uint8;
+
+/// <summary>
+/// 正規化後のひらがなの種類数（清音・通常サイズのみ：あ～ん、ゐ・ゑ を含む）。
+/// </summary>
+inline constexpr size_t kKanaAlphabetSize = 48;
+
+/// <summary>
+/// アルファベット外の文字を表すID。
+/// </summary>
+inline constexpr KanaId kInvalidKanaId = 0xFF;
+
+/// <summary>
+/// KanaId ごとの出現回数。1単語・1回分の手持ちブロックを固定幅で表す。
+/// </summary>
+using KanaCounts = std::array<uint8, kKanaAlphabetSize>;
+
+/// <summary>
+/// NormalizeKanaCode が長音記号に対して返す「読み飛ばす」印。
+/// </summary>
+inline constexpr char32 kSkipKanaCode = U'\0';
+
+namespace KanaTableDetail
+{
+  /// <summary>
+  /// KanaId の並び順。添字がそのままIDになる。
+  /// </summary>
+  inline constexpr char32 kKanaAlphabet[] = U"あいうえおかきくけこさしすせそたちつてとなにぬねのはひふへほまみむめもやゆよらりるれろわゐゑをん";
+
+  static_assert(std::size(kKanaAlphabet) - 1 == kKanaAlphabetSize, "kKanaAlphabet と kKanaAlphabetSize が一致していません。");
+
+  // ひらがなブロック（U+3041～U+3096）の範囲。
+  inline constexpr char32 kHiraganaFirst = U'ぁ';
+  inline constexpr char32 kHiraganaLast = U'ゖ';
+
+  /// <summary>
+  /// 文字コードのひらがなブロック内オフセット -> 正規化後の文字 の直接参照表。
+  /// </summary>
+  inline constexpr auto kNormalizationTable = []()
+  {
+    constexpr std::pair<char32, char32> kMappings[] = {
+      // 小書き文字 -> 通常字
+      { U'ぁ', U'あ' }, { U'ぃ', U'い' }, { U'ぅ', U'う' }, { U'ぇ', U'え' }, { U'ぉ', U'お' },
+      { U'っ', U'つ' }, { U'ゃ', U'や' }, { U'ゅ', U'ゆ' }, { U'ょ', U'よ' }, { U'ゎ', U'わ' },
+      { U'ゕ', U'か' }, { U'ゖ', U'け' },
+
+      // 濁点・半濁点付き文字 -> 清音
+      { U'が', U'か' }, { U'ぎ', U'き' }, { U'ぐ', U'く' }, { U'げ', U'け' }, { U'ご', U'こ' },
+      { U'ざ', U'さ' }, { U'じ', U'し' }, { U'ず', U'す' }, { U'ぜ', U'せ' }, { U'ぞ', U'そ' },
+      { U'だ', U'た' }, { U'ぢ', U'ち' }, { U'づ', U'つ' }, { U'で', U'て' }, { U'ど', U'と' },
+      { U'ば', U'は' }, { U'び', U'ひ' }, { U'ぶ', U'ふ' }, { U'べ', U'へ' }, { U'ぼ', U'ほ' },
+      { U'ぱ', U'は' }, { U'ぴ', U'ひ' }, { U'ぷ', U'ふ' }, { U'ぺ', U'へ' }, { U'ぽ', U'ほ' },
+      { U'ゔ', U'う' }
+    };
+
+    std::array<char32, kHiraganaLast - kHiraganaFirst + 1> table{};
+    for (size_t i = 0; i < table.size(); ++i)
+    {
+      table[i] = static_cast<char32>(kHiraganaFirst + i);
+    }
+    for (const auto& [from, to] : kMappings)
+    {
+      table[from - kHiraganaFirst] = to;
+    }
+
+    return table;
+  }();
+} // namespace KanaTableDetail
+
+/// <summary>
+/// ひらがな1文字をゲーム内ルールに沿って正規化する（表の直接参照のみで、ハッシュ計算をしない）。
+/// ・濁点／半濁点付き文字は清音へ集約
+/// ・小書き文字は通常サイズへ置換
+/// ・長音記号は完全に無視（= kSkipKanaCode を返す）
+/// ・ひらがな以外の文字はそのまま返す
+/// </summary>
+constexpr char32 NormalizeKanaCode(const char32 ch)
+{
+  using namespace KanaTableDetail;
+
+  if (kHiraganaFirst <= ch && ch <= kHiraganaLast)
+  {
+    return kNormalizationTable[ch - kHiraganaFirst];
+  }
+
+  switch (ch)
+  {
+  case U'ー': // 一般的な長音符号
+  case U'－': // 全角ハイフン（長音として扱う）
+  case U'―': // ダッシュ（長音扱い）
+    return kSkipKanaCode;
+  default:
+    return ch;
+  }
+}
+
+/// <summary>
+/// ひらがな1文字をゲーム内ルールに沿って正規化する。規則は NormalizeKanaCode と同じ。
+/// </summary>
+/// <param name="ch">入力された1文字</param>
+/// <returns>正規化後の文字。長音記号の場合は none。</returns>
+Optional<char32> NormalizeKanaChar(char32 ch);
+
+/// <summary>
+/// 文字列をまとめて正規化し、長音記号を取り除いて output の先頭から詰めて書き込む。
+/// 1文字ごとの分岐を持たないループで処理するため、単語全体を正規化する場合はこちらを使う。
+/// </summary>
+/// <param name="input">入力文字列。</param>
+/// <param name="output">書き込み先。input.size() 以上の長さが必要。</param>
+/// <returns>書き込んだ文字数。</returns>
+size_t NormalizeKana(std::span<const char32> input, std::span<char32> output);
+
+/// <summary>
+/// 正規化済みの文字を KanaId に変換する。
+/// </summary>
+/// <param name="normalized">NormalizeKanaChar で正規化した文字</param>
+/// <returns>対応するID。アルファベット外の文字は kInvalidKanaId。</returns>
+KanaId ToKanaId(char32 normalized);
+
+/// <summary>
+/// KanaId を正規化済みの文字に戻す。
+/// </summary>
+char32 FromKanaId(KanaId id);
+
+/// <summary>
+/// KanaId を表示用の1文字の文字列に変換する。文字列は最初の呼び出しで作った表を共有するため、描画のたびに確保しない。
+/// </summary>
+/// <returns>対応する文字列。アルファベット外のIDは空文字列。</returns>
+const String& GetKanaString(KanaId id);
@@ -0,0 +1,307 @@
+﻿#include "./MappedDictionary.h"
+#include "./DictionaryIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace
+{
+  /// <summary>
+  /// 書き出し用の領域を kSectionAlignment の倍数まで 0 で埋める。
+  /// </summary>
+  void PadToAlignment(Array<uint8>& buffer)
+  {
+    const size_t alignment = MappedDictionary::kSectionAlignment;
+    buffer.resize((buffer.size() + alignment - 1) / alignment * alignment, 0);
+  }
+
+  /// <summary>
+  /// 領域を揃えてから data を追加し、追加した位置を返す。
+  /// </summary>
+  uint64 AppendSection(Array<uint8>& buffer, const void* data, const size_t byteSize)
+  {
+    PadToAlignment(buffer);
+
+    const size_t offset = buffer.size();
+    buffer.resize(offset + byteSize);
+    if (byteSize > 0)
+    {
+      std::memcpy(buffer.data() + offset, data, byteSize);
+    }
+
+    return offset;
+  }
+
+  /// <summary>
+  /// [offset, offset + byteSize) がファイル内に収まり、開始位置が揃っているか。
+  /// </summary>
+  bool IsValidSection(const uint64 offset, const uint64 byteSize, const uint64 fileSize)
+  {
+    return (offset % MappedDictionary::kSectionAlignment == 0)
+      && (offset <= fileSize)
+      && (byteSize <= fileSize - offset);
+  }
+
+  static_assert(std::is_trivially_copyable_v<KanaCounts> && sizeof(KanaCounts) == kKanaAlphabetSize,
+    "KanaCounts はファイルにそのまま書き出すため、詰め物のない配列であること");
+} // namespace
+
+MappedDictionary::MappedDictionary() = default;
+
+bool MappedDictionary::Open(const FilePathView path)
+{
+  Close();
+
+  if (!file_.Open(path) || file_.GetSize() < sizeof(FileHeader))
+  {
+    file_.Close();
+    return false;
+  }
+
+  const uint8* data = file_.GetData();
+  const auto* header = reinterpret_cast<const FileHeader*>(data);
+  const uint64 fileSize = file_.GetSize();
+  const uint64 wordCount = header->word_count;
+  const uint64 stride = header->column_stride;
+
+  const bool validHeader = (header->magic == kMagic)
+    && (header->version == kFormatVersion)
+    && (header->alphabet_size == kKanaAlphabetSize)
+    && (header->file_size == fileSize)
+    && (stride % DictionaryIndex::kColumnAlignment == 0)
+    && (wordCount <= stride)
+    && IsValidSection(header->word_offsets_offset, (wordCount + 1) * sizeof(uint32), fileSize)
+    && IsValidSection(header->counts_offset, wordCount * sizeof(KanaCounts), fileSize)
+    && IsValidSection(header->lengths_offset, stride, fileSize)
+    && IsValidSection(header->columns_offset, stride * kKanaAlphabetSize, fileSize)
+    && IsValidSection(header->length_bounds_offset, kLengthBoundCount * sizeof(uint32), fileSize);
+  if (!validHeader)
+  {
+    file_.Close();
+    return false;
+  }
+
+  // 表記の長さは単語の開始位置表の末尾で決まる。取り除かれた単語は長さ順の並びに含まれないので、並びは単語数以下になる。
+  const auto* wordOffsets = reinterpret_cast<const uint32*>(data + header->word_offsets_offset);
+  const auto* lengthBounds = reinterpret_cast<const uint32*>(data + header->length_bounds_offset);
+  const uint64 orderCount = lengthBounds[kLengthBoundCount - 1];
+  if (!IsValidSection(header->text_offset, static_cast<uint64>(wordOffsets[wordCount]) * sizeof(char32), fileSize)
+    || !IsValidSection(header->length_order_offset, orderCount * sizeof(uint32), fileSize)
+    || orderCount > wordCount)
+  {
+    file_.Close();
+    return false;
+  }
+
+  // 表記の範囲と長さ順の並びは単語番号で領域を引くので、壊れたファイルで領域外を読まないよう中身まで確かめる。
+  // 開始位置は単調に増え、長さ順の並びは単語番号の範囲内で、単語の長さが区切りと食い違っていないこと。
+  const auto* lengths = data + header->lengths_offset;
+  const auto* lengthOrder = reinterpret_cast<const uint32*>(data + header->length_order_offset);
+  const bool validOffsets = std::is_sorted(wordOffsets, wordOffsets + wordCount + 1);
+  bool validOrder = std::is_sorted(lengthBounds, lengthBounds + kLengthBoundCount);
+  for (size_t position = 0; validOrder && position < orderCount; ++position)
+  {
+    const uint32 id = lengthOrder[position];
+    const uint8 length = (id < wordCount) ? lengths[id] : 0;
+    validOrder = (id < wordCount)
+      && (position < lengthBounds[length])
+      && (length == 0 || lengthBounds[length - 1] <= position);
+  }
+  if (!validOffsets || !validOrder)
+  {
+    file_.Close();
+    return false;
+  }
+
+  header_ = header;
+  text_ = reinterpret_cast<const char32*>(data + header->text_offset);
+  word_offsets_ = wordOffsets;
+  counts_ = reinterpret_cast<const KanaCounts*>(data + header->counts_offset);
+  lengths_ = lengths;
+  columns_ = data + header->columns_offset;
+  length_order_ = lengthOrder;
+  length_bounds_ = lengthBounds;
+  return true;
+}
+
+Optional<DictionaryIndex> MappedDictionary::OpenIndex(const FilePathView path)
+{
+  // 索引が参照する領域の持ち主。割り当てたファイルと、ファイルの形式から索引の形式へ直した小さな表をまとめて持つ。
+  struct Storage
+  {
+    MappedDictionary dictionary;
+    Array<std::u32string_view> words;
+    Array<uint32> length_offsets;
+  };
+
+  auto storage = std::make_shared<Storage>();
+  if (!storage->dictionary.Open(path))
+  {
+    return none;
+  }
+
+  const MappedDictionary& dictionary = storage->dictionary;
+  const size_t wordCount = dictionary.GetWordCount();
+  const size_t stride = static_cast<size_t>(dictionary.header_->column_stride);
+
+  storage->words.reserve(wordCount);
+  for (size_t i = 0; i < wordCount; ++i)
+  {
+    storage->words << std::u32string_view{ dictionary.text_ + dictionary.word_offsets_[i], dictionary.word_offsets_[i + 1] - dictionary.word_offsets_[i] };
+  }
+
+  // ファイルの「長さが n 以下の単語の数」を、索引の「長さが n 以上の単語が始まる位置」に直す（1つずらすだけ）。
+  storage->length_offsets.resize(kLengthBoundCount + 1, 0);
+  std::copy_n(dictionary.length_bounds_, kLengthBoundCount, storage->length_offsets.begin() + 1);
+
+  DictionaryIndex::BorrowedTables tables;
+  tables.words = storage->words;
+  tables.counts = { dictionary.counts_, wordCount };
+  tables.lengths = { dictionary.lengths_, stride };
+  tables.columns = { dictionary.columns_, stride * kKanaAlphabetSize };
+  tables.column_stride = stride;
+  tables.length_order = { dictionary.length_order_, dictionary.length_bounds_[kLengthBoundCount - 1] };
+  tables.length_offsets = storage->length_offsets;
+  tables.owner = std::move(storage);
+
+  return DictionaryIndex{ std::move(tables) };
+}
+
+void MappedDictionary::Close()
+{
+  header_ = nullptr;
+  text_ = nullptr;
+  word_offsets_ = nullptr;
+  counts_ = nullptr;
+  lengths_ = nullptr;
+  columns_ = nullptr;
+  length_order_ = nullptr;
+  length_bounds_ = nullptr;
+  file_.Close();
+}
+
+size_t MappedDictionary::GetWordCount() const
+{
+  return (header_ != nullptr) ? header_->word_count : 0;
+}
+
+StringView MappedDictionary::GetWord(const size_t index) const
+{
+  return StringView{ text_ + word_offsets_[index], static_cast<size_t>(word_offsets_[index + 1] - word_offsets_[index]) };
+}
+
+WordMatchKernel::ColumnView MappedDictionary::GetColumnView() const
+{
+  if (header_ == nullptr)
+  {
+    return {};
+  }
+
+  return { columns_, lengths_, static_cast<size_t>(header_->column_stride), header_->word_count };
+}
+
+std::span<const uint32> MappedDictionary::GetWordsUpToLength(const size_t maxLength) const
+{
+  if (header_ == nullptr)
+  {
+    return {};
+  }
+
+  return { length_order_, length_bounds_[std::min(maxLength, kLengthBoundCount - 1)] };
+}
+
+void MappedDictionary::CollectMatches(const KanaCounts& held, Array<uint32>* hits, Array<uint32>* reaches) const
+{
+  WordMatchKernel::CollectMatches(GetColumnView(), held, 0, GetWordCount(), hits, reaches);
+}
+
+String MappedDictionary::GetMissingCharacter(const size_t index, const KanaCounts& held) const
+{
+  const KanaCounts& required = counts_[index];
+  const auto first = std::mismatch(required.begin(), required.end(), held.begin(), [](const uint8 r, const uint8 h) { return r <= h; }).first;
+  if (first == required.end())
+  {
+    return String{};
+  }
+
+  const KanaId missing = static_cast<KanaId>(first - required.begin());
+
+  // 手持ちで賄える分（held[missing] 個）を読み飛ばし、その次の出現位置の文字を返す。
+  int32 remaining = held[missing];
+
+  for (const char32 ch : GetWord(index))
+  {
+    const auto normalized = NormalizeKanaChar(ch);
+    if (!normalized || ToKanaId(*normalized) != missing)
+    {
+      continue;
+    }
+
+    if (remaining == 0)
+    {
+      return String(1, ch);
+    }
+
+    --remaining;
+  }
+
+  return String(1, FromKanaId(missing));
+}
+
+bool MappedDictionary::Write(const FilePathView path, const DictionaryIndex& index)
+{
+  const size_t wordCount = index.GetWordCount();
+  const size_t stride = index.GetColumnStride();
+
+  Array<char32> text;
+  Array<uint32> wordOffsets;
+  Array<KanaCounts> counts;
+  wordOffsets.reserve(wordCount + 1);
+  counts.reserve(wordCount);
+
+  for (size_t word = 0; word < wordCount; ++word)
+  {
+    wordOffsets << static_cast<uint32>(text.size());
+    text.insert(text.end(), index.GetWord(word).begin(), index.GetWord(word).end());
+    counts << index.GetCounts(word);
+  }
+  wordOffsets << static_cast<uint32>(text.size());
+
+  Array<uint32> lengthBounds(kLengthBoundCount);
+  for (size_t length = 0; length < kLengthBoundCount; ++length)
+  {
+    lengthBounds[length] = static_cast<uint32>(index.GetWordsUpToLength(length).size());
+  }
+  const std::span<const uint32> lengthOrder = index.GetWordsUpToLength(kLengthBoundCount - 1);
+
+  // 先頭の情報は位置が決まってから書き込むので、領域だけ確保しておく。
+  FileHeader header{};
+  header.magic = kMagic;
+  header.version = kFormatVersion;
+  header.alphabet_size = static_cast<uint32>(kKanaAlphabetSize);
+  header.word_count = static_cast<uint32>(wordCount);
+  header.column_stride = stride;
+
+  Array<uint8> buffer(sizeof(FileHeader), 0);
+  header.word_offsets_offset = AppendSection(buffer, wordOffsets.data(), wordOffsets.size() * sizeof(uint32));
+  header.counts_offset = AppendSection(buffer, counts.data(), counts.size() * sizeof(KanaCounts));
+  header.lengths_offset = AppendSection(buffer, index.GetLengthColumn(), stride);
+  header.columns_offset = AppendSection(buffer, index.GetColumn(0), stride * kKanaAlphabetSize);
+  header.length_order_offset = AppendSection(buffer, lengthOrder.data(), lengthOrder.size() * sizeof(uint32));
+  header.length_bounds_offset = AppendSection(buffer, lengthBounds.data(), lengthBounds.size() * sizeof(uint32));
+  header.text_offset = AppendSection(buffer, text.data(), text.size() * sizeof(char32));
+  PadToAlignment(buffer);
+
+  header.file_size = buffer.size();
+  std::memcpy(buffer.data(), &header, sizeof(FileHeader));
+
+  BinaryWriter writer{ path };
+  if (!writer)
+  {
+    return false;
+  }
+
+  return writer.write(buffer.data(), static_cast<int64>(buffer.size())) == static_cast<int64>(buffer.size());
+}
@@ -0,0 +1,157 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./DictionaryIndex.h"
+#include "./KanaTable.h"
+#include "./MemoryMappedFile.h"
+#include "./WordMatchKernel.h"
+
+#include <span>
+
+/// <summary>
+/// DictionaryIndex を前処理済みのバイナリ形式（.ichd）に書き出したファイルを割り当て、読み込み処理なしでそのまま問い合わせる辞書。
+/// ファイルには元の表記・単語ごとの文字数・SoA 列・長さ順の並びが入っており、ヒット・リーチ判定は割り当てた領域の上で直接行う。
+/// 形式は実行環境のバイト順（リトルエンディアン）そのままで、異なる環境で書いたファイルは先頭の識別子が一致せず開けない。
+/// </summary>
+class MappedDictionary
+{
+public:
+  /// <summary>
+  /// ファイル先頭の識別子（"ICHD"）
+  /// </summary>
+  static constexpr uint32 kMagic = 0x44484349;
+
+  /// <summary>
+  /// ファイル形式の版。配置を変えたら上げ、古いファイルは開けないようにする。
+  /// </summary>
+  static constexpr uint32 kFormatVersion = 1;
+
+  /// <summary>
+  /// 各領域の開始位置の揃え単位（キャッシュライン）
+  /// </summary>
+  static constexpr size_t kSectionAlignment = 64;
+
+  /// <summary>
+  /// 長さ順の並びを引くための表の大きさ（単語の長さは uint8 なので 0 ～ 255）
+  /// </summary>
+  static constexpr size_t kLengthBoundCount = 256;
+
+  MappedDictionary();
+
+  /// <summary>
+  /// ファイルを割り当てて開く。既に開いている場合は先に閉じる。
+  /// 先頭の情報と各領域の範囲に加え、単語番号で領域を引く表（表記の開始位置・長さ順の並び）の中身を確かめる。
+  /// </summary>
+  /// <returns>識別子・版・文字数・各領域の範囲と表の中身がすべて正しければ true。</returns>
+  bool Open(FilePathView path);
+
+  /// <summary>
+  /// ファイルを割り当てて開き、割り当てた列を参照する DictionaryIndex として返す。
+  /// 文字数・SoA 列・長さ順の並びはコピーせず、作るのは表記の参照と欠番の表だけ（補助索引はそれを使う方式が初めて参照したときに作る）。ファイルは返した索引（とそのコピー）が生きている間だけ割り当てたままにする。
+  /// </summary>
+  /// <returns>開けなかった場合は none。</returns>
+  static Optional<DictionaryIndex> OpenIndex(FilePathView path);
+
+  /// <summary>
+  /// ファイルを閉じる。
+  /// </summary>
+  void Close();
+
+  /// <summary>
+  /// ファイルを開いているか。
+  /// </summary>
+  bool IsOpen() const { return header_ != nullptr; }
+
+  /// <summary>
+  /// 登録されている単語数を返す。
+  /// </summary>
+  size_t GetWordCount() const;
+
+  /// <summary>
+  /// 辞書に記載されている表記のまま単語を返す。割り当てた領域を直接指すので、閉じた後は使えない。
+  /// </summary>
+  StringView GetWord(size_t index) const;
+
+  /// <summary>
+  /// 単語を組み立てるのに必要な、正規化後の文字ごとの個数を返す。
+  /// </summary>
+  const KanaCounts& GetCounts(size_t index) const { return counts_[index]; }
+
+  /// <summary>
+  /// 単語の長さ（正規化後、長音記号を除いた文字数）を返す。
+  /// </summary>
+  uint8 GetLength(size_t index) const { return lengths_[index]; }
+
+  /// <summary>
+  /// SoA 列と長さの列をまとめた参照を返す。
+  /// </summary>
+  WordMatchKernel::ColumnView GetColumnView() const;
+
+  /// <summary>
+  /// 長さが maxLength 以下の単語の番号を、短い順（同じ長さの中では辞書順）に返す。DictionaryIndex::GetWordsUpToLength と同じ。
+  /// </summary>
+  std::span<const uint32> GetWordsUpToLength(size_t maxLength) const;
+
+  /// <summary>
+  /// ヒット（不足数 0）とリーチ（不足数 1）の単語番号を辞書順に集める。
+  /// </summary>
+  void CollectMatches(const KanaCounts& held, Array<uint32>* hits, Array<uint32>* reaches) const;
+
+  /// <summary>
+  /// リーチ状態の単語について、不足している「元の文字（濁点付き等）」を返す。DictionaryIndex::GetMissingCharacter と同じ規則。
+  /// </summary>
+  String GetMissingCharacter(size_t index, const KanaCounts& held) const;
+
+  /// <summary>
+  /// 辞書索引をバイナリ形式でファイルに書き出す。
+  /// </summary>
+  /// <returns>書き出しに成功した場合は true。</returns>
+  static bool Write(FilePathView path, const DictionaryIndex& index);
+
+private:
+  /// <summary>
+  /// ファイル先頭の情報。各領域の位置はファイル先頭からのバイト数。
+  /// </summary>
+  struct FileHeader
+  {
+    uint32 magic;
+    uint32 version;
+    uint32 alphabet_size;
+    uint32 word_count;
+    uint64 column_stride;
+    uint64 file_size;
+
+    // 元の表記（char32 を続けて並べたもの）
+    uint64 text_offset;
+    // 単語 i の表記は text の [word_offsets[i], word_offsets[i + 1]) 文字目（uint32 × 単語数 + 1）
+    uint64 word_offsets_offset;
+    // 単語ごとの文字数（KanaCounts × 単語数）
+    uint64 counts_offset;
+    // 単語の長さの列（uint8 × column_stride）
+    uint64 lengths_offset;
+    // 文字ごとの必要数の列（uint8 × kKanaAlphabetSize × column_stride）
+    uint64 columns_offset;
+    // 長さの昇順に並べた単語番号（uint32 × 単語数）
+    uint64 length_order_offset;
+    // 長さが n 以下の単語の数（uint32 × kLengthBoundCount）
+    uint64 length_bounds_offset;
+  };
+
+  /// <summary>
+  /// 割り当てたファイル
+  /// </summary>
+  MemoryMappedFile file_;
+
+  /// <summary>
+  /// 割り当てた領域内の各部分を指すポインタ（開いていないときは nullptr）
+  /// </summary>
+  const FileHeader* header_ = nullptr;
+  const char32* text_ = nullptr;
+  const uint32* word_offsets_ = nullptr;
+  const KanaCounts* counts_ = nullptr;
+  const uint8* lengths_ = nullptr;
+  const uint8* columns_ = nullptr;
+  const uint32* length_order_ = nullptr;
+  const uint32* length_bounds_ = nullptr;
+};
@@ -0,0 +1,145 @@
+﻿#include "./MemoryMappedFile.h"
+
+#if defined(_WIN32)
+# ifndef NOMINMAX
+#   define NOMINMAX
+# endif
+# ifndef WIN32_LEAN_AND_MEAN
+#   define WIN32_LEAN_AND_MEAN
+# endif
+# include <Windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#include <utility>
+
+MemoryMappedFile::MemoryMappedFile() = default;
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+  Close();
+}
+
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept
+{
+  *this = std::move(other);
+}
+
+MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) noexcept
+{
+  if (this != &other)
+  {
+    Close();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+#if defined(_WIN32)
+    mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+  }
+
+  return *this;
+}
+
+#if defined(_WIN32)
+
+bool MemoryMappedFile::Open(const FilePathView path)
+{
+  Close();
+
+  const std::wstring widePath = Unicode::ToWstring(path);
+  const HANDLE file = ::CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+
+  LARGE_INTEGER fileSize{};
+  if (!::GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+  {
+    ::CloseHandle(file);
+    return false;
+  }
+
+  // マッピングオブジェクトがファイルを参照し続けるため、ファイルのハンドルはここで閉じてよい。
+  const HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  ::CloseHandle(file);
+  if (mapping == nullptr)
+  {
+    return false;
+  }
+
+  const void* view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view == nullptr)
+  {
+    ::CloseHandle(mapping);
+    return false;
+  }
+
+  data_ = static_cast<const uint8*>(view);
+  size_ = static_cast<size_t>(fileSize.QuadPart);
+  mapping_ = mapping;
+  return true;
+}
+
+void MemoryMappedFile::Close()
+{
+  if (data_ != nullptr)
+  {
+    ::UnmapViewOfFile(data_);
+    ::CloseHandle(static_cast<HANDLE>(mapping_));
+  }
+
+  data_ = nullptr;
+  size_ = 0;
+  mapping_ = nullptr;
+}
+
+#else
+
+bool MemoryMappedFile::Open(const FilePathView path)
+{
+  Close();
+
+  const std::string utf8Path = String(path).toUTF8();
+  const int file = ::open(utf8Path.c_str(), O_RDONLY);
+  if (file < 0)
+  {
+    return false;
+  }
+
+  struct stat status{};
+  if (::fstat(file, &status) != 0 || status.st_size <= 0)
+  {
+    ::close(file);
+    return false;
+  }
+
+  // 割り当て後はファイル記述子がなくても領域は有効なままなので、ここで閉じてよい。
+  void* view = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+  ::close(file);
+  if (view == MAP_FAILED)
+  {
+    return false;
+  }
+
+  data_ = static_cast<const uint8*>(view);
+  size_ = static_cast<size_t>(status.st_size);
+  return true;
+}
+
+void MemoryMappedFile::Close()
+{
+  if (data_ != nullptr)
+  {
+    ::munmap(const_cast<uint8*>(data_), size_);
+  }
+
+  data_ = nullptr;
+  size_ = 0;
+}
+
+#endif
@@ -0,0 +1,68 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+/// <summary>
+/// ファイルを読み取り専用でメモリに割り当て（mmap）、内容をコピーせずに参照するためのクラス。
+/// Windows では CreateFileMapping / MapViewOfFile、それ以外では mmap を使う。
+/// </summary>
+class MemoryMappedFile
+{
+public:
+  MemoryMappedFile();
+
+  /// <summary>
+  /// デストラクタ（割り当てを解除する）
+  /// </summary>
+  ~MemoryMappedFile();
+
+  MemoryMappedFile(const MemoryMappedFile&) = delete;
+  MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+  MemoryMappedFile(MemoryMappedFile&& other) noexcept;
+  MemoryMappedFile& operator=(MemoryMappedFile&& other) noexcept;
+
+  /// <summary>
+  /// ファイルを開いて割り当てる。既に開いている場合は先に閉じる。
+  /// </summary>
+  /// <returns>割り当てに成功した場合は true。空のファイルは失敗として扱う。</returns>
+  bool Open(FilePathView path);
+
+  /// <summary>
+  /// 割り当てを解除する。
+  /// </summary>
+  void Close();
+
+  /// <summary>
+  /// ファイルが割り当てられているか。
+  /// </summary>
+  bool IsOpen() const { return data_ != nullptr; }
+
+  /// <summary>
+  /// 割り当てた領域の先頭を返す。
+  /// </summary>
+  const uint8* GetData() const { return data_; }
+
+  /// <summary>
+  /// 割り当てた領域のバイト数を返す。
+  /// </summary>
+  size_t GetSize() const { return size_; }
+
+private:
+  /// <summary>
+  /// 割り当てた領域の先頭
+  /// </summary>
+  const uint8* data_ = nullptr;
+
+  /// <summary>
+  /// 割り当てた領域のバイト数
+  /// </summary>
+  size_t size_ = 0;
+
+#if defined(_WIN32)
+  /// <summary>
+  /// ファイルマッピングオブジェクトのハンドル
+  /// </summary>
+  void* mapping_ = nullptr;
+#endif
+};
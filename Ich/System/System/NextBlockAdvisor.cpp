@@ -0,0 +1,215 @@
+﻿#include "./NextBlockAdvisor.h"
+#include "./DictionaryIndex.h"
+
+#include <algorithm>
+
+NextBlockAdvisor::NextBlockAdvisor(const DictionaryIndex& index)
+  : NextBlockAdvisor(index, Settings{})
+{
+}
+
+NextBlockAdvisor::NextBlockAdvisor(const DictionaryIndex& index, const Settings& settings)
+  : index_(&index)
+  , settings_(settings)
+  , matcher_(index)
+{
+}
+
+void NextBlockAdvisor::Start(const int32 rowCount, const int32 columnCount, Array<KanaId> cells, const int32 playerRow, const int32 playerColumn, const Array<KanaId>& held, const size_t maxHeld, const Array<String>& completedWords)
+{
+  row_count_ = rowCount;
+  column_count_ = columnCount;
+  cells_ = std::move(cells);
+  max_held_ = maxHeld;
+
+  completed_words_.clear();
+  for (const String& word : completedWords)
+  {
+    completed_words_.insert(word);
+  }
+  completion_cache_.assign(index_->GetWordCount(), 0);
+
+  candidates_.clear();
+  for (int32 row = playerRow - settings_.radius; row <= playerRow + settings_.radius; ++row)
+  {
+    for (int32 column = playerColumn - settings_.radius; column <= playerColumn + settings_.radius; ++column)
+    {
+      if (row >= 0 && row < row_count_ && column >= 0 && column < column_count_ && cells_[row * column_count_ + column] != kInvalidKanaId)
+      {
+        candidates_ << row * column_count_ + column;
+      }
+    }
+  }
+
+  Plan root;
+  root.held = held;
+  beam_.clear();
+  beam_ << std::move(root);
+  next_beam_.clear();
+  expanded_count_ = 0;
+  depth_ = 0;
+  best_plan_.reset();
+  is_running_ = true;
+}
+
+bool NextBlockAdvisor::Step(const std::chrono::microseconds timeSlice)
+{
+  if (!is_running_)
+  {
+    return false;
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() + timeSlice;
+
+  // 1つの手順の展開（候補の数だけ判定器を進めて戻す）を単位に、時間の上限まで進める。
+  do
+  {
+    if (expanded_count_ < beam_.size())
+    {
+      Expand(beam_[expanded_count_++]);
+      continue;
+    }
+
+    // 段の展開が終わったら、良い手順だけを次の段に残す。
+    ++depth_;
+    if (next_beam_.isEmpty() || depth_ >= settings_.depth)
+    {
+      is_running_ = false;
+      break;
+    }
+
+    const size_t width = std::min(settings_.beam_width, next_beam_.size());
+    std::partial_sort(next_beam_.begin(), next_beam_.begin() + width, next_beam_.end(), IsBetter);
+    next_beam_.resize(width);
+    beam_ = std::move(next_beam_);
+    next_beam_.clear();
+    expanded_count_ = 0;
+  } while (std::chrono::steady_clock::now() < deadline);
+
+  if (is_running_)
+  {
+    return false;
+  }
+
+  if (best_plan_ && (best_plan_->score > 0 || best_plan_->reach_count > 0))
+  {
+    const int32 first = best_plan_->cells.front();
+    advice_ = Advice{ first / column_count_, first % column_count_, best_plan_->score, best_plan_->reach_count };
+  }
+  else
+  {
+    advice_.reset();
+  }
+  return true;
+}
+
+void NextBlockAdvisor::Clear()
+{
+  is_running_ = false;
+  beam_.clear();
+  next_beam_.clear();
+  best_plan_.reset();
+  advice_.reset();
+}
+
+bool NextBlockAdvisor::IsBetter(const Plan& a, const Plan& b)
+{
+  if (a.score != b.score)
+  {
+    return a.score > b.score;
+  }
+  if (a.reach_count != b.reach_count)
+  {
+    return a.reach_count > b.reach_count;
+  }
+  return a.cells.size() < b.cells.size();
+}
+
+void NextBlockAdvisor::Expand(const Plan& plan)
+{
+  LoadHeld(plan.held);
+
+  for (const int32 cell : candidates_)
+  {
+    if (plan.cells.includes(cell))
+    {
+      continue;
+    }
+
+    // 壊したブロックを手持ちに加え、上限を超えたら最も古いものを捨てる（ゲームと同じ規則）。
+    const KanaId added = cells_[cell];
+    const bool isFull = (plan.held.size() >= max_held_);
+    const KanaId evicted = isFull ? plan.held.front() : kInvalidKanaId;
+    matcher_.Push(added);
+    if (isFull)
+    {
+      matcher_.Evict(evicted);
+    }
+
+    Plan child;
+    child.score = plan.score;
+    child.credited_words = plan.credited_words;
+    for (const uint32 word : matcher_.GetHitIds())
+    {
+      if (!IsCompleted(word) && !child.credited_words.includes(word))
+      {
+        child.credited_words << word;
+        child.score += index_->GetLength(word);
+      }
+    }
+    child.reach_count = static_cast<int32>(matcher_.GetReachIds().size());
+
+    // 判定器を親の手順の手持ちに戻す。
+    if (isFull)
+    {
+      matcher_.Push(evicted);
+    }
+    matcher_.Evict(added);
+
+    child.cells = plan.cells;
+    child.cells << cell;
+    child.held.assign(plan.held.begin() + (isFull ? 1 : 0), plan.held.end());
+    child.held << added;
+
+    if (!best_plan_ || IsBetter(child, *best_plan_))
+    {
+      best_plan_ = child;
+    }
+    next_beam_ << std::move(child);
+  }
+}
+
+void NextBlockAdvisor::LoadHeld(const Array<KanaId>& held)
+{
+  // Reset は辞書の大きさに比例するので、直前の手順の手持ちとの差（多重集合の差）だけを出し入れする。
+  KanaCounts target{};
+  for (const KanaId id : held)
+  {
+    if (id < kKanaAlphabetSize)
+    {
+      ++target[id];
+    }
+  }
+
+  const KanaCounts current = matcher_.GetHeldCounts();
+  for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+  {
+    for (uint8 count = current[id]; count > target[id]; --count)
+    {
+      matcher_.Evict(static_cast<KanaId>(id));
+    }
+    for (uint8 count = current[id]; count < target[id]; ++count)
+    {
+      matcher_.Push(static_cast<KanaId>(id));
+    }
+  }
+}
+
+bool NextBlockAdvisor::IsCompleted(const uint32 word)
+{
+  if (completion_cache_[word] == 0)
+  {
+    completion_cache_[word] = completed_words_.contains(String{ index_->GetWord(word) }) ? 1 : 2;
+  }
+  return completion_cache_[word] == 1;
+}
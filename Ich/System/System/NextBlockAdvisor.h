@@ -0,0 +1,202 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./IncrementalWordMatcher.h"
+#include "./KanaTable.h"
+
+#include <chrono>
+
+class DictionaryIndex;
+
+/// <summary>
+/// 次に壊すと良いブロックを提案する補助機能。
+/// プレイヤーの周囲のブロックを壊す順番をビームサーチで探し、この先 N 個を壊すまでに新しく完成する単語の文字数が最大になる手順の、最初のブロックを返す。
+/// 候補の評価には IncrementalWordMatcher を使い、1文字加える・戻すだけでヒットとリーチを求める。
+/// </summary>
+/// <remarks>
+/// 探索は Start で始め、毎フレーム Step に時間の上限を渡して少しずつ進める。ゲームの処理を止めないよう、1フレームで使う時間は Step に渡した上限を大きく超えない。
+/// 候補は周囲 radius マス以内の壊されていないブロックで、プレイヤーが実際にそこまで移動できるかは考えない。
+/// </remarks>
+class NextBlockAdvisor
+{
+public:
+  /// <summary>
+  /// 探索の設定
+  /// </summary>
+  struct Settings
+  {
+    /// <summary>
+    /// 候補にするブロックの範囲（プレイヤーのマスからの縦横斜めの距離）
+    /// </summary>
+    int32 radius = 2;
+
+    /// <summary>
+    /// 先読みするブロック数（N）
+    /// </summary>
+    size_t depth = 3;
+
+    /// <summary>
+    /// 各段で残す手順の数
+    /// </summary>
+    size_t beam_width = 8;
+  };
+
+  /// <summary>
+  /// 提案
+  /// </summary>
+  struct Advice
+  {
+    /// <summary>
+    /// 次に壊すブロックのマス
+    /// </summary>
+    int32 row = 0;
+    int32 column = 0;
+
+    /// <summary>
+    /// 最良の手順で新しく完成する単語の文字数の合計
+    /// </summary>
+    int32 score = 0;
+
+    /// <summary>
+    /// 最良の手順の後にリーチになっている単語の数
+    /// </summary>
+    int32 reach_count = 0;
+  };
+
+  /// <summary>
+  /// 毎フレームの Step に渡す既定の時間の上限
+  /// </summary>
+  static constexpr std::chrono::microseconds kDefaultTimeSlice{ 1000 };
+
+  /// <summary>
+  /// 既定の設定で構築する。
+  /// </summary>
+  /// <param name="index">単語の判定に使う辞書索引。この提案器より長く生存している必要がある。</param>
+  explicit NextBlockAdvisor(const DictionaryIndex& index);
+
+  /// <summary>
+  /// コンストラクタ
+  /// </summary>
+  /// <param name="index">単語の判定に使う辞書索引。この提案器より長く生存している必要がある。</param>
+  /// <param name="settings">探索の設定。</param>
+  NextBlockAdvisor(const DictionaryIndex& index, const Settings& settings);
+
+  /// <summary>
+  /// 新しい探索を始める。実行中の探索は捨てる。結果は探索が終わるまで前回のものを返す。
+  /// </summary>
+  /// <param name="rowCount">盤面の行数。</param>
+  /// <param name="columnCount">盤面の列数。</param>
+  /// <param name="cells">行優先で並べた各マスの文字。空きマス・壊したブロックは kInvalidKanaId。</param>
+  /// <param name="playerRow">プレイヤーのマスの行。</param>
+  /// <param name="playerColumn">プレイヤーのマスの列。</param>
+  /// <param name="held">今の手持ち（古い順。kInvalidKanaId は空き）。</param>
+  /// <param name="maxHeld">手持ちの上限。超えたら古い順に捨てる。</param>
+  /// <param name="completedWords">完成済みの単語（得点に数えない）。</param>
+  void Start(int32 rowCount, int32 columnCount, Array<KanaId> cells, int32 playerRow, int32 playerColumn, const Array<KanaId>& held, size_t maxHeld, const Array<String>& completedWords);
+
+  /// <summary>
+  /// 探索を進める。timeSlice を使い切るか、探索が終わったら戻る。
+  /// </summary>
+  /// <returns>この呼び出しで探索が終わった場合は true。</returns>
+  bool Step(std::chrono::microseconds timeSlice = kDefaultTimeSlice);
+
+  /// <summary>
+  /// 探索中か。
+  /// </summary>
+  bool IsRunning() const { return is_running_; }
+
+  /// <summary>
+  /// 最後に終わった探索の提案。得点もリーチも増やせない場合は none。
+  /// </summary>
+  const Optional<Advice>& GetAdvice() const { return advice_; }
+
+  /// <summary>
+  /// 探索を止め、提案を消す。
+  /// </summary>
+  void Clear();
+
+private:
+  /// <summary>
+  /// ビームに残す手順
+  /// </summary>
+  struct Plan
+  {
+    /// <summary>
+    /// 壊すマスの順番
+    /// </summary>
+    Array<int32> cells;
+
+    /// <summary>
+    /// 手順を実行した後の手持ち（古い順）
+    /// </summary>
+    Array<KanaId> held;
+
+    /// <summary>
+    /// 手順の途中で新しく完成した単語（同じ単語を二度数えない）
+    /// </summary>
+    Array<uint32> credited_words;
+
+    int32 score = 0;
+    int32 reach_count = 0;
+  };
+
+  /// <summary>
+  /// a が b より良い手順か（得点、リーチ数の順に比べ、同じなら短い手順を優先する）
+  /// </summary>
+  static bool IsBetter(const Plan& a, const Plan& b);
+
+  /// <summary>
+  /// 手順に候補のマスを1つずつ加えた手順を next_beam_ に追加する。
+  /// </summary>
+  void Expand(const Plan& plan);
+
+  /// <summary>
+  /// 判定器の手持ちを held に合わせる。今の手持ちとの差の分だけ Evict / Push するので、手順が近いほど速い。
+  /// </summary>
+  void LoadHeld(const Array<KanaId>& held);
+
+  /// <summary>
+  /// 単語が完成済みか（単語ごとに一度だけ文字列で調べる）
+  /// </summary>
+  bool IsCompleted(uint32 word);
+
+  const DictionaryIndex* index_;
+  Settings settings_;
+
+  /// <summary>
+  /// 候補の評価に使う判定器（ゲーム側の判定器とは別に持つ）
+  /// </summary>
+  IncrementalWordMatcher matcher_;
+
+  /// <summary>
+  /// 探索中の盤面と候補
+  /// </summary>
+  int32 row_count_ = 0;
+  int32 column_count_ = 0;
+  Array<KanaId> cells_;
+  Array<int32> candidates_;
+  size_t max_held_ = 0;
+
+  /// <summary>
+  /// 完成済みの単語と、単語ごとの判定結果（0: 未判定、1: 完成済み、2: 未完成）
+  /// </summary>
+  HashSet<String> completed_words_;
+  Array<uint8> completion_cache_;
+
+  /// <summary>
+  /// 今の段の手順と、展開済みの数・次の段の手順
+  /// </summary>
+  Array<Plan> beam_;
+  size_t expanded_count_ = 0;
+  Array<Plan> next_beam_;
+  size_t depth_ = 0;
+
+  /// <summary>
+  /// これまでに見つかった最良の手順
+  /// </summary>
+  Optional<Plan> best_plan_;
+
+  bool is_running_ = false;
+  Optional<Advice> advice_;
+};
@@ -0,0 +1,206 @@
+﻿#include "./OrderedWordAutomaton.h"
+#include "./DictionaryIndex.h"
+
+#include <algorithm>
+#include <span>
+
+OrderedWordAutomaton::OrderedWordAutomaton()
+{
+  root_children_.fill(kNoState);
+  AddState(kRootState, 0, kNoState);
+}
+
+OrderedWordAutomaton::OrderedWordAutomaton(const DictionaryIndex& index)
+  : OrderedWordAutomaton()
+{
+  const size_t wordCount = index.GetWordCount();
+
+  // 全単語の正規化後の文字IDを続けて並べる。
+  Array<KanaId> kanaIds;
+  Array<uint32> offsets{ 0 };
+  Array<char32> normalized;
+  Array<uint32> order;
+  offsets.reserve(wordCount + 1);
+  order.reserve(wordCount);
+
+  for (size_t word = 0; word < wordCount; ++word)
+  {
+    const StringView text = index.GetWord(word);
+    if (normalized.size() < text.size())
+    {
+      normalized.resize(text.size());
+    }
+
+    if (!index.IsRemoved(word))
+    {
+      const size_t length = NormalizeKana(std::span<const char32>(text.data(), text.size()), normalized);
+      for (size_t i = 0; i < length; ++i)
+      {
+        kanaIds << ToKanaId(normalized[i]);
+      }
+      if (length > 0)
+      {
+        order << static_cast<uint32>(word);
+      }
+    }
+
+    offsets << static_cast<uint32>(kanaIds.size());
+  }
+
+  const auto getKana = [&](const uint32 word)
+  {
+    return std::span<const KanaId>(kanaIds.data() + offsets[word], offsets[word + 1] - offsets[word]);
+  };
+
+  // 辞書順に並べて挿入すれば、各状態の子は文字の昇順に1つずつ末尾へ追加するだけで済む。
+  std::stable_sort(order.begin(), order.end(), [&](const uint32 a, const uint32 b)
+  {
+    const auto kanaA = getKana(a);
+    const auto kanaB = getKana(b);
+    return std::lexicographical_compare(kanaA.begin(), kanaA.end(), kanaB.begin(), kanaB.end());
+  });
+
+  next_words_.assign(wordCount, kNoWord);
+  Array<State> path{ kRootState };
+  Array<State> lastChildren{ kNoState };
+  Array<uint32> lastWords;
+  std::span<const KanaId> previous;
+
+  for (const uint32 word : order)
+  {
+    const auto kana = getKana(word);
+
+    // 直前の単語と共通する接頭辞の分だけ経路を残す。
+    const size_t common = static_cast<size_t>(std::mismatch(kana.begin(), kana.end(), previous.begin(), previous.end()).first - kana.begin());
+    path.resize(common + 1);
+    lastChildren.resize(common + 1);
+
+    for (size_t depth = common; depth < kana.size(); ++depth)
+    {
+      const State child = AddState(path[depth], kana[depth], lastChildren[depth]);
+      lastChildren[depth] = child;
+      path << child;
+      lastChildren << kNoState;
+    }
+
+    // 正規化後が同じ単語は、番号順に同じ状態へつなぐ。
+    const State terminal = path.back();
+    lastWords.resize(GetStateCount(), kNoWord);
+    if (word_heads_[terminal] == kNoWord)
+    {
+      word_heads_[terminal] = word;
+    }
+    else
+    {
+      next_words_[lastWords[terminal]] = word;
+    }
+    lastWords[terminal] = word;
+
+    previous = kana;
+  }
+
+  // 幅優先で失敗リンクと出力リンクを張る。
+  Array<State> queue;
+  queue.reserve(GetStateCount());
+  for (const State child : root_children_)
+  {
+    if (child != kNoState)
+    {
+      queue << child;
+    }
+  }
+
+  for (size_t head = 0; head < queue.size(); ++head)
+  {
+    const State state = queue[head];
+
+    for (State child = first_children_[state]; child != kNoState; child = next_siblings_[child])
+    {
+      State failure = failures_[state];
+      State next = FindChild(failure, labels_[child]);
+      while (next == kNoState && failure != kRootState)
+      {
+        failure = failures_[failure];
+        next = FindChild(failure, labels_[child]);
+      }
+
+      failures_[child] = (next == kNoState) ? kRootState : next;
+      output_links_[child] = (word_heads_[failures_[child]] != kNoWord) ? failures_[child] : output_links_[failures_[child]];
+      queue << child;
+    }
+  }
+}
+
+OrderedWordAutomaton::State OrderedWordAutomaton::Next(State state, const KanaId id) const
+{
+  if (id >= kKanaAlphabetSize)
+  {
+    return kRootState;
+  }
+
+  while (true)
+  {
+    if (const State child = FindChild(state, id); child != kNoState)
+    {
+      return child;
+    }
+
+    if (state == kRootState)
+    {
+      return kRootState;
+    }
+
+    state = failures_[state];
+  }
+}
+
+OrderedWordAutomaton::State OrderedWordAutomaton::FindChild(const State state, const KanaId id) const
+{
+  if (state == kRootState)
+  {
+    return root_children_[id];
+  }
+
+  for (State child = first_children_[state]; child != kNoState; child = next_siblings_[child])
+  {
+    if (labels_[child] >= id)
+    {
+      return (labels_[child] == id) ? child : kNoState;
+    }
+  }
+
+  return kNoState;
+}
+
+OrderedWordAutomaton::State OrderedWordAutomaton::AddState(const State parent, const KanaId id, const State previousSibling)
+{
+  const State state = static_cast<State>(failures_.size());
+
+  first_children_ << kNoState;
+  next_siblings_ << kNoState;
+  labels_ << id;
+  failures_ << kRootState;
+  output_links_ << kRootState;
+  word_heads_ << kNoWord;
+
+  // 根自身を作るときは親とのつなぎ込みをしない。
+  if (state == kRootState)
+  {
+    return state;
+  }
+
+  if (parent == kRootState)
+  {
+    root_children_[id] = state;
+  }
+  else if (previousSibling == kNoState)
+  {
+    first_children_[parent] = state;
+  }
+  else
+  {
+    next_siblings_[previousSibling] = state;
+  }
+
+  return state;
+}
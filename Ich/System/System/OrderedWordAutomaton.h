@@ -0,0 +1,117 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./KanaTable.h"
+
+class DictionaryIndex;
+
+/// <summary>
+/// 正規化後の単語から作る Aho–Corasick オートマトン。
+/// 壊したブロックの文字を1つずつ Next で進めると、「直前に連続して集めた文字列」の末尾に一致する単語を ForEachMatch で列挙できる。
+/// 遷移は失敗リンクを辿っても1文字あたり償却 O(1) で、手持ちの窓を単語ごとに調べ直す必要がない。
+/// </summary>
+/// <remarks>
+/// 子の一覧は状態ごとに兄弟リンクでつなぎ、大きな辞書でも状態あたり 20 バイト程度に抑える。根の子だけは直接参照の表で持つ。
+/// </remarks>
+class OrderedWordAutomaton
+{
+public:
+  /// <summary>
+  /// 状態の番号
+  /// </summary>
+  using State = uint32;
+
+  /// <summary>
+  /// 初期状態（何も集めていない状態）
+  /// </summary>
+  static constexpr State kRootState = 0;
+
+  OrderedWordAutomaton();
+
+  /// <summary>
+  /// 辞書索引の各単語（RemoveWord で取り除かれた単語を除く）を正規化してオートマトンを作る。
+  /// ForEachMatch が返す単語番号は索引の番号と同じ。
+  /// </summary>
+  explicit OrderedWordAutomaton(const DictionaryIndex& index);
+
+  /// <summary>
+  /// 状態数を返す。
+  /// </summary>
+  size_t GetStateCount() const { return failures_.size(); }
+
+  /// <summary>
+  /// 文字を1つ進めた状態を返す。アルファベット外の文字では連続が途切れたものとして初期状態に戻る。
+  /// </summary>
+  State Next(State state, KanaId id) const;
+
+  /// <summary>
+  /// 状態に到達した時点で末尾が一致している単語の番号を、長い単語から順に visit へ渡す。
+  /// </summary>
+  template <class Visitor>
+  void ForEachMatch(State state, Visitor&& visit) const
+  {
+    if (word_heads_[state] == kNoWord)
+    {
+      state = output_links_[state];
+    }
+
+    while (state != kRootState)
+    {
+      for (uint32 word = word_heads_[state]; word != kNoWord; word = next_words_[word])
+      {
+        visit(word);
+      }
+      state = output_links_[state];
+    }
+  }
+
+private:
+  /// <summary>
+  /// 子・単語がないことを表す番号
+  /// </summary>
+  static constexpr uint32 kNoState = 0xFFFFFFFFu;
+  static constexpr uint32 kNoWord = 0xFFFFFFFFu;
+
+  /// <summary>
+  /// 文字 id で進む子を返す。なければ kNoState。
+  /// </summary>
+  State FindChild(State state, KanaId id) const;
+
+  /// <summary>
+  /// 子を追加して番号を返す。
+  /// </summary>
+  State AddState(State parent, KanaId id, State previousSibling);
+
+  /// <summary>
+  /// 根の子（文字ごとの直接参照）
+  /// </summary>
+  std::array<State, kKanaAlphabetSize> root_children_{};
+
+  /// <summary>
+  /// 状態ごとの最初の子・次の兄弟・親から進む文字。兄弟は文字の昇順に並ぶ。
+  /// </summary>
+  Array<State> first_children_;
+  Array<State> next_siblings_;
+  Array<KanaId> labels_;
+
+  /// <summary>
+  /// 失敗リンク（その状態の文字列の、真の接尾辞のうち最長の状態）
+  /// </summary>
+  Array<State> failures_;
+
+  /// <summary>
+  /// 出力リンク（失敗リンクを辿って最初に単語が終わる状態。なければ根）
+  /// </summary>
+  Array<State> output_links_;
+
+  /// <summary>
+  /// 状態で終わる単語の先頭。正規化後が同じ単語は next_words_ でつなぐ。
+  /// </summary>
+  Array<uint32> word_heads_;
+
+  /// <summary>
+  /// 単語番号 -> 同じ状態で終わる次の単語番号
+  /// </summary>
+  Array<uint32> next_words_;
+};
@@ -0,0 +1,273 @@
+﻿#include "./PackedDictionary.h"
+
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+  constexpr uint64 kKanaMask = (uint64{ 1 } << PackedDictionary::kBitsPerKana) - 1;
+} // namespace
+
+PackedDictionary::PackedDictionary()
+  : bits_(1, 0)
+{
+}
+
+PackedDictionary::PackedDictionary(const Array<String>& dictionary)
+{
+  lengths_.reserve(dictionary.size());
+  variant_counts_.reserve(dictionary.size());
+
+  size_t symbolCount = 0;
+
+  for (const auto& word : dictionary)
+  {
+    if (lengths_.size() % kOffsetInterval == 0)
+    {
+      symbol_offsets_ << static_cast<uint32>(symbolCount);
+      variant_offsets_ << static_cast<uint32>(variants_.size());
+    }
+
+    if (word.size() > std::numeric_limits<uint8>::max())
+    {
+      throw std::invalid_argument("dictionary words must be at most 255 characters long.");
+    }
+
+    const size_t firstSymbol = symbolCount;
+    const size_t firstVariant = variants_.size();
+
+    for (size_t position = 0; position < word.size(); ++position)
+    {
+      const char32 ch = word[position];
+      const char32 normalized = NormalizeKanaCode(ch);
+
+      if (normalized != kSkipKanaCode)
+      {
+        const KanaId id = ToKanaId(normalized);
+        if (id == kInvalidKanaId)
+        {
+          throw std::invalid_argument("dictionary words must consist of hiragana only.");
+        }
+
+        // 6 ビットずつ詰める。uint64 の境界をまたぐ場合は次の要素に続きを書く。
+        const size_t bit = symbolCount * kBitsPerKana;
+        if (bits_.size() < bit / 64 + 2)
+        {
+          bits_.resize(bit / 64 + 2, 0);
+        }
+        bits_[bit / 64] |= static_cast<uint64>(id) << (bit % 64);
+        if (bit % 64 + kBitsPerKana > 64)
+        {
+          bits_[bit / 64 + 1] |= static_cast<uint64>(id) >> (64 - bit % 64);
+        }
+
+        ++symbolCount;
+      }
+
+      // 清音そのものでない文字（濁点付き・小書き・長音記号）だけ補助表に残す。
+      if (normalized != ch)
+      {
+        variants_ << Variant{ static_cast<uint16>(position), static_cast<uint16>(ch) };
+      }
+    }
+
+    lengths_ << static_cast<uint8>(symbolCount - firstSymbol);
+    variant_counts_ << static_cast<uint8>(variants_.size() - firstVariant);
+  }
+
+  if (bits_.isEmpty())
+  {
+    bits_.resize(1, 0);
+  }
+}
+
+KanaCounts PackedDictionary::GetCounts(const size_t index) const
+{
+  KanaCounts counts{};
+  const size_t begin = GetSymbolOffset(index);
+
+  for (size_t symbol = begin; symbol < begin + lengths_[index]; ++symbol)
+  {
+    const KanaId id = ReadKana(symbol);
+    if (counts[id] < std::numeric_limits<uint8>::max())
+    {
+      ++counts[id];
+    }
+  }
+
+  return counts;
+}
+
+String PackedDictionary::GetWord(const size_t index) const
+{
+  const size_t symbolEnd = GetSymbolOffset(index) + lengths_[index];
+  const size_t variantEnd = GetVariantOffset(index) + variant_counts_[index];
+
+  size_t symbol = GetSymbolOffset(index);
+  size_t variant = GetVariantOffset(index);
+
+  String word;
+  word.reserve(lengths_[index] + variant_counts_[index]);
+
+  while (symbol < symbolEnd || variant < variantEnd)
+  {
+    if (variant < variantEnd && variants_[variant].position == word.size())
+    {
+      // 補助表の文字をそのまま使う。長音記号でなければ対応する文字IDを1つ消費する。
+      const char32 ch = variants_[variant++].character;
+      if (NormalizeKanaCode(ch) != kSkipKanaCode)
+      {
+        ++symbol;
+      }
+      word.push_back(ch);
+    }
+    else
+    {
+      word.push_back(FromKanaId(ReadKana(symbol++)));
+    }
+  }
+
+  return word;
+}
+
+void PackedDictionary::CollectMatches(const KanaCounts& held, Array<uint32>* hits, Array<uint32>* reaches) const
+{
+  size_t heldTotal = 0;
+  for (const uint8 count : held)
+  {
+    heldTotal += count;
+  }
+
+  // 単語は順番に読むので、開始位置は長さを足していくだけで求まる。
+  size_t begin = 0;
+
+  for (size_t word = 0; word < lengths_.size(); ++word)
+  {
+    const size_t end = begin + lengths_[word];
+
+    // 手持ちより 2 文字以上長い単語は、不足数も必ず 2 以上になる。
+    if (lengths_[word] <= heldTotal + 1)
+    {
+      KanaCounts remaining = held;
+      int32 deficit = 0;
+
+      for (size_t symbol = begin; symbol < end && deficit <= 1; ++symbol)
+      {
+        uint8& count = remaining[ReadKana(symbol)];
+        if (count == 0)
+        {
+          ++deficit;
+        }
+        else
+        {
+          --count;
+        }
+      }
+
+      if (hits && deficit == 0)
+      {
+        hits->push_back(static_cast<uint32>(word));
+      }
+      else if (reaches && deficit == 1)
+      {
+        reaches->push_back(static_cast<uint32>(word));
+      }
+    }
+
+    begin = end;
+  }
+}
+
+String PackedDictionary::GetMissingCharacter(const size_t index, const KanaCounts& held) const
+{
+  // 先頭から手持ちを使っていき、最初に賄えなかった位置の文字が不足分になる。
+  KanaCounts remaining = held;
+
+  for (size_t position = 0; position < lengths_[index]; ++position)
+  {
+    uint8& count = remaining[GetKana(index, position)];
+    if (count == 0)
+    {
+      return String(1, GetOriginalCharacter(index, position));
+    }
+
+    --count;
+  }
+
+  return String{};
+}
+
+size_t PackedDictionary::GetByteSize() const
+{
+  return bits_.size() * sizeof(uint64)
+    + lengths_.size() * sizeof(uint8)
+    + symbol_offsets_.size() * sizeof(uint32)
+    + variants_.size() * sizeof(Variant)
+    + variant_counts_.size() * sizeof(uint8)
+    + variant_offsets_.size() * sizeof(uint32);
+}
+
+KanaId PackedDictionary::ReadKana(const size_t symbol) const
+{
+  const size_t bit = symbol * kBitsPerKana;
+  const size_t shift = bit % 64;
+
+  uint64 value = bits_[bit / 64] >> shift;
+  if (shift + kBitsPerKana > 64)
+  {
+    value |= bits_[bit / 64 + 1] << (64 - shift);
+  }
+
+  return static_cast<KanaId>(value & kKanaMask);
+}
+
+size_t PackedDictionary::GetSymbolOffset(const size_t index) const
+{
+  size_t offset = symbol_offsets_[index / kOffsetInterval];
+
+  for (size_t word = index - index % kOffsetInterval; word < index; ++word)
+  {
+    offset += lengths_[word];
+  }
+
+  return offset;
+}
+
+size_t PackedDictionary::GetVariantOffset(const size_t index) const
+{
+  size_t offset = variant_offsets_[index / kOffsetInterval];
+
+  for (size_t word = index - index % kOffsetInterval; word < index; ++word)
+  {
+    offset += variant_counts_[word];
+  }
+
+  return offset;
+}
+
+char32 PackedDictionary::GetOriginalCharacter(const size_t index, const size_t position) const
+{
+  // 補助表の長音記号を数えながら、正規化後の position 文字目に当たる表示位置を求める。
+  size_t display = position;
+  const size_t begin = GetVariantOffset(index);
+
+  for (size_t variant = begin; variant < begin + variant_counts_[index]; ++variant)
+  {
+    const Variant& entry = variants_[variant];
+    if (entry.position > display)
+    {
+      break;
+    }
+
+    if (NormalizeKanaCode(entry.character) == kSkipKanaCode)
+    {
+      ++display;
+    }
+    else if (entry.position == display)
+    {
+      return entry.character;
+    }
+  }
+
+  return FromKanaId(GetKana(index, position));
+}
@@ -0,0 +1,134 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./KanaTable.h"
+
+/// <summary>
+/// 辞書を「正規化後の文字ID を 6 ビットずつ詰めた1つの連続領域 + 単語ごとの長さ」で保持する省メモリな表現。
+/// 開始位置は kOffsetInterval 単語ごとにだけ持ち、間の単語は長さを足して求める。
+/// 濁点・半濁点・小書き・長音記号など清音と異なる表記は、単語ごとの小さな補助表に (位置, 元の文字) として残し、
+/// 表示用の文字列はそこから復元する。ヒット・リーチ判定は詰めたままの表現の上で行う。
+/// </summary>
+class PackedDictionary
+{
+public:
+  /// <summary>
+  /// 1文字あたりのビット数（KanaId は 0～47 なので 6 ビット）
+  /// </summary>
+  static constexpr uint32 kBitsPerKana = 6;
+
+  /// <summary>
+  /// 開始位置を記録する間隔（単語数）
+  /// </summary>
+  static constexpr size_t kOffsetInterval = 32;
+
+  PackedDictionary();
+
+  /// <summary>
+  /// 辞書を詰めた表現に変換する。
+  /// </summary>
+  /// <param name="dictionary">ひらがなで構成された単語一覧。</param>
+  /// <exception cref="std::invalid_argument">ひらがな（と長音記号）以外の文字を含む単語や、255 文字を超える単語がある場合。</exception>
+  explicit PackedDictionary(const Array<String>& dictionary);
+
+  /// <summary>
+  /// 登録されている単語数を返す。
+  /// </summary>
+  size_t GetWordCount() const { return lengths_.size(); }
+
+  /// <summary>
+  /// 単語の長さ（正規化後、長音記号を除いた文字数）を返す。
+  /// </summary>
+  size_t GetLength(size_t index) const { return lengths_[index]; }
+
+  /// <summary>
+  /// 単語の position 文字目（正規化後）の文字IDを返す。
+  /// </summary>
+  KanaId GetKana(size_t index, size_t position) const { return ReadKana(GetSymbolOffset(index) + position); }
+
+  /// <summary>
+  /// 単語ごとの文字数を数える。
+  /// </summary>
+  KanaCounts GetCounts(size_t index) const;
+
+  /// <summary>
+  /// 辞書に記載されていた表記の単語を復元する。
+  /// </summary>
+  String GetWord(size_t index) const;
+
+  /// <summary>
+  /// ヒット（不足数 0）とリーチ（不足数 1）の単語番号を辞書順に集める。詰めた表現を直接読んで判定する。
+  /// </summary>
+  void CollectMatches(const KanaCounts& held, Array<uint32>* hits, Array<uint32>* reaches) const;
+
+  /// <summary>
+  /// リーチ状態の単語について、不足している「元の文字（濁点付き等）」を返す。DictionaryIndex::GetMissingCharacter と同じ規則。
+  /// </summary>
+  String GetMissingCharacter(size_t index, const KanaCounts& held) const;
+
+  /// <summary>
+  /// この表現が使っているおおよそのバイト数（詰めた文字・開始位置・補助表の合計）
+  /// </summary>
+  size_t GetByteSize() const;
+
+private:
+  /// <summary>
+  /// 清音と異なる表記の文字（元の単語での表示位置と文字）。どちらも BMP 内なので 16 ビットずつで足りる。
+  /// </summary>
+  struct Variant
+  {
+    uint16 position;
+    uint16 character;
+  };
+
+  /// <summary>
+  /// 全体で symbol 番目の文字IDを読み出す。
+  /// </summary>
+  KanaId ReadKana(size_t symbol) const;
+
+  /// <summary>
+  /// 単語の先頭の文字が全体で何番目かを返す。
+  /// </summary>
+  size_t GetSymbolOffset(size_t index) const;
+
+  /// <summary>
+  /// 単語の補助表の先頭が variants_ の何番目かを返す。
+  /// </summary>
+  size_t GetVariantOffset(size_t index) const;
+
+  /// <summary>
+  /// 単語の position 文字目（正規化後）が、元の表記で何という文字だったかを返す。
+  /// </summary>
+  char32 GetOriginalCharacter(size_t index, size_t position) const;
+
+  /// <summary>
+  /// 文字IDを 6 ビットずつ詰めた領域。末尾の読み出しで範囲外を読まないよう 1 要素余分に持つ。
+  /// </summary>
+  Array<uint64> bits_;
+
+  /// <summary>
+  /// 単語ごとの長さ（正規化後の文字数）
+  /// </summary>
+  Array<uint8> lengths_;
+
+  /// <summary>
+  /// kOffsetInterval 単語ごとの、先頭の文字の位置
+  /// </summary>
+  Array<uint32> symbol_offsets_;
+
+  /// <summary>
+  /// 清音と異なる表記の一覧（単語順、単語内は表示位置順）
+  /// </summary>
+  Array<Variant> variants_;
+
+  /// <summary>
+  /// 単語ごとの補助表の件数
+  /// </summary>
+  Array<uint8> variant_counts_;
+
+  /// <summary>
+  /// kOffsetInterval 単語ごとの、補助表の先頭の位置
+  /// </summary>
+  Array<uint32> variant_offsets_;
+};
@@ -0,0 +1,326 @@
+﻿#include "./PathWordFinder.h"
+#include "./DictionaryIndex.h"
+#include "./WorkerPool.h"
+
+#include <algorithm>
+#include <span>
+
+namespace
+{
+  /// <summary>
+  /// 縦横斜めの隣のマスへの移動量
+  /// </summary>
+  constexpr int32 kNeighborRows[] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+  constexpr int32 kNeighborColumns[] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+} // namespace
+
+PathWordFinder::PathWordFinder()
+{
+  root_children_.fill(kNoNode);
+  first_children_ << kNoNode;
+  next_siblings_ << kNoNode;
+  labels_ << kInvalidKanaId;
+  word_heads_ << kNoWord;
+}
+
+PathWordFinder::PathWordFinder(const DictionaryIndex& index)
+  : PathWordFinder()
+{
+  const size_t wordCount = index.GetWordCount();
+  next_words_.assign(wordCount, kNoWord);
+  Array<uint32> lastWords{ kNoWord };
+  Array<char32> normalized;
+
+  for (size_t word = 0; word < wordCount; ++word)
+  {
+    if (index.IsRemoved(word))
+    {
+      continue;
+    }
+
+    const StringView text = index.GetWord(word);
+    if (normalized.size() < text.size())
+    {
+      normalized.resize(text.size());
+    }
+
+    const size_t length = NormalizeKana(std::span<const char32>(text.data(), text.size()), normalized);
+    if (length == 0)
+    {
+      continue;
+    }
+
+    uint32 node = kRootNode;
+    for (size_t i = 0; i < length; ++i)
+    {
+      node = FindOrAddChild(node, ToKanaId(normalized[i]));
+    }
+    max_word_length_ = std::max(max_word_length_, length);
+
+    // 正規化後が同じ単語は、番号順に同じ節点へつなぐ。
+    lastWords.resize(GetNodeCount(), kNoWord);
+    if (word_heads_[node] == kNoWord)
+    {
+      word_heads_[node] = static_cast<uint32>(word);
+    }
+    else
+    {
+      next_words_[lastWords[node]] = static_cast<uint32>(word);
+    }
+    lastWords[node] = static_cast<uint32>(word);
+  }
+}
+
+void PathWordFinder::SetGrid(const int32 rowCount, const int32 columnCount, Array<KanaId> cells)
+{
+  row_count_ = rowCount;
+  column_count_ = columnCount;
+  cells_ = std::move(cells);
+  start_words_.assign(cells_.size(), Array<uint32>{});
+
+  Array<int32> starts;
+  for (int32 cell = std::max(row_begin_, 0) * column_count_; cell < std::min(row_end_, row_count_) * column_count_; ++cell)
+  {
+    starts << cell;
+  }
+  UpdateStarts(starts);
+  RebuildFoundWords();
+}
+
+void PathWordFinder::SetVisibleRows(const int32 rowBegin, const int32 rowEnd)
+{
+  if (rowBegin == row_begin_ && rowEnd == row_end_)
+  {
+    return;
+  }
+
+  // 範囲の端を通る経路が変わるので、見えている範囲全体を探索し直す。
+  row_begin_ = rowBegin;
+  row_end_ = rowEnd;
+  SetGrid(row_count_, column_count_, std::move(cells_));
+}
+
+Array<uint32> PathWordFinder::ClearCell(const int32 row, const int32 column)
+{
+  if (row < 0 || row >= row_count_ || column < 0 || column >= column_count_)
+  {
+    return {};
+  }
+
+  const int32 cell = row * column_count_ + column;
+  if (cells_[cell] == kInvalidKanaId)
+  {
+    return {};
+  }
+
+  if (!IsUsable(row, column))
+  {
+    cells_[cell] = kInvalidKanaId;
+    return {};
+  }
+
+  // 壊したマスを通る経路の始点は、空きでないマスだけを通って (最長の単語の文字数 - 1) 歩以内にある。
+  const Array<int32> starts = CollectCellsWithin(cell, (max_word_length_ > 0) ? (max_word_length_ - 1) : 0);
+
+  Array<Array<uint32>> claimed(starts.size());
+  WorkerPool::GetInstance()->ParallelFor(starts.size(), [&](const size_t i)
+  {
+    claimed[i] = SearchFrom(starts[i], static_cast<uint32>(cell));
+  });
+
+  Array<uint32> words;
+  for (const auto& startWords : claimed)
+  {
+    words.insert(words.end(), startWords.begin(), startWords.end());
+  }
+  std::sort(words.begin(), words.end());
+  words.erase(std::unique(words.begin(), words.end()), words.end());
+
+  cells_[cell] = kInvalidKanaId;
+  start_words_[cell].clear();
+  UpdateStarts(starts);
+  RebuildFoundWords();
+  return words;
+}
+
+uint32 PathWordFinder::FindChild(const uint32 node, const KanaId id) const
+{
+  if (node == kRootNode)
+  {
+    return root_children_[id];
+  }
+
+  for (uint32 child = first_children_[node]; child != kNoNode; child = next_siblings_[child])
+  {
+    if (labels_[child] == id)
+    {
+      return child;
+    }
+  }
+  return kNoNode;
+}
+
+uint32 PathWordFinder::FindOrAddChild(const uint32 node, const KanaId id)
+{
+  if (const uint32 child = FindChild(node, id); child != kNoNode)
+  {
+    return child;
+  }
+
+  const uint32 child = static_cast<uint32>(GetNodeCount());
+  first_children_ << kNoNode;
+  labels_ << id;
+  word_heads_ << kNoWord;
+
+  if (node == kRootNode)
+  {
+    root_children_[id] = child;
+    next_siblings_ << kNoNode;
+  }
+  else
+  {
+    next_siblings_ << first_children_[node];
+    first_children_[node] = child;
+  }
+  return child;
+}
+
+bool PathWordFinder::IsUsable(const int32 row, const int32 column) const
+{
+  return row >= std::max(row_begin_, 0) && row < std::min(row_end_, row_count_)
+    && column >= 0 && column < column_count_
+    && cells_[row * column_count_ + column] != kInvalidKanaId;
+}
+
+Array<uint32> PathWordFinder::SearchFrom(const int32 start, const uint32 requiredCell) const
+{
+  Array<uint32> words;
+  if (!IsUsable(start / column_count_, start % column_count_))
+  {
+    return words;
+  }
+
+  // 経路上のマス・節点と、次に試す隣の番号を積んだスタックで深さ優先に探索する。
+  struct Frame
+  {
+    int32 cell;
+    uint32 node;
+    uint8 next_neighbor;
+  };
+
+  Array<bool> visited(cells_.size(), false);
+  Array<Frame> stack;
+  size_t requiredDepth = 0;
+
+  const auto enter = [&](const int32 cell, const uint32 node)
+  {
+    visited[cell] = true;
+    stack.push_back(Frame{ cell, node, 0 });
+    if (static_cast<uint32>(cell) == requiredCell)
+    {
+      requiredDepth = stack.size();
+    }
+
+    if (requiredCell == kNoCell || requiredDepth > 0)
+    {
+      for (uint32 word = word_heads_[node]; word != kNoWord; word = next_words_[word])
+      {
+        words << word;
+      }
+    }
+  };
+
+  if (const uint32 node = root_children_[cells_[start]]; node != kNoNode)
+  {
+    enter(start, node);
+  }
+
+  while (!stack.empty())
+  {
+    Frame& frame = stack.back();
+    if (frame.next_neighbor == std::size(kNeighborRows) || first_children_[frame.node] == kNoNode)
+    {
+      visited[frame.cell] = false;
+      if (requiredDepth == stack.size())
+      {
+        requiredDepth = 0;
+      }
+      stack.pop_back();
+      continue;
+    }
+
+    const uint8 neighbor = frame.next_neighbor++;
+    const int32 row = frame.cell / column_count_ + kNeighborRows[neighbor];
+    const int32 column = frame.cell % column_count_ + kNeighborColumns[neighbor];
+    if (!IsUsable(row, column))
+    {
+      continue;
+    }
+
+    const int32 cell = row * column_count_ + column;
+    if (visited[cell])
+    {
+      continue;
+    }
+
+    if (const uint32 child = FindChild(frame.node, cells_[cell]); child != kNoNode)
+    {
+      enter(cell, child);
+    }
+  }
+
+  std::sort(words.begin(), words.end());
+  words.erase(std::unique(words.begin(), words.end()), words.end());
+  return words;
+}
+
+void PathWordFinder::UpdateStarts(const Array<int32>& starts)
+{
+  WorkerPool::GetInstance()->ParallelFor(starts.size(), [&](const size_t i)
+  {
+    start_words_[starts[i]] = SearchFrom(starts[i], kNoCell);
+  });
+}
+
+void PathWordFinder::RebuildFoundWords()
+{
+  found_words_.clear();
+  for (const auto& words : start_words_)
+  {
+    found_words_.insert(found_words_.end(), words.begin(), words.end());
+  }
+  std::sort(found_words_.begin(), found_words_.end());
+  found_words_.erase(std::unique(found_words_.begin(), found_words_.end()), found_words_.end());
+}
+
+Array<int32> PathWordFinder::CollectCellsWithin(const int32 cell, const size_t distance) const
+{
+  Array<int32> cells{ cell };
+  Array<size_t> depths{ 0 };
+  Array<bool> queued(cells_.size(), false);
+  queued[cell] = true;
+
+  for (size_t head = 0; head < cells.size(); ++head)
+  {
+    if (depths[head] == distance)
+    {
+      continue;
+    }
+
+    for (size_t neighbor = 0; neighbor < std::size(kNeighborRows); ++neighbor)
+    {
+      const int32 row = cells[head] / column_count_ + kNeighborRows[neighbor];
+      const int32 column = cells[head] % column_count_ + kNeighborColumns[neighbor];
+      if (!IsUsable(row, column) || queued[row * column_count_ + column])
+      {
+        continue;
+      }
+
+      queued[row * column_count_ + column] = true;
+      cells << row * column_count_ + column;
+      depths << depths[head] + 1;
+    }
+  }
+
+  return cells;
+}
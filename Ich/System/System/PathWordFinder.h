@@ -0,0 +1,150 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./KanaTable.h"
+
+#include <array>
+
+class DictionaryIndex;
+
+/// <summary>
+/// ブロックの盤面で、縦横斜めに隣り合うブロックを一度ずつたどってできる単語（Boggle 形式）を探す。
+/// 各マスを始点に、辞書の接頭辞木をたどりながら深さ優先で探索し、接頭辞にない文字列はその場で打ち切る。
+/// 始点ごとの探索は WorkerPool で並列に実行する。
+/// </summary>
+/// <remarks>
+/// 探索する範囲は画面に見えている行（SetVisibleRows）に限る。ブロックを壊したときは ClearCell で、
+/// 壊したマスを通りえた始点だけを探索し直す。
+/// </remarks>
+class PathWordFinder
+{
+public:
+  PathWordFinder();
+
+  /// <summary>
+  /// 辞書索引の各単語（RemoveWord で取り除かれた単語を除く）を正規化して接頭辞木を作る。
+  /// 見つかった単語の番号は索引の番号と同じ。
+  /// </summary>
+  explicit PathWordFinder(const DictionaryIndex& index);
+
+  /// <summary>
+  /// 盤面全体を設定し、見えている範囲を探索し直す。
+  /// </summary>
+  /// <param name="rowCount">行数。</param>
+  /// <param name="columnCount">列数。</param>
+  /// <param name="cells">行優先で並べた各マスの文字。空きマス・壊したブロックは kInvalidKanaId。</param>
+  void SetGrid(int32 rowCount, int32 columnCount, Array<KanaId> cells);
+
+  /// <summary>
+  /// 探索する行の範囲 [rowBegin, rowEnd) を設定する。範囲が変わった場合だけ探索し直す。
+  /// </summary>
+  void SetVisibleRows(int32 rowBegin, int32 rowEnd);
+
+  /// <summary>
+  /// マスを空きにして、そのマスを通りえた始点だけを探索し直す。
+  /// </summary>
+  /// <returns>空きにする前に、そのマスを通る経路でできていた単語の番号（昇順）。</returns>
+  Array<uint32> ClearCell(int32 row, int32 column);
+
+  /// <summary>
+  /// 見えている範囲で今できる単語の番号を昇順で返す。
+  /// </summary>
+  const Array<uint32>& GetFoundWords() const { return found_words_; }
+
+  /// <summary>
+  /// 接頭辞木の節点数を返す。
+  /// </summary>
+  size_t GetNodeCount() const { return labels_.size(); }
+
+private:
+  /// <summary>
+  /// 子・単語がないことを表す番号
+  /// </summary>
+  static constexpr uint32 kNoNode = 0xFFFFFFFFu;
+  static constexpr uint32 kNoWord = 0xFFFFFFFFu;
+  static constexpr uint32 kNoCell = 0xFFFFFFFFu;
+
+  /// <summary>
+  /// 根の番号
+  /// </summary>
+  static constexpr uint32 kRootNode = 0;
+
+  /// <summary>
+  /// 文字 id で進む子を返す。なければ kNoNode。
+  /// </summary>
+  uint32 FindChild(uint32 node, KanaId id) const;
+
+  /// <summary>
+  /// 子を返す。なければ追加する。
+  /// </summary>
+  uint32 FindOrAddChild(uint32 node, KanaId id);
+
+  /// <summary>
+  /// マスが探索する範囲にあり、空きでないか。
+  /// </summary>
+  bool IsUsable(int32 row, int32 column) const;
+
+  /// <summary>
+  /// 始点のマスから探索し、できる単語の番号を昇順で返す。
+  /// requiredCell が kNoCell 以外なら、そのマスを通る経路でできる単語だけを返す。
+  /// </summary>
+  Array<uint32> SearchFrom(int32 start, uint32 requiredCell) const;
+
+  /// <summary>
+  /// 始点のマスを並列に探索し、始点ごとの結果を更新する。
+  /// </summary>
+  void UpdateStarts(const Array<int32>& starts);
+
+  /// <summary>
+  /// 始点ごとの結果から found_words_ を作り直す。
+  /// </summary>
+  void RebuildFoundWords();
+
+  /// <summary>
+  /// マスから、空きでないマスだけを通って distance 歩以内で行けるマス（自身を含む）を返す。
+  /// </summary>
+  Array<int32> CollectCellsWithin(int32 cell, size_t distance) const;
+
+  /// <summary>
+  /// 接頭辞木。節点ごとの最初の子・次の兄弟・親から進む文字
+  /// </summary>
+  std::array<uint32, kKanaAlphabetSize> root_children_{};
+  Array<uint32> first_children_;
+  Array<uint32> next_siblings_;
+  Array<KanaId> labels_;
+
+  /// <summary>
+  /// 節点で終わる単語の先頭と、正規化後が同じ次の単語
+  /// </summary>
+  Array<uint32> word_heads_;
+  Array<uint32> next_words_;
+
+  /// <summary>
+  /// 最も長い単語の文字数（経路の長さの上限）
+  /// </summary>
+  size_t max_word_length_ = 0;
+
+  /// <summary>
+  /// 盤面
+  /// </summary>
+  int32 row_count_ = 0;
+  int32 column_count_ = 0;
+  Array<KanaId> cells_;
+
+  /// <summary>
+  /// 探索する行の範囲
+  /// </summary>
+  int32 row_begin_ = 0;
+  int32 row_end_ = 0;
+
+  /// <summary>
+  /// 始点のマスごとに見つかった単語の番号（昇順）
+  /// </summary>
+  Array<Array<uint32>> start_words_;
+
+  /// <summary>
+  /// 見えている範囲でできる単語の番号（昇順）
+  /// </summary>
+  Array<uint32> found_words_;
+};
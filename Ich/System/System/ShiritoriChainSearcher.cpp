@@ -0,0 +1,55 @@
+﻿#include "./ShiritoriChainSearcher.h"
+
+#include <chrono>
+
+ShiritoriChainSearcher::~ShiritoriChainSearcher()
+{
+  if (pending_.valid())
+  {
+    pending_.wait();
+  }
+}
+
+void ShiritoriChainSearcher::Request(std::shared_ptr<const ShiritoriGraph> graph, const KanaId last, Array<uint32> usedWords)
+{
+  result_.reset();
+  Query query{ std::move(graph), last, std::move(usedWords) };
+
+  if (pending_.valid())
+  {
+    queued_ = std::move(query);
+    return;
+  }
+
+  Start(std::move(query));
+}
+
+bool ShiritoriChainSearcher::Update()
+{
+  if (!pending_.valid() || pending_.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready)
+  {
+    return false;
+  }
+
+  const ShiritoriGraph::ChainLength length = pending_.get();
+
+  // 探索中に新しい依頼が届いていれば、今の結果は古いので捨てて次を始める。
+  if (queued_)
+  {
+    Start(std::move(*queued_));
+    queued_.reset();
+    return false;
+  }
+
+  result_ = length;
+  return true;
+}
+
+void ShiritoriChainSearcher::Start(Query query)
+{
+  // 依頼の内容は探索が終わるまでラムダが持つので、呼び出し側は続けてグラフや鎖を変更してよい。
+  pending_ = std::async(std::launch::async, [query = std::move(query)]()
+  {
+    return query.graph->FindLongestChain(query.last, query.used_words);
+  });
+}
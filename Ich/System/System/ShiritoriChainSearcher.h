@@ -0,0 +1,82 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./ShiritoriGraph.h"
+
+#include <future>
+#include <memory>
+
+/// <summary>
+/// しりとりの「ここから続けられる最長の鎖」を背景スレッドで求める。
+/// 鎖が伸びるたびに Request で探索を依頼し、毎フレーム Update で結果を受け取る。フレームごとの処理は結果の確認だけになる。
+/// </summary>
+class ShiritoriChainSearcher
+{
+public:
+  ShiritoriChainSearcher() = default;
+
+  /// <summary>
+  /// デストラクタ（探索中なら終わるまで待つ）
+  /// </summary>
+  ~ShiritoriChainSearcher();
+
+  ShiritoriChainSearcher(const ShiritoriChainSearcher&) = delete;
+  ShiritoriChainSearcher& operator=(const ShiritoriChainSearcher&) = delete;
+
+  /// <summary>
+  /// 探索を依頼する。探索中の場合は、終わってから最後に依頼されたものだけを探索する。
+  /// 以前の結果は、新しい結果が出るまで GetResult で返さない。
+  /// </summary>
+  /// <param name="graph">探索するグラフ。探索が終わるまで共有して保持する。</param>
+  /// <param name="last">直前の単語の最後の文字。鎖の先頭なら kInvalidKanaId。</param>
+  /// <param name="usedWords">使用済みの単語の番号。</param>
+  void Request(std::shared_ptr<const ShiritoriGraph> graph, KanaId last, Array<uint32> usedWords);
+
+  /// <summary>
+  /// 毎フレーム呼ぶ。探索が終わっていれば結果を受け取り、待っている依頼があれば探索を始める。
+  /// </summary>
+  /// <returns>このフレームで結果が更新された場合は true。</returns>
+  bool Update();
+
+  /// <summary>
+  /// 最後に依頼した探索の結果。探索中なら none。
+  /// </summary>
+  const Optional<ShiritoriGraph::ChainLength>& GetResult() const { return result_; }
+
+  /// <summary>
+  /// 探索中、または探索を待っている依頼があるか。
+  /// </summary>
+  bool IsBusy() const { return pending_.valid() || queued_.has_value(); }
+
+private:
+  /// <summary>
+  /// 探索の依頼
+  /// </summary>
+  struct Query
+  {
+    std::shared_ptr<const ShiritoriGraph> graph;
+    KanaId last;
+    Array<uint32> used_words;
+  };
+
+  /// <summary>
+  /// 背景スレッドで探索を始める
+  /// </summary>
+  void Start(Query query);
+
+  /// <summary>
+  /// 背景スレッドで実行中の探索
+  /// </summary>
+  std::future<ShiritoriGraph::ChainLength> pending_;
+
+  /// <summary>
+  /// 探索中に届いた、まだ始めていない依頼（最後のものだけを残す）
+  /// </summary>
+  Optional<Query> queued_;
+
+  /// <summary>
+  /// 最新の依頼に対する結果
+  /// </summary>
+  Optional<ShiritoriGraph::ChainLength> result_;
+};
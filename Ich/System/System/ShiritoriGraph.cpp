@@ -0,0 +1,242 @@
+﻿#include "./ShiritoriGraph.h"
+#include "./DictionaryIndex.h"
+
+#include <algorithm>
+
+namespace
+{
+  /// <summary>
+  /// メモ化のキーに使う乱数（固定の種から作る）
+  /// </summary>
+  constexpr uint64 SplitMix64(uint64 x)
+  {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+
+  /// <summary>
+  /// 最長の鎖の深さ優先探索
+  /// </summary>
+  class ChainSearch
+  {
+  public:
+    ChainSearch(Array<uint16> remaining, const std::array<Array<KanaId>, kKanaAlphabetSize>& successors, const size_t budget)
+      : remaining_(std::move(remaining))
+      , successors_(successors)
+      , budget_(budget)
+    {
+    }
+
+    /// <summary>
+    /// 今の文字が current の状態から続けられる単語数の最大値
+    /// </summary>
+    int32 Search(const KanaId current)
+    {
+      if (++visited_ > budget_)
+      {
+        is_exhausted_ = true;
+        return 0;
+      }
+
+      // 同じ文字で始まり終わる単語は、使っても今の文字が変わらないので、先にすべて使うのが最善になる。
+      const size_t loopPair = PairIndex(current, current);
+      const uint16 loops = remaining_[loopPair];
+      remaining_[loopPair] = 0;
+      used_hash_ += loops * PairKey(loopPair);
+
+      int32 best = 0;
+      const uint64 key = used_hash_ + NodeKey(current);
+
+      if (const auto it = memo_.find(key); it != memo_.end())
+      {
+        best = it->second;
+      }
+      else
+      {
+        for (const KanaId next : successors_[current])
+        {
+          best = std::max(best, Follow(current, next));
+        }
+
+        // 打ち切った探索の値は下限でしかないので覚えない。
+        if (!is_exhausted_)
+        {
+          memo_.emplace(key, best);
+        }
+      }
+
+      used_hash_ -= loops * PairKey(loopPair);
+      remaining_[loopPair] = loops;
+      return loops + best;
+    }
+
+    /// <summary>
+    /// 鎖の先頭から（どの単語から始めてもよい状態から）続けられる単語数の最大値
+    /// </summary>
+    int32 SearchFromAnyStart()
+    {
+      int32 best = 0;
+      for (size_t first = 0; first < kKanaAlphabetSize; ++first)
+      {
+        for (const KanaId next : successors_[first])
+        {
+          best = std::max(best, Follow(static_cast<KanaId>(first), next));
+        }
+
+        if (const uint16 loops = remaining_[PairIndex(static_cast<KanaId>(first), static_cast<KanaId>(first))]; loops > 0)
+        {
+          best = std::max(best, Search(static_cast<KanaId>(first)));
+        }
+      }
+      return best;
+    }
+
+    bool IsExhausted() const { return is_exhausted_; }
+
+  private:
+    static constexpr size_t PairIndex(const KanaId first, const KanaId last) { return static_cast<size_t>(first) * kKanaAlphabetSize + last; }
+
+    static constexpr uint64 PairKey(const size_t pair) { return SplitMix64(pair) | 1; }
+
+    static constexpr uint64 NodeKey(const KanaId id) { return SplitMix64(0x5348495249544F52ull + id); }
+
+    /// <summary>
+    /// current -> next の単語を1つ使って続ける。残っていなければ 0。
+    /// </summary>
+    int32 Follow(const KanaId current, const KanaId next)
+    {
+      const size_t pair = PairIndex(current, next);
+      if (current == next || remaining_[pair] == 0)
+      {
+        return 0;
+      }
+
+      --remaining_[pair];
+      used_hash_ += PairKey(pair);
+      const int32 length = 1 + Search(next);
+      used_hash_ -= PairKey(pair);
+      ++remaining_[pair];
+      return length;
+    }
+
+    Array<uint16> remaining_;
+    const std::array<Array<KanaId>, kKanaAlphabetSize>& successors_;
+    size_t budget_;
+    size_t visited_ = 0;
+    bool is_exhausted_ = false;
+
+    /// <summary>
+    /// 文字の組ごとの使用数から作るハッシュ（使用数 × 組ごとの乱数の和なので、使う・戻すを O(1) で更新できる）
+    /// </summary>
+    uint64 used_hash_ = 0;
+
+    HashTable<uint64, int32> memo_;
+  };
+} // namespace
+
+ShiritoriGraph::ShiritoriGraph()
+  : words_by_first_offsets_(kKanaAlphabetSize + 1, 0)
+  , pair_counts_(kKanaAlphabetSize * kKanaAlphabetSize, 0)
+{
+}
+
+ShiritoriGraph::ShiritoriGraph(const DictionaryIndex& index)
+  : ShiritoriGraph()
+{
+  const size_t wordCount = index.GetWordCount();
+  first_kana_.assign(wordCount, kInvalidKanaId);
+  last_kana_.assign(wordCount, kInvalidKanaId);
+
+  Array<char32> normalized;
+  for (size_t word = 0; word < wordCount; ++word)
+  {
+    if (index.IsRemoved(word))
+    {
+      continue;
+    }
+
+    const StringView text = index.GetWord(word);
+    if (normalized.size() < text.size())
+    {
+      normalized.resize(text.size());
+    }
+
+    const size_t length = NormalizeKana(std::span<const char32>(text.data(), text.size()), normalized);
+    if (length == 0)
+    {
+      continue;
+    }
+
+    first_kana_[word] = ToKanaId(normalized[0]);
+    last_kana_[word] = ToKanaId(normalized[length - 1]);
+    ++words_by_first_offsets_[first_kana_[word] + 1];
+    ++pair_counts_[PairIndex(first_kana_[word], last_kana_[word])];
+  }
+
+  for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+  {
+    words_by_first_offsets_[id + 1] += words_by_first_offsets_[id];
+  }
+
+  words_by_first_.resize(words_by_first_offsets_.back());
+  Array<uint32> cursors(words_by_first_offsets_.begin(), words_by_first_offsets_.end() - 1);
+  for (size_t word = 0; word < wordCount; ++word)
+  {
+    if (first_kana_[word] != kInvalidKanaId)
+    {
+      words_by_first_[cursors[first_kana_[word]]++] = static_cast<uint32>(word);
+    }
+  }
+
+  // 単語の多い組から試すと、打ち切ったときにも長い鎖が見つかりやすい。
+  for (size_t first = 0; first < kKanaAlphabetSize; ++first)
+  {
+    for (size_t last = 0; last < kKanaAlphabetSize; ++last)
+    {
+      if (first != last && pair_counts_[first * kKanaAlphabetSize + last] > 0)
+      {
+        successors_[first] << static_cast<KanaId>(last);
+      }
+    }
+
+    std::stable_sort(successors_[first].begin(), successors_[first].end(), [&](const KanaId a, const KanaId b)
+    {
+      return pair_counts_[first * kKanaAlphabetSize + a] > pair_counts_[first * kKanaAlphabetSize + b];
+    });
+  }
+}
+
+std::span<const uint32> ShiritoriGraph::GetWordsStartingWith(const KanaId id) const
+{
+  if (id >= kKanaAlphabetSize)
+  {
+    return {};
+  }
+
+  return std::span<const uint32>(words_by_first_.data() + words_by_first_offsets_[id], words_by_first_offsets_[id + 1] - words_by_first_offsets_[id]);
+}
+
+bool ShiritoriGraph::CanFollow(const KanaId last, const uint32 word) const
+{
+  const KanaId first = GetFirstKana(word);
+  return (first != kInvalidKanaId) && (last == kInvalidKanaId || last == first);
+}
+
+ShiritoriGraph::ChainLength ShiritoriGraph::FindLongestChain(const KanaId last, const std::span<const uint32> usedWords, const size_t budget) const
+{
+  Array<uint16> remaining = pair_counts_;
+  for (const uint32 word : usedWords)
+  {
+    if (const KanaId first = GetFirstKana(word); first != kInvalidKanaId)
+    {
+      const size_t pair = PairIndex(first, GetLastKana(word));
+      remaining[pair] -= (remaining[pair] > 0) ? 1 : 0;
+    }
+  }
+
+  ChainSearch search(std::move(remaining), successors_, budget);
+  const int32 length = (last == kInvalidKanaId) ? search.SearchFromAnyStart() : search.Search(last);
+  return ChainLength{ length, !search.IsExhausted() };
+}
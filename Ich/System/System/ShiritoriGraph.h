@@ -0,0 +1,103 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./KanaTable.h"
+
+#include <array>
+#include <span>
+
+class DictionaryIndex;
+
+/// <summary>
+/// しりとり用に、辞書の単語を「最初の文字 -> 最後の文字」（どちらも正規化後）の辺として持つグラフ。
+/// 同じ文字の組の単語はしりとりの上では入れ替えられるので、最長の鎖を求めるときは文字の組ごとの本数だけを扱う。
+/// </summary>
+class ShiritoriGraph
+{
+public:
+  /// <summary>
+  /// FindLongestChain で調べる状態数の既定の上限（同梱の辞書で 0.2 秒程度）
+  /// </summary>
+  static constexpr size_t kDefaultSearchBudget = size_t{ 1 } << 18;
+
+  /// <summary>
+  /// 最長の鎖の長さ
+  /// </summary>
+  struct ChainLength
+  {
+    /// <summary>
+    /// これから続けられる単語数
+    /// </summary>
+    int32 length = 0;
+
+    /// <summary>
+    /// 探索を打ち切らずに求めた値か。false の場合、length は下限になる。
+    /// </summary>
+    bool is_exact = true;
+  };
+
+  ShiritoriGraph();
+
+  /// <summary>
+  /// 辞書索引からグラフを構築する。取り除かれた単語は含めない。
+  /// </summary>
+  explicit ShiritoriGraph(const DictionaryIndex& index);
+
+  /// <summary>
+  /// 単語の最初の文字を返す。グラフに含まれない単語なら kInvalidKanaId。
+  /// </summary>
+  KanaId GetFirstKana(const uint32 word) const { return (word < first_kana_.size()) ? first_kana_[word] : kInvalidKanaId; }
+
+  /// <summary>
+  /// 単語の最後の文字を返す。グラフに含まれない単語なら kInvalidKanaId。
+  /// </summary>
+  KanaId GetLastKana(const uint32 word) const { return (word < last_kana_.size()) ? last_kana_[word] : kInvalidKanaId; }
+
+  /// <summary>
+  /// 指定した文字で始まる単語の番号を昇順で返す。
+  /// </summary>
+  std::span<const uint32> GetWordsStartingWith(KanaId id) const;
+
+  /// <summary>
+  /// 直前の単語の最後の文字が last のとき、word を続けられるか。last が kInvalidKanaId なら（鎖の先頭なら）どの単語でもよい。
+  /// </summary>
+  bool CanFollow(KanaId last, uint32 word) const;
+
+  /// <summary>
+  /// 最後の文字が last の状態から、まだ使っていない単語で続けられる鎖の最長の長さを求める。
+  /// (今の文字, 文字の組ごとの使用数) をキーにした深さ優先探索の結果をメモ化し、調べた状態数が budget を超えたら打ち切る。
+  /// </summary>
+  /// <param name="last">直前の単語の最後の文字。鎖の先頭から求める場合は kInvalidKanaId。</param>
+  /// <param name="usedWords">使用済みの単語の番号（グラフに含まれない番号は無視する）。</param>
+  /// <param name="budget">調べる状態数の上限。</param>
+  ChainLength FindLongestChain(KanaId last, std::span<const uint32> usedWords, size_t budget = kDefaultSearchBudget) const;
+
+private:
+  /// <summary>
+  /// 文字の組 (first, last) の番号
+  /// </summary>
+  static constexpr size_t PairIndex(const KanaId first, const KanaId last) { return static_cast<size_t>(first) * kKanaAlphabetSize + last; }
+
+  /// <summary>
+  /// 単語ごとの最初・最後の文字
+  /// </summary>
+  Array<KanaId> first_kana_;
+  Array<KanaId> last_kana_;
+
+  /// <summary>
+  /// 最初の文字ごとに単語番号を並べたもの（words_by_first_offsets_[id] ～ [id + 1] の範囲）
+  /// </summary>
+  Array<uint32> words_by_first_;
+  Array<uint32> words_by_first_offsets_;
+
+  /// <summary>
+  /// 文字の組ごとの単語数
+  /// </summary>
+  Array<uint16> pair_counts_;
+
+  /// <summary>
+  /// 文字ごとに、単語で続けられる最後の文字の一覧（単語数の多い順）
+  /// </summary>
+  std::array<Array<KanaId>, kKanaAlphabetSize> successors_;
+};
@@ -0,0 +1,44 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./KanaTable.h"
+
+/// <summary>
+/// ヒット・リーチ・ヒントをまとめて問い合わせるときの結果の格納先。
+/// 呼び出し側で保持して毎回渡せば、配列の容量が使い回されるため問い合わせごとのヒープ確保も文字列のコピーも発生しない。
+/// 単語は DictionaryIndex の単語番号で表し、表示するときだけ GetWord などで文字列を引く。
+/// </summary>
+struct WordMatchBuffers
+{
+  /// <summary>
+  /// ヒットした単語番号（辞書順）
+  /// </summary>
+  Array<uint32> hit_ids;
+
+  /// <summary>
+  /// リーチ状態の単語番号（辞書順）
+  /// </summary>
+  Array<uint32> reach_ids;
+
+  /// <summary>
+  /// reach_ids[i] の単語に足りない文字のID
+  /// </summary>
+  Array<KanaId> reach_missing;
+
+  /// <summary>
+  /// ヒントとして選んだリーチ単語の reach_ids 内の位置。リーチがない、またはヒントを求めていない場合は none。
+  /// </summary>
+  Optional<size_t> hint;
+
+  /// <summary>
+  /// 容量を残したまま中身を空にする。
+  /// </summary>
+  void Clear()
+  {
+    hit_ids.clear();
+    reach_ids.clear();
+    reach_missing.clear();
+    hint.reset();
+  }
+};
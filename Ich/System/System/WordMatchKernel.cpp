@@ -0,0 +1,310 @@
+﻿#include "./WordMatchKernel.h"
+#include "./DictionaryIndex.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+#if defined(_M_X64) || defined(__x86_64__)
+# define ICH_WORD_MATCH_X64 1
+# include <immintrin.h>
+# if defined(_MSC_VER)
+#   include <intrin.h>
+# endif
+#else
+# define ICH_WORD_MATCH_X64 0
+#endif
+
+// MSVC は /arch 指定なしでも AVX2 組み込み関数を使えるが、GCC / Clang は関数単位で有効化が必要。
+#if ICH_WORD_MATCH_X64 && (defined(__GNUC__) || defined(__clang__))
+# define ICH_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+# define ICH_TARGET_AVX2
+#endif
+
+namespace
+{
+  /// <summary>
+  /// 一度に判定する単語数（= 1 ブロック）。列の切り上げ単位と同じ。
+  /// </summary>
+  constexpr size_t kBlockWidth = DictionaryIndex::kColumnAlignment;
+
+  /// <summary>
+  /// 1 ブロック分の判定結果（ビット i が pos + i 番目の単語に対応）を単語番号として書き出す。
+  /// </summary>
+  void EmitMask(uint32 mask, const size_t pos, Array<uint32>* output)
+  {
+    while (mask != 0)
+    {
+      output->push_back(static_cast<uint32>(pos + std::countr_zero(mask)));
+      mask &= (mask - 1);
+    }
+  }
+
+  /// <summary>
+  /// ブロック内で end を超える単語を除外するためのマスクを返す。
+  /// </summary>
+  uint32 GetValidMask(const size_t pos, const size_t end)
+  {
+    const size_t valid = std::min(end - pos, kBlockWidth);
+    return (valid >= 32) ? 0xFFFFFFFFu : ((1u << valid) - 1u);
+  }
+
+  /// <summary>
+  /// 手持ちが 1 個以上ある文字の一覧。判定ではこの文字の列だけを読めばよい。
+  /// </summary>
+  struct HeldLanes
+  {
+    KanaId ids[kKanaAlphabetSize];
+    uint8 counts[kKanaAlphabetSize];
+    size_t size = 0;
+  };
+
+  HeldLanes CollectHeldLanes(const KanaCounts& held)
+  {
+    HeldLanes lanes;
+
+    for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+    {
+      if (held[id] > 0)
+      {
+        lanes.ids[lanes.size] = static_cast<KanaId>(id);
+        lanes.counts[lanes.size] = held[id];
+        ++lanes.size;
+      }
+    }
+
+    return lanes;
+  }
+
+  /// <summary>
+  /// SIMD を使わない実装。ブロック内の各単語について、手持ちで賄える文字数を列ごとに積み上げる。
+  /// </summary>
+  void CollectMatchesScalar(const WordMatchKernel::ColumnView& index, const HeldLanes& lanes, const size_t begin, const size_t end, Array<uint32>* hits, Array<uint32>* reaches)
+  {
+    const uint8* lengths = index.GetLengthColumn();
+
+    for (size_t pos = begin; pos < end; pos += kBlockWidth)
+    {
+      uint8 covered[kBlockWidth] = {};
+
+      for (size_t lane = 0; lane < lanes.size; ++lane)
+      {
+        const uint8* column = index.GetColumn(lanes.ids[lane]) + pos;
+        const uint8 have = lanes.counts[lane];
+
+        for (size_t i = 0; i < kBlockWidth; ++i)
+        {
+          covered[i] = static_cast<uint8>(covered[i] + ((column[i] < have) ? column[i] : have));
+        }
+      }
+
+      uint32 hitMask = 0;
+      uint32 reachMask = 0;
+
+      for (size_t i = 0; i < kBlockWidth; ++i)
+      {
+        const int32 deficit = static_cast<int32>(lengths[pos + i]) - static_cast<int32>(covered[i]);
+        hitMask |= static_cast<uint32>(deficit == 0) << i;
+        reachMask |= static_cast<uint32>(deficit == 1) << i;
+      }
+
+      const uint32 validMask = GetValidMask(pos, end);
+      if (hits)
+      {
+        EmitMask(hitMask & validMask, pos, hits);
+      }
+      if (reaches)
+      {
+        EmitMask(reachMask & validMask, pos, reaches);
+      }
+    }
+  }
+
+#if ICH_WORD_MATCH_X64
+  /// <summary>
+  /// SSE2 実装。16 単語ずつ 2 回に分けて 1 ブロックを判定する。
+  /// </summary>
+  void CollectMatchesSse2(const WordMatchKernel::ColumnView& index, const HeldLanes& lanes, const size_t begin, const size_t end, Array<uint32>* hits, Array<uint32>* reaches)
+  {
+    __m128i have[kKanaAlphabetSize];
+    for (size_t lane = 0; lane < lanes.size; ++lane)
+    {
+      have[lane] = _mm_set1_epi8(static_cast<char>(lanes.counts[lane]));
+    }
+
+    const uint8* lengths = index.GetLengthColumn();
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+
+    for (size_t pos = begin; pos < end; pos += kBlockWidth)
+    {
+      __m128i coveredLow = _mm_setzero_si128();
+      __m128i coveredHigh = _mm_setzero_si128();
+
+      for (size_t lane = 0; lane < lanes.size; ++lane)
+      {
+        const uint8* column = index.GetColumn(lanes.ids[lane]) + pos;
+        const __m128i needLow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column));
+        const __m128i needHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + 16));
+        coveredLow = _mm_adds_epu8(coveredLow, _mm_min_epu8(needLow, have[lane]));
+        coveredHigh = _mm_adds_epu8(coveredHigh, _mm_min_epu8(needHigh, have[lane]));
+      }
+
+      const __m128i lengthLow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lengths + pos));
+      const __m128i lengthHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lengths + pos + 16));
+      const __m128i deficitLow = _mm_subs_epu8(lengthLow, coveredLow);
+      const __m128i deficitHigh = _mm_subs_epu8(lengthHigh, coveredHigh);
+
+      const uint32 hitMask = static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(deficitLow, zero)))
+        | (static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(deficitHigh, zero))) << 16);
+      const uint32 reachMask = static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(deficitLow, one)))
+        | (static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(deficitHigh, one))) << 16);
+
+      const uint32 validMask = GetValidMask(pos, end);
+      if (hits)
+      {
+        EmitMask(hitMask & validMask, pos, hits);
+      }
+      if (reaches)
+      {
+        EmitMask(reachMask & validMask, pos, reaches);
+      }
+    }
+  }
+
+  /// <summary>
+  /// AVX2 実装。32 単語（1 ブロック）を一度に判定する。
+  /// </summary>
+  ICH_TARGET_AVX2
+  void CollectMatchesAvx2(const WordMatchKernel::ColumnView& index, const HeldLanes& lanes, const size_t begin, const size_t end, Array<uint32>* hits, Array<uint32>* reaches)
+  {
+    __m256i have[kKanaAlphabetSize];
+    for (size_t lane = 0; lane < lanes.size; ++lane)
+    {
+      have[lane] = _mm256_set1_epi8(static_cast<char>(lanes.counts[lane]));
+    }
+
+    const uint8* lengths = index.GetLengthColumn();
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+
+    for (size_t pos = begin; pos < end; pos += kBlockWidth)
+    {
+      __m256i covered = _mm256_setzero_si256();
+
+      for (size_t lane = 0; lane < lanes.size; ++lane)
+      {
+        const uint8* column = index.GetColumn(lanes.ids[lane]) + pos;
+        const __m256i need = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column));
+        covered = _mm256_adds_epu8(covered, _mm256_min_epu8(need, have[lane]));
+      }
+
+      const __m256i length = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lengths + pos));
+      const __m256i deficit = _mm256_subs_epu8(length, covered);
+
+      const uint32 hitMask = static_cast<uint32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(deficit, zero)));
+      const uint32 reachMask = static_cast<uint32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(deficit, one)));
+
+      const uint32 validMask = GetValidMask(pos, end);
+      if (hits)
+      {
+        EmitMask(hitMask & validMask, pos, hits);
+      }
+      if (reaches)
+      {
+        EmitMask(reachMask & validMask, pos, reaches);
+      }
+    }
+  }
+
+  /// <summary>
+  /// CPU と OS が AVX2（YMM レジスタの保存を含む）に対応しているかを調べる。
+  /// </summary>
+  bool IsAvx2Supported()
+  {
+# if defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+      return false;
+    }
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+    {
+      return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+# else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+# endif
+  }
+#endif
+} // namespace
+
+namespace WordMatchKernel
+{
+  InstructionSet GetInstructionSet()
+  {
+#if ICH_WORD_MATCH_X64
+    static const InstructionSet instructionSet = IsAvx2Supported() ? InstructionSet::kAvx2 : InstructionSet::kSse2;
+    return instructionSet;
+#else
+    return InstructionSet::kScalar;
+#endif
+  }
+
+  void CollectMatches(const DictionaryIndex& index, const KanaCounts& held, const size_t begin, const size_t end, Array<uint32>* hits, Array<uint32>* reaches)
+  {
+    CollectMatches(GetInstructionSet(), index, held, begin, end, hits, reaches);
+  }
+
+  void CollectMatches(const InstructionSet instructionSet, const DictionaryIndex& index, const KanaCounts& held, const size_t begin, const size_t end, Array<uint32>* hits, Array<uint32>* reaches)
+  {
+    CollectMatches(instructionSet, index.GetColumnView(), held, begin, end, hits, reaches);
+  }
+
+  void CollectMatches(const ColumnView& view, const KanaCounts& held, const size_t begin, const size_t end, Array<uint32>* hits, Array<uint32>* reaches)
+  {
+    CollectMatches(GetInstructionSet(), view, held, begin, end, hits, reaches);
+  }
+
+  void CollectMatches(const InstructionSet instructionSet, const ColumnView& view, const KanaCounts& held, const size_t begin, size_t end, Array<uint32>* hits, Array<uint32>* reaches)
+  {
+    assert(begin % kBlockWidth == 0);
+
+    end = std::min(end, view.GetWordCount());
+    if (end <= begin)
+    {
+      return;
+    }
+
+    // 対応していない命令セットが指定された場合は、使える範囲で最も近いものに落とす。
+    const InstructionSet supported = GetInstructionSet();
+    const InstructionSet selected = (supported < instructionSet) ? supported : instructionSet;
+
+    const HeldLanes lanes = CollectHeldLanes(held);
+
+    switch (selected)
+    {
+#if ICH_WORD_MATCH_X64
+    case InstructionSet::kAvx2:
+      CollectMatchesAvx2(view, lanes, begin, end, hits, reaches);
+      return;
+    case InstructionSet::kSse2:
+      CollectMatchesSse2(view, lanes, begin, end, hits, reaches);
+      return;
+#endif
+    default:
+      CollectMatchesScalar(view, lanes, begin, end, hits, reaches);
+      return;
+    }
+  }
+}
@@ -0,0 +1,74 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./KanaTable.h"
+
+class DictionaryIndex;
+
+/// <summary>
+/// DictionaryIndex の SoA 列をまとめて比較し、不足数 0（ヒット）／1（リーチ）の単語を抽出する処理。
+/// 各単語の不足数は「単語の長さ - 手持ちで賄える文字数（文字ごとの min(必要数, 手持ち数) の合計）」で、
+/// 手持ちのある文字（最大 7 種類程度）の列だけをバイト単位の min・飽和加算で積み上げれば求まるため、
+/// SIMD で 16 ～ 32 単語ずつ判定できる。
+/// </summary>
+namespace WordMatchKernel
+{
+  /// <summary>
+  /// 判定に使う SoA 列への参照。DictionaryIndex のほか、ファイルを割り当てた辞書（MappedDictionary）の
+  /// 領域をそのまま指すこともできる。各列は stride 個分あり、単語数を超える部分は 0 で埋めてあること。
+  /// </summary>
+  struct ColumnView
+  {
+    const uint8* columns = nullptr;
+    const uint8* lengths = nullptr;
+    size_t stride = 0;
+    size_t word_count = 0;
+
+    const uint8* GetColumn(const KanaId id) const { return columns + static_cast<size_t>(id) * stride; }
+    const uint8* GetLengthColumn() const { return lengths; }
+    size_t GetWordCount() const { return word_count; }
+  };
+
+  /// <summary>
+  /// 使用する命令セット。
+  /// </summary>
+  enum class InstructionSet
+  {
+    kScalar,
+    kSse2,
+    kAvx2,
+  };
+
+  /// <summary>
+  /// 実行中の CPU で利用できる最も高速な命令セットを返す（初回呼び出し時に判定して保持する）。
+  /// </summary>
+  InstructionSet GetInstructionSet();
+
+  /// <summary>
+  /// [begin, end) の単語を判定し、ヒットとリーチの単語番号をそれぞれ昇順で末尾に追加する。
+  /// </summary>
+  /// <param name="index">判定対象の辞書索引。</param>
+  /// <param name="held">手持ちブロックの文字数。</param>
+  /// <param name="begin">判定を始める単語番号。DictionaryIndex::kColumnAlignment の倍数であること。</param>
+  /// <param name="end">判定を終える単語番号（この番号は含まない）。</param>
+  /// <param name="hits">ヒットした単語番号の追加先。不要なら nullptr。</param>
+  /// <param name="reaches">リーチの単語番号の追加先。不要なら nullptr。</param>
+  void CollectMatches(const DictionaryIndex& index, const KanaCounts& held, size_t begin, size_t end, Array<uint32>* hits, Array<uint32>* reaches);
+
+  /// <summary>
+  /// 命令セットを指定して CollectMatches を実行する。テストで各実装の結果を比較するために使う。
+  /// 実行中の CPU が対応していない命令セットを指定した場合は、対応している範囲に落として実行する。
+  /// </summary>
+  void CollectMatches(InstructionSet instructionSet, const DictionaryIndex& index, const KanaCounts& held, size_t begin, size_t end, Array<uint32>* hits, Array<uint32>* reaches);
+
+  /// <summary>
+  /// 列を直接指定して CollectMatches を実行する。
+  /// </summary>
+  void CollectMatches(const ColumnView& view, const KanaCounts& held, size_t begin, size_t end, Array<uint32>* hits, Array<uint32>* reaches);
+
+  /// <summary>
+  /// 命令セットと列を指定して CollectMatches を実行する。
+  /// </summary>
+  void CollectMatches(InstructionSet instructionSet, const ColumnView& view, const KanaCounts& held, size_t begin, size_t end, Array<uint32>* hits, Array<uint32>* reaches);
+}
@@ -0,0 +1,231 @@
+﻿#include "./WordPackingSolver.h"
+#include "./AnagramIndex.h"
+#include "./DictionaryIndex.h"
+#include "./IncrementalWordMatcher.h"
+#include "./WordMatchKernel.h"
+
+#include <algorithm>
+
+namespace
+{
+  /// <summary>
+  /// 手持ちのある文字ごとの桁を持つ混合基数で、部分多重集合を 0 ～ state_count-1 の番号に対応させる。
+  /// 桁ごとの値はその文字を使う個数。
+  /// </summary>
+  struct SubsetEncoding
+  {
+    KanaId ids[kKanaAlphabetSize];
+    uint8 counts[kKanaAlphabetSize];
+    uint32 weights[kKanaAlphabetSize];
+    size_t size = 0;
+    size_t state_count = 1;
+
+    uint8 GetDigit(const uint32 code, const size_t lane) const
+    {
+      return static_cast<uint8>((code / weights[lane]) % (counts[lane] + 1u));
+    }
+
+    /// <summary>
+    /// sub の各桁が code の桁以下か（sub が code の部分多重集合か）
+    /// </summary>
+    bool Contains(const uint32 code, const uint32 sub) const
+    {
+      for (size_t lane = 0; lane < size; ++lane)
+      {
+        if (GetDigit(sub, lane) > GetDigit(code, lane))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    /// <summary>
+    /// 単語の文字数を番号にする。手持ちで作れない単語なら none。
+    /// </summary>
+    Optional<uint32> Encode(const KanaCounts& required) const
+    {
+      uint32 code = 0;
+      size_t used = 0;
+
+      for (size_t lane = 0; lane < size; ++lane)
+      {
+        if (required[ids[lane]] > counts[lane])
+        {
+          return none;
+        }
+        code += required[ids[lane]] * weights[lane];
+        used += required[ids[lane]];
+      }
+
+      // 手持ちにない文字を使う単語は作れない。
+      size_t total = 0;
+      for (const uint8 count : required)
+      {
+        total += count;
+      }
+
+      return (used == total) ? Optional<uint32>{ code } : none;
+    }
+  };
+
+  /// <summary>
+  /// 選べる単語（部分多重集合の番号と得点）
+  /// </summary>
+  struct PackingItem
+  {
+    uint32 code;
+    uint32 word;
+    int32 score;
+  };
+} // namespace
+
+Optional<WordPackingSolver::Result> WordPackingSolver::Solve(const DictionaryIndex& index, const KanaCounts& held, const Scorer& scorer)
+{
+  SubsetEncoding encoding;
+  size_t heldTotal = 0;
+
+  for (size_t id = 0; id < kKanaAlphabetSize; ++id)
+  {
+    if (held[id] == 0)
+    {
+      continue;
+    }
+
+    encoding.ids[encoding.size] = static_cast<KanaId>(id);
+    encoding.counts[encoding.size] = held[id];
+    encoding.weights[encoding.size] = static_cast<uint32>(encoding.state_count);
+    encoding.state_count *= (held[id] + 1u);
+    ++encoding.size;
+    heldTotal += held[id];
+
+    if (encoding.state_count > kMaxStateCount)
+    {
+      return none;
+    }
+  }
+
+  const auto getScore = [&](const uint32 word)
+  {
+    return scorer ? scorer(index, word) : static_cast<int32>(index.GetLength(word));
+  };
+
+  Array<PackingItem> items;
+
+  const auto offerWord = [&](const uint32 code, const uint32 word)
+  {
+    if (const int32 score = getScore(word); score > 0)
+    {
+      items.push_back(PackingItem{ code, word, score });
+    }
+  };
+
+  if (!index.IsPatched() && heldTotal <= AnagramIndex::kMaxSignatureLength)
+  {
+    // 部分多重集合ごとに署名を作ってハッシュ表を引く（文字は ID の昇順に追加する）。
+    for (uint32 code = 1; code < encoding.state_count; ++code)
+    {
+      uint64 signature = 0;
+      for (size_t lane = 0; lane < encoding.size; ++lane)
+      {
+        for (uint8 i = 0; i < encoding.GetDigit(code, lane); ++i)
+        {
+          signature = AnagramIndex::AppendSymbol(signature, encoding.ids[lane]);
+        }
+      }
+
+      for (const uint32 word : index.GetAnagramIndex().FindWords(signature))
+      {
+        offerWord(code, word);
+      }
+    }
+  }
+  else
+  {
+    // 署名の表が使えない場合（辞書の差分更新後や長い手持ち）は、ヒット単語を走査して振り分ける。
+    Array<uint32> hits;
+    WordMatchKernel::CollectMatches(index, held, 0, index.GetWordCount(), &hits, nullptr);
+
+    for (const uint32 word : hits)
+    {
+      if (const auto code = encoding.Encode(index.GetCounts(word)); code && *code != 0)
+      {
+        offerWord(*code, word);
+      }
+    }
+  }
+
+  // 0/1 ナップサック。best[state] = state 以下の文字で作れる組み合わせの得点の最大値。
+  // 同じ単語を二度選ばないよう、単語ごとに state を大きい方から更新する（state - code は必ず state より小さい番号になる）。
+  Array<int32> best(encoding.state_count, 0);
+  Array<bool> taken(items.size() * encoding.state_count, false);
+
+  for (size_t item = 0; item < items.size(); ++item)
+  {
+    const PackingItem& packingItem = items[item];
+
+    for (uint32 state = static_cast<uint32>(encoding.state_count); state-- > packingItem.code;)
+    {
+      if (!encoding.Contains(state, packingItem.code))
+      {
+        continue;
+      }
+
+      if (const int32 score = best[state - packingItem.code] + packingItem.score; score > best[state])
+      {
+        best[state] = score;
+        taken[item * encoding.state_count + state] = true;
+      }
+    }
+  }
+
+  Result result;
+  uint32 state = static_cast<uint32>(encoding.state_count - 1);
+  result.score = best[state];
+
+  for (size_t item = items.size(); item-- > 0;)
+  {
+    if (!taken[item * encoding.state_count + state])
+    {
+      continue;
+    }
+
+    const PackingItem& packingItem = items[item];
+    result.word_ids << packingItem.word;
+    state -= packingItem.code;
+
+    for (size_t lane = 0; lane < encoding.size; ++lane)
+    {
+      result.used[encoding.ids[lane]] += encoding.GetDigit(packingItem.code, lane);
+    }
+  }
+
+  std::sort(result.word_ids.begin(), result.word_ids.end());
+  return result;
+}
+
+Optional<WordPackingSolver::Result> WordPackingSolver::CashIn(const DictionaryIndex& index, IncrementalWordMatcher& matcher, Array<KanaId>& held)
+{
+  const auto result = Solve(index, matcher.GetHeldCounts());
+  if (!result || result->word_ids.isEmpty())
+  {
+    return result;
+  }
+
+  KanaCounts rest = result->used;
+  for (auto it = held.begin(); it != held.end();)
+  {
+    if (*it != kInvalidKanaId && rest[*it] > 0)
+    {
+      --rest[*it];
+      matcher.Evict(*it);
+      it = held.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  return result;
+}
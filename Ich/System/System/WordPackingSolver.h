@@ -0,0 +1,70 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./KanaTable.h"
+
+#include <functional>
+
+class DictionaryIndex;
+class IncrementalWordMatcher;
+
+/// <summary>
+/// 手持ちの文字を重複なく分け合って同時に作れる単語の組み合わせのうち、得点の合計が最大になるものを求める処理。
+/// 手持ちの部分多重集合（手持ち 7 文字なら高々 128 通り）を状態にした 0/1 ナップサックで解く。
+/// 各部分多重集合でちょうど作れる単語は、AnagramIndex の署名を引いて求める。同じ単語は二度選ばない。
+/// </summary>
+class WordPackingSolver
+{
+public:
+  /// <summary>
+  /// 単語の得点を返す関数。0 以下の単語は選ばない。
+  /// </summary>
+  using Scorer = std::function<int32(const DictionaryIndex& index, uint32 word)>;
+
+  /// <summary>
+  /// 解いた結果
+  /// </summary>
+  struct Result
+  {
+    /// <summary>
+    /// 選んだ単語の番号（昇順）
+    /// </summary>
+    Array<uint32> word_ids;
+
+    /// <summary>
+    /// 得点の合計
+    /// </summary>
+    int32 score = 0;
+
+    /// <summary>
+    /// 選んだ単語で使う文字数
+    /// </summary>
+    KanaCounts used{};
+  };
+
+  /// <summary>
+  /// 手持ちの部分多重集合の数の上限。超える場合は解かない（計算量は作れる単語の数と部分多重集合の数の積）。
+  /// </summary>
+  static constexpr size_t kMaxStateCount = 512;
+
+  /// <summary>
+  /// 得点が最大になる単語の組み合わせを求める。
+  /// </summary>
+  /// <param name="index">辞書索引。</param>
+  /// <param name="held">手持ちブロックの文字数。</param>
+  /// <param name="scorer">単語の得点。省略した場合は単語の長さ（使う文字数）。</param>
+  /// <returns>部分多重集合の数が kMaxStateCount を超える場合は none。作れる単語がない場合は空の結果。</returns>
+  static Optional<Result> Solve(const DictionaryIndex& index, const KanaCounts& held, const Scorer& scorer = nullptr);
+
+  /// <summary>
+  /// 手持ちの文字で同時に作れる単語の組み合わせを換金する。得点は単語の長さで、既に完成として数えた単語も選ぶ
+  /// （順不同モードでは作れた時点で完成になるので、完成済みを除くと換金できる単語がなくなる）。
+  /// 選んだ単語に使う文字は、手持ちの並びの古い方から取り除き、判定器からも外す。
+  /// </summary>
+  /// <param name="index">辞書索引。</param>
+  /// <param name="matcher">手持ちの文字を入れた判定器。</param>
+  /// <param name="held">手持ちの文字の並び（古い順、空き枠は kInvalidKanaId）。</param>
+  /// <returns>Solve の結果。作れる単語がなければ手持ちは変更しない。</returns>
+  static Optional<Result> CashIn(const DictionaryIndex& index, IncrementalWordMatcher& matcher, Array<KanaId>& held);
+};
@@ -0,0 +1,56 @@
+﻿#include "./WordStateSnapshot.h"
+#include "./IncrementalWordMatcher.h"
+
+WordStateSnapshot::WordStateSnapshot() = default;
+
+bool WordStateSnapshot::Refresh(const IncrementalWordMatcher& matcher, const Array<KanaId>& heldBlocks, const Array<String>& completedWords, const bool wantHint)
+{
+  const bool matchesChanged = !is_valid_ || wantHint || matcher.GetRevision() != matcher_revision_;
+  const bool flagsChanged = !is_valid_ || heldBlocks != held_blocks_ || completedWords.size() != completed_count_;
+
+  if (!matchesChanged && !flagsChanged)
+  {
+    return false;
+  }
+
+  if (matchesChanged)
+  {
+    matcher.QueryMatches(matches_, wantHint);
+    matcher_revision_ = matcher.GetRevision();
+  }
+
+  if (flagsChanged)
+  {
+    in_completed_word_.assign(heldBlocks.size(), false);
+
+    for (size_t slot = 0; slot < heldBlocks.size(); ++slot)
+    {
+      if (heldBlocks[slot] == kInvalidKanaId)
+      {
+        continue;
+      }
+
+      const char32 ch = FromKanaId(heldBlocks[slot]);
+      for (const auto& completedWord : completedWords)
+      {
+        if (completedWord.includes(ch))
+        {
+          in_completed_word_[slot] = true;
+          break;
+        }
+      }
+    }
+
+    held_blocks_ = heldBlocks;
+    completed_count_ = completedWords.size();
+  }
+
+  is_valid_ = true;
+  ++version_;
+  return true;
+}
+
+void WordStateSnapshot::Invalidate()
+{
+  is_valid_ = false;
+}
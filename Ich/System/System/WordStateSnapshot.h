@@ -0,0 +1,73 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include "./KanaTable.h"
+#include "./WordMatchBuffers.h"
+
+class IncrementalWordMatcher;
+
+/// <summary>
+/// 手持ちブロックに対するヒット・リーチと、手持ちの各ブロックが完成済みの単語に含まれるかどうかをまとめて保持するスナップショット。
+/// 入力（手持ち・判定器・完成済み単語）が変わったときだけ計算し直すので、
+/// 同じフレームの update / draw / ヒント更新から何度参照しても判定は1回で済む。
+/// </summary>
+class WordStateSnapshot
+{
+public:
+  WordStateSnapshot();
+
+  /// <summary>
+  /// 入力が前回から変わっていれば計算し直す。
+  /// </summary>
+  /// <param name="matcher">手持ちを反映済みの判定器。</param>
+  /// <param name="heldBlocks">手持ちブロックの文字（表示順）。空きは kInvalidKanaId。</param>
+  /// <param name="completedWords">完成済みの単語一覧。追加のみで、既存の要素は変更しないこと。</param>
+  /// <param name="wantHint">
+  /// true なら、入力が変わっていなくてもヒット・リーチを問い合わせ直し、GetMatches().hint にヒントを選び直す。
+  /// ヒントの抽選は問い合わせの走査に含まれるので、別に選び直す処理はいらない。
+  /// </param>
+  /// <returns>計算し直した場合は true。</returns>
+  bool Refresh(const IncrementalWordMatcher& matcher, const Array<KanaId>& heldBlocks, const Array<String>& completedWords, bool wantHint = false);
+
+  /// <summary>
+  /// 次の Refresh で必ず計算し直すようにする。
+  /// </summary>
+  void Invalidate();
+
+  /// <summary>
+  /// 計算し直すたびに増える番号。
+  /// </summary>
+  uint64 GetVersion() const { return version_; }
+
+  /// <summary>
+  /// ヒット・リーチの単語番号（辞書順）。hint は wantHint を指定して計算し直したときだけ選ばれる。
+  /// </summary>
+  const WordMatchBuffers& GetMatches() const { return matches_; }
+
+  /// <summary>
+  /// slot 番目の手持ちブロックが、完成済みの単語のどれかに含まれるか。空きは含まれない扱い。
+  /// </summary>
+  bool IsInCompletedWord(size_t slot) const { return slot < in_completed_word_.size() && in_completed_word_[slot]; }
+
+private:
+  /// <summary>
+  /// 判定結果
+  /// </summary>
+  WordMatchBuffers matches_;
+
+  /// <summary>
+  /// 手持ちブロックごとの「完成済みの単語に含まれる」フラグ
+  /// </summary>
+  Array<bool> in_completed_word_;
+
+  /// <summary>
+  /// 前回計算したときの入力
+  /// </summary>
+  Array<KanaId> held_blocks_;
+  size_t completed_count_ = 0;
+  uint64 matcher_revision_ = 0;
+  bool is_valid_ = false;
+
+  uint64 version_ = 0;
+};
@@ -0,0 +1,130 @@
+﻿#include "./WorkerPool.h"
+
+#include <algorithm>
+
+namespace
+{
+  /// <summary>
+  /// 現在のスレッドがワーカースレッドかどうか（入れ子の ParallelFor を順番に実行するため）
+  /// </summary>
+  thread_local bool tIsWorkerThread = false;
+} // namespace
+
+// ワーカープールのインスタンス初期化
+std::shared_ptr<WorkerPool> WorkerPool::instance_ = nullptr;
+std::once_flag WorkerPool::instance_flag_;
+
+WorkerPool* WorkerPool::GetInstance()
+{
+  // 背景スレッド（辞書の読み込みなど）から最初に呼ばれることもあるので、作るのは必ず1回だけにする。
+  std::call_once(instance_flag_, []() {
+    // 呼び出し元スレッドも処理に加わるため、ワーカーは論理コア数 - 1 本にする。
+    const size_t hardwareThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    instance_ = std::make_shared<WorkerPool>(hardwareThreads - 1);
+  });
+
+  return instance_.get();
+}
+
+WorkerPool::WorkerPool(const size_t threadCount)
+{
+  workers_.reserve(threadCount);
+
+  for (size_t i = 0; i < threadCount; ++i)
+  {
+    workers_.emplace_back([this]() { WorkerLoop(); });
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard lock{ mutex_ };
+    is_stopping_ = true;
+  }
+  wake_condition_.notify_all();
+
+  for (auto& worker : workers_)
+  {
+    worker.join();
+  }
+}
+
+void WorkerPool::ParallelFor(const size_t count, const std::function<void(size_t)>& function)
+{
+  if (count == 0)
+  {
+    return;
+  }
+
+  if (workers_.empty() || count == 1 || tIsWorkerThread)
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      function(i);
+    }
+    return;
+  }
+
+  std::lock_guard submitLock{ submit_mutex_ };
+
+  {
+    std::lock_guard lock{ mutex_ };
+    function_ = &function;
+    item_count_ = count;
+    next_item_.store(0);
+    finished_workers_ = 0;
+    ++generation_;
+  }
+  wake_condition_.notify_all();
+
+  RunItems();
+
+  // すべてのワーカーが今回の仕事から抜けるまで待つ（function の参照を手放させるため）。
+  std::unique_lock lock{ mutex_ };
+  done_condition_.wait(lock, [this]() { return finished_workers_ == workers_.size(); });
+  function_ = nullptr;
+}
+
+void WorkerPool::WorkerLoop()
+{
+  tIsWorkerThread = true;
+  uint64 seenGeneration = 0;
+
+  while (true)
+  {
+    {
+      std::unique_lock lock{ mutex_ };
+      wake_condition_.wait(lock, [&]() { return is_stopping_ || generation_ != seenGeneration; });
+
+      if (is_stopping_)
+      {
+        return;
+      }
+
+      seenGeneration = generation_;
+    }
+
+    RunItems();
+
+    {
+      std::lock_guard lock{ mutex_ };
+      ++finished_workers_;
+    }
+    done_condition_.notify_one();
+  }
+}
+
+void WorkerPool::RunItems()
+{
+  while (true)
+  {
+    const size_t item = next_item_.fetch_add(1);
+    if (item >= item_count_)
+    {
+      return;
+    }
+
+    (*function_)(item);
+  }
+}
@@ -0,0 +1,90 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// 辞書走査などの重い処理を分割して並列実行するためのワーカースレッド群。
+/// スレッドは最初に使うときに一度だけ作り、以降の呼び出しでは使い回す。
+/// </summary>
+class WorkerPool
+{
+public:
+  /// <summary>
+  /// インスタンス取得（どのスレッドから呼んでもよい）
+  /// </summary>
+  static WorkerPool* GetInstance();
+
+  /// <summary>
+  /// インスタンスを削除（ワーカースレッドを終了する）
+  /// ゲーム終了時に、プールを使うもの（シーンなど）をすべて破棄してから必ず呼ぶ。以降は GetInstance で作り直さない
+  /// </summary>
+  static void Destroy() {
+    if (instance_ != nullptr) {
+      instance_ = nullptr;
+    }
+  }
+
+  /// <summary>
+  /// コンストラクタ
+  /// </summary>
+  /// <param name="threadCount">ワーカースレッド数（呼び出し元スレッドを含まない）</param>
+  explicit WorkerPool(size_t threadCount);
+
+  /// <summary>
+  /// デストラクタ
+  /// </summary>
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  /// <summary>
+  /// 呼び出し元スレッドを含めた、同時に処理できるスレッド数を返す。
+  /// </summary>
+  size_t GetConcurrency() const { return workers_.size() + 1; }
+
+  /// <summary>
+  /// 0 ～ count-1 の各番号について function を並列に呼び出し、すべて終わるまで待つ。
+  /// 呼び出し元スレッドも処理に加わる。ワーカースレッド上から呼ばれた場合は順番に実行する。
+  /// </summary>
+  void ParallelFor(size_t count, const std::function<void(size_t)>& function);
+
+private:
+  /// <summary>
+  /// ワーカースレッドの処理
+  /// </summary>
+  void WorkerLoop();
+
+  /// <summary>
+  /// 実行中の仕事から番号を取り出して処理する
+  /// </summary>
+  void RunItems();
+
+  static std::shared_ptr<WorkerPool> instance_;
+  static std::once_flag instance_flag_;
+
+  std::vector<std::thread> workers_;
+
+  // ParallelFor を同時に1つだけ実行するためのロック
+  std::mutex submit_mutex_;
+
+  // 仕事の受け渡し用
+  std::mutex mutex_;
+  std::condition_variable wake_condition_;
+  std::condition_variable done_condition_;
+
+  const std::function<void(size_t)>* function_ = nullptr;
+  size_t item_count_ = 0;
+  std::atomic<size_t> next_item_{ 0 };
+  size_t finished_workers_ = 0;
+  uint64 generation_ = 0;
+  bool is_stopping_ = false;
+};
@@ -0,0 +1,28 @@
+﻿#include <Siv3D.hpp>
+
+#include "./DifferentialWordEngine.h"
+
+#include <cstdlib>
+
+// 画面を作らずに実行する（CI などディスプレイのない環境向け）
+SIV3D_SET(EngineOption::Renderer::Headless)
+
+/// <summary>
+/// 単語判定の方式の突き合わせ（DifferentialWordEngine）をコマンドラインから実行する。CppUnitTest を使えない Linux 向け。
+/// 引数で乱数の種と辞書の数を変えられる（例: IchDifferentialTest 12345 1000）。食い違いがあれば終了コード 1 で終わる。
+/// </summary>
+void Main()
+{
+  const Array<String> args = System::GetCommandLineArgs();
+  const uint32 seed = (args.size() > 1) ? ParseOr<uint32>(args[1], DifferentialWordEngine::kDefaultSeed) : DifferentialWordEngine::kDefaultSeed;
+  const size_t caseCount = (args.size() > 2) ? ParseOr<size_t>(args[2], DifferentialWordEngine::kDefaultCaseCount) : DifferentialWordEngine::kDefaultCaseCount;
+
+  const DifferentialWordEngine::Report report = DifferentialWordEngine::Run(seed, caseCount);
+  Console << U"seed " << seed << U": " << report.query_count << U" queries (" << report.non_empty_query_count << U" with hits or reaches)";
+
+  if (report.mismatch)
+  {
+    Console << DifferentialWordEngine::Describe(*report.mismatch);
+    std::exit(EXIT_FAILURE);
+  }
+}
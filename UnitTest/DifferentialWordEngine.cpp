@@ -0,0 +1,433 @@
+﻿#include "./DifferentialWordEngine.h"
+#include "../Ich/System/System/AlphabetWordEngine.h"
+#include "../Ich/System/System/BlockManager.h"
+#include "../Ich/System/System/DictionaryIndex.h"
+#include "../Ich/System/System/IncrementalWordMatcher.h"
+#include "../Ich/System/System/MappedDictionary.h"
+#include "../Ich/System/System/PackedDictionary.h"
+#include "../Ich/System/System/WordMatchBuffers.h"
+#include "../Ich/System/System/WordMatchKernel.h"
+#include "../Ich/Keywords.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <utility>
+
+namespace
+{
+  /// <summary>
+  /// 1つの方式の判定結果
+  /// </summary>
+  struct EngineResult
+  {
+    Array<String> hits;
+    Array<std::pair<String, String>> reaches;
+
+    bool operator==(const EngineResult& other) const { return hits == other.hits && reaches == other.reaches; }
+  };
+
+  using Engine = std::function<EngineResult(const Array<String>& blocks)>;
+
+  /// <summary>
+  /// 正規化の境界になる文字。辞書の単語から取った文字に混ぜて手持ちを作る。
+  /// </summary>
+  constexpr char32 kEdgeCharacters[] = U"がぎぐげござじずぜぞだぢづでどばびぶべぼぱぴぷぺぽぁぃぅぇぉっゃゅょゎゐゑをんー";
+
+  /// <summary>
+  /// 辞書に加える、正規化の境界を含む単語
+  /// </summary>
+  const Array<String>& GetEdgeWords()
+  {
+    static const Array<String> words = { U"らーめん", U"きっぷ", U"ちょっと", U"ぱーてぃー", U"がっこう", U"ぎゅうにゅう", U"でぃーぜる", U"ゐど", U"ゑがお", U"ぢぢ", U"づつみ" };
+    return words;
+  }
+
+  EngineResult GetReferenceResult(const Array<String>& dictionary, const Array<String>& blocks)
+  {
+    const BlockManager reference;
+    return EngineResult{ reference.GetHitWords(blocks, dictionary), reference.GetReachWords(blocks, dictionary) };
+  }
+
+  EngineResult FromIds(const DictionaryIndex& index, const KanaCounts& held, const Array<uint32>& hits, const Array<uint32>& reaches)
+  {
+    EngineResult result;
+    for (const uint32 id : hits)
+    {
+      result.hits << String{ index.GetWord(id) };
+    }
+    for (const uint32 id : reaches)
+    {
+      result.reaches.emplace_back(String{ index.GetWord(id) }, index.GetMissingCharacter(id, index.FindMissingKana(id, held), held));
+    }
+    return result;
+  }
+
+  String ToText(const EngineResult& result)
+  {
+    String text = U"hits: [";
+    for (size_t i = 0; i < result.hits.size(); ++i)
+    {
+      text += (i == 0 ? U"" : U", ") + result.hits[i];
+    }
+    text += U"], reaches: [";
+    for (size_t i = 0; i < result.reaches.size(); ++i)
+    {
+      text += (i == 0 ? U"" : U", ") + result.reaches[i].first + U"(" + result.reaches[i].second + U")";
+    }
+    return text + U"]";
+  }
+
+  String ToText(const Array<String>& words)
+  {
+    String text;
+    for (size_t i = 0; i < words.size(); ++i)
+    {
+      text += (i == 0 ? U"" : U" ") + words[i];
+    }
+    return text;
+  }
+
+  /// <summary>
+  /// 差分更新した索引を作る。前半の単語で作り、後から取り除く予定の単語と後半の単語を反映する。
+  /// </summary>
+  DictionaryIndex MakePatchedIndex(const Array<String>& dictionary)
+  {
+    const size_t half = dictionary.size() / 2;
+    DictionaryIndex patched(Array<String>(dictionary.begin(), dictionary.begin() + half));
+    const uint32 decoy = patched.AddWord(U"だみーのたんご");
+    patched.AddWords(std::span<const String>(dictionary.data() + half, dictionary.size() - half));
+    patched.RemoveWord(decoy);
+    return patched;
+  }
+
+  /// <summary>
+  /// 1つの辞書から作った、基準実装と比べる方式の一式。方式は索引を参照するので、作った後は動かさない。
+  /// </summary>
+  class EngineSet
+  {
+  public:
+    /// <param name="mappedPath">MappedDictionary を書き出すファイル。空なら MappedDictionary の方式は作らない。</param>
+    EngineSet(const Array<String>& dictionary, const FilePath& mappedPath)
+      : index_(dictionary)
+      , patched_(MakePatchedIndex(dictionary))
+      , packed_(dictionary)
+      , alphabet_(dictionary)
+    {
+      if (!mappedPath.isEmpty() && MappedDictionary::Write(mappedPath, index_) && mapped_.Open(mappedPath))
+      {
+        mapped_index_ = MappedDictionary::OpenIndex(mappedPath);
+      }
+
+      AddEngines();
+    }
+
+    EngineSet(const EngineSet&) = delete;
+    EngineSet& operator=(const EngineSet&) = delete;
+
+    const Array<std::pair<String, Engine>>& GetEngines() const { return engines_; }
+
+    const Engine* Find(const String& name) const
+    {
+      for (const auto& [engineName, engine] : engines_)
+      {
+        if (engineName == name)
+        {
+          return &engine;
+        }
+      }
+      return nullptr;
+    }
+
+  private:
+    void AddEngines()
+    {
+      const std::pair<const char32*, BlockManager::MatchBackend> backends[] = {
+        { U"BlockManager kScalar", BlockManager::MatchBackend::kScalar },
+        { U"BlockManager kSimd", BlockManager::MatchBackend::kSimd },
+        { U"BlockManager kBitset", BlockManager::MatchBackend::kBitset },
+        { U"BlockManager kAnagram", BlockManager::MatchBackend::kAnagram },
+      };
+
+      for (const auto& [name, backend] : backends)
+      {
+        AddBlockManager(name, index_, backend);
+
+        // 差分更新した索引（kBitset / kAnagram は内部で走査型に切り替わる）
+        AddBlockManager(String{ name } + U" (patched)", patched_, backend);
+      }
+
+      engines_.emplace_back(U"BlockManager kSimd (parallel shards)", [this](const Array<String>& blocks)
+      {
+        BlockManager manager;
+        manager.SetMatchBackend(BlockManager::MatchBackend::kSimd);
+        manager.SetParallelScanOptions({ 0, 32 });
+        return EngineResult{ manager.GetHitWords(blocks, index_), manager.GetReachWords(blocks, index_) };
+      });
+
+      engines_.emplace_back(U"BlockManager QueryMatches", [this](const Array<String>& blocks)
+      {
+        BlockManager manager;
+        WordMatchBuffers buffers;
+        manager.QueryMatches(blocks, index_, buffers, false);
+        return FromIds(index_, DictionaryIndex::CountBlocks(blocks), buffers.hit_ids, buffers.reach_ids);
+      });
+
+      engines_.emplace_back(U"BlockManager (packed)", [this](const Array<String>& blocks)
+      {
+        const BlockManager manager;
+        return EngineResult{ manager.GetHitWords(blocks, packed_), manager.GetReachWords(blocks, packed_) };
+      });
+
+      // 実行中の CPU で使える命令セットごとのカーネル
+      const std::pair<const char32*, WordMatchKernel::InstructionSet> instructionSets[] = {
+        { U"WordMatchKernel kScalar", WordMatchKernel::InstructionSet::kScalar },
+        { U"WordMatchKernel kSse2", WordMatchKernel::InstructionSet::kSse2 },
+        { U"WordMatchKernel kAvx2", WordMatchKernel::InstructionSet::kAvx2 },
+      };
+      for (const auto& [name, instructionSet] : instructionSets)
+      {
+        if (instructionSet > WordMatchKernel::GetInstructionSet())
+        {
+          continue;
+        }
+
+        engines_.emplace_back(name, [this, instructionSet = instructionSet](const Array<String>& blocks)
+        {
+          const KanaCounts held = DictionaryIndex::CountBlocks(blocks);
+          Array<uint32> hits, reaches;
+          WordMatchKernel::CollectMatches(instructionSet, index_, held, 0, index_.GetWordCount(), &hits, &reaches);
+          return FromIds(index_, held, hits, reaches);
+        });
+      }
+
+      AddIncrementalMatcher(U"IncrementalWordMatcher", index_);
+      AddIncrementalMatcher(U"IncrementalWordMatcher (patched)", patched_);
+
+      engines_.emplace_back(U"PackedDictionary", [this](const Array<String>& blocks)
+      {
+        const KanaCounts held = DictionaryIndex::CountBlocks(blocks);
+        Array<uint32> hits, reaches;
+        packed_.CollectMatches(held, &hits, &reaches);
+
+        EngineResult result;
+        for (const uint32 id : hits)
+        {
+          result.hits << packed_.GetWord(id);
+        }
+        for (const uint32 id : reaches)
+        {
+          result.reaches.emplace_back(packed_.GetWord(id), packed_.GetMissingCharacter(id, held));
+        }
+        return result;
+      });
+
+      engines_.emplace_back(U"HiraganaWordEngine", [this](const Array<String>& blocks)
+      {
+        return EngineResult{ alphabet_.GetHitWords(blocks), alphabet_.GetReachWords(blocks) };
+      });
+
+      if (mapped_.IsOpen())
+      {
+        engines_.emplace_back(U"MappedDictionary", [this](const Array<String>& blocks)
+        {
+          const KanaCounts held = DictionaryIndex::CountBlocks(blocks);
+          Array<uint32> hits, reaches;
+          mapped_.CollectMatches(held, &hits, &reaches);
+
+          EngineResult result;
+          for (const uint32 id : hits)
+          {
+            result.hits << String{ mapped_.GetWord(id) };
+          }
+          for (const uint32 id : reaches)
+          {
+            result.reaches.emplace_back(String{ mapped_.GetWord(id) }, mapped_.GetMissingCharacter(id, held));
+          }
+          return result;
+        });
+      }
+
+      if (mapped_index_)
+      {
+        AddBlockManager(U"MappedDictionary::OpenIndex", *mapped_index_, BlockManager::MatchBackend::kSimd);
+      }
+    }
+
+    void AddBlockManager(const String& name, const DictionaryIndex& index, const BlockManager::MatchBackend backend)
+    {
+      engines_.emplace_back(name, [&index, backend](const Array<String>& blocks)
+      {
+        BlockManager manager;
+        manager.SetMatchBackend(backend);
+        return EngineResult{ manager.GetHitWords(blocks, index), manager.GetReachWords(blocks, index) };
+      });
+    }
+
+    void AddIncrementalMatcher(const String& name, const DictionaryIndex& index)
+    {
+      engines_.emplace_back(name, [&index](const Array<String>& blocks)
+      {
+        IncrementalWordMatcher matcher(index);
+        for (const auto& block : blocks)
+        {
+          matcher.Push(block);
+        }
+        return EngineResult{ matcher.GetHitWords(), matcher.GetReachWords() };
+      });
+    }
+
+    DictionaryIndex index_;
+    DictionaryIndex patched_;
+    PackedDictionary packed_;
+    HiraganaWordEngine alphabet_;
+    MappedDictionary mapped_;
+    Optional<DictionaryIndex> mapped_index_;
+    Array<std::pair<String, Engine>> engines_;
+  };
+
+  /// <summary>
+  /// fails が true を返す範囲で、items から要素を取り除いていく。取り除く単位は半分から始めて1つずつまで小さくする。
+  /// </summary>
+  Array<String> ShrinkList(Array<String> items, const std::function<bool(const Array<String>&)>& fails)
+  {
+    for (size_t chunk = std::max<size_t>(items.size() / 2, 1); ; chunk /= 2)
+    {
+      for (size_t begin = 0; begin < items.size();)
+      {
+        Array<String> candidate = items;
+        candidate.erase(candidate.begin() + begin, candidate.begin() + std::min(begin + chunk, candidate.size()));
+        if (fails(candidate))
+        {
+          items = std::move(candidate);
+        }
+        else
+        {
+          begin += chunk;
+        }
+      }
+
+      if (chunk == 1)
+      {
+        return items;
+      }
+    }
+  }
+
+  /// <summary>
+  /// 食い違った入力を、同じ方式で食い違いが残る範囲で縮める（先に手持ち、次に辞書）。
+  /// </summary>
+  DifferentialWordEngine::Mismatch Shrink(const String& engineName, const size_t caseIndex, const size_t query, Array<String> dictionary, Array<String> blocks)
+  {
+    // 縮める間は方式の一式を作り直すので、MappedDictionary は探索中とは別のファイルに書き出す。
+    const FilePath mappedPath = engineName.starts_with(U"MappedDictionary") ? FileSystem::TemporaryDirectoryPath() + U"ich_differential_shrink.ichd" : FilePath{};
+
+    const auto fails = [&](const EngineSet& engines, const Array<String>& words, const Array<String>& hand)
+    {
+      const Engine* engine = engines.Find(engineName);
+      return (engine != nullptr) && !((*engine)(hand) == GetReferenceResult(words, hand));
+    };
+
+    {
+      const EngineSet engines(dictionary, mappedPath);
+      blocks = ShrinkList(std::move(blocks), [&](const Array<String>& hand) { return fails(engines, dictionary, hand); });
+    }
+    dictionary = ShrinkList(std::move(dictionary), [&](const Array<String>& words) { return fails(EngineSet{ words, mappedPath }, words, blocks); });
+
+    DifferentialWordEngine::Mismatch mismatch{ engineName, caseIndex, query, dictionary, blocks };
+    {
+      const EngineSet engines(dictionary, mappedPath);
+      mismatch.expected = ToText(GetReferenceResult(dictionary, blocks));
+      mismatch.actual = (engines.Find(engineName) != nullptr) ? ToText((*engines.Find(engineName))(blocks)) : String{ U"(engine unavailable)" };
+    }
+
+    if (!mappedPath.isEmpty())
+    {
+      FileSystem::Remove(mappedPath);
+    }
+    return mismatch;
+  }
+} // namespace
+
+namespace DifferentialWordEngine
+{
+  Report Run(const uint32 seed, const size_t caseCount)
+  {
+    std::mt19937 random{ seed };
+    const Array<String>& keywords = GetKeywords();
+    const FilePath mappedPath = FileSystem::TemporaryDirectoryPath() + U"ich_differential_test.ichd";
+    Report report;
+
+    for (size_t caseIndex = 0; caseIndex < caseCount && !report.mismatch; ++caseIndex)
+    {
+      // 辞書の部分集合（辞書順は保つ）に、正規化の境界を含む単語を加える。
+      const double keepRate = std::uniform_real_distribution<double>{ 0.05, 0.5 }(random);
+      Array<String> dictionary;
+      for (const auto& word : keywords)
+      {
+        if (std::bernoulli_distribution{ keepRate }(random))
+        {
+          dictionary << word;
+        }
+      }
+      for (const auto& word : GetEdgeWords())
+      {
+        if (std::bernoulli_distribution{ 0.5 }(random) && !dictionary.includes(word))
+        {
+          dictionary << word;
+        }
+      }
+
+      // ファイルを介する方式は書き込みに時間がかかるので、一部の辞書だけで確かめる。
+      const EngineSet engines(dictionary, (caseIndex % 25 == 0) ? mappedPath : FilePath{});
+
+      for (size_t query = 0; query < 4 && !report.mismatch; ++query)
+      {
+        // 辞書の単語から取った文字を中心に、境界の文字を混ぜて 0 ～ 9 個の手持ちを作る。
+        Array<String> blocks;
+        const size_t blockCount = std::uniform_int_distribution<size_t>{ 0, 9 }(random);
+        const String& source = dictionary.isEmpty() ? String{ U"あ" } : dictionary[std::uniform_int_distribution<size_t>{ 0, dictionary.size() - 1 }(random)];
+
+        for (size_t i = 0; i < blockCount; ++i)
+        {
+          if (std::bernoulli_distribution{ 0.7 }(random))
+          {
+            blocks << String(1, source[std::uniform_int_distribution<size_t>{ 0, source.size() - 1 }(random)]);
+          }
+          else
+          {
+            blocks << String(1, kEdgeCharacters[std::uniform_int_distribution<size_t>{ 0, std::size(kEdgeCharacters) - 2 }(random)]);
+          }
+        }
+
+        const EngineResult expected = GetReferenceResult(dictionary, blocks);
+        ++report.query_count;
+        if (!expected.hits.isEmpty() || !expected.reaches.isEmpty())
+        {
+          ++report.non_empty_query_count;
+        }
+
+        for (const auto& [name, engine] : engines.GetEngines())
+        {
+          if (!(engine(blocks) == expected))
+          {
+            report.mismatch = Shrink(name, caseIndex, query, dictionary, blocks);
+            break;
+          }
+        }
+      }
+    }
+
+    FileSystem::Remove(mappedPath);
+    return report;
+  }
+
+  String Describe(const Mismatch& mismatch)
+  {
+    return Format(mismatch.engine, U" differs from reference (case ", mismatch.case_index, U", query ", mismatch.query, U")\n",
+      U"  dictionary: ", ToText(mismatch.dictionary), U"\n",
+      U"  blocks: ", ToText(mismatch.blocks), U"\n",
+      U"  expected: ", mismatch.expected, U"\n",
+      U"  actual: ", mismatch.actual);
+  }
+}
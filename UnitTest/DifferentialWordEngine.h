@@ -0,0 +1,67 @@
+﻿#pragma once
+
+#include <Siv3D.hpp>
+
+/// <summary>
+/// 単語判定の各方式（BlockManager の各バックエンド・差分更新した索引・IncrementalWordMatcher・PackedDictionary・
+/// MappedDictionary・AlphabetWordEngine など）を、基準実装（BlockManager の文字列辞書版）と乱数の入力で突き合わせる。
+/// テストフレームワークに依存しないので、CppUnitTest のテストからも Linux のコマンドライン（DifferentialMain.cpp）からも同じものを実行する。
+/// </summary>
+namespace DifferentialWordEngine
+{
+  /// <summary>
+  /// 既定の乱数の種
+  /// </summary>
+  inline constexpr uint32 kDefaultSeed = 20240601;
+
+  /// <summary>
+  /// 既定の辞書の数（辞書ごとに4通りの手持ちを試す）
+  /// </summary>
+  inline constexpr size_t kDefaultCaseCount = 300;
+
+  /// <summary>
+  /// 基準実装と食い違った入力。辞書と手持ちは、食い違いが残る範囲でできるだけ小さく縮めたもの。
+  /// </summary>
+  struct Mismatch
+  {
+    String engine;
+    size_t case_index = 0;
+    size_t query = 0;
+    Array<String> dictionary;
+    Array<String> blocks;
+
+    /// <summary>
+    /// 縮めた入力での基準実装と方式それぞれの結果
+    /// </summary>
+    String expected;
+    String actual;
+  };
+
+  /// <summary>
+  /// 実行結果
+  /// </summary>
+  struct Report
+  {
+    size_t query_count = 0;
+
+    /// <summary>
+    /// 基準実装のヒットかリーチが空でなかった問い合わせの数（乱数の入力が空振りばかりでないことの確認用）
+    /// </summary>
+    size_t non_empty_query_count = 0;
+
+    /// <summary>
+    /// 最初に見つかった食い違い（見つかった時点で打ち切る）
+    /// </summary>
+    Optional<Mismatch> mismatch;
+  };
+
+  /// <summary>
+  /// 辞書の部分集合と、濁音・小書き・長音記号を混ぜた手持ちを乱数で作り、すべての方式を基準実装と比べる。
+  /// </summary>
+  Report Run(uint32 seed = kDefaultSeed, size_t caseCount = kDefaultCaseCount);
+
+  /// <summary>
+  /// 食い違いを人が読める形にする。
+  /// </summary>
+  String Describe(const Mismatch& mismatch);
+}
@@ -1,10 +1,33 @@
 ﻿#include "pch.h"
 #include "CppUnitTest.h"
 #include "../Ich/System/System/BlockManager.h"
+#include "../Ich/System/System/DictionaryIndex.h"
+#include "../Ich/System/System/WordMatchKernel.h"
+#include "../Ich/System/System/IncrementalWordMatcher.h"
+#include "../Ich/System/System/WordStateSnapshot.h"
+#include "../Ich/System/System/AlphabetWordEngine.h"
+#include "../Ich/System/System/PackedDictionary.h"
+#include "../Ich/System/System/MappedDictionary.h"
+#include "../Ich/System/System/DictionaryCompiler.h"
+#include "../Ich/System/System/DictionaryLoader.h"
+#include "../Ich/System/System/DictionaryHotReloader.h"
+#include "../Ich/System/System/OrderedWordAutomaton.h"
+#include "../Ich/System/System/WordPackingSolver.h"
+#include "../Ich/System/System/ShiritoriGraph.h"
+#include "../Ich/System/System/ShiritoriChainSearcher.h"
+#include "../Ich/System/System/PathWordFinder.h"
+#include "../Ich/System/System/NextBlockAdvisor.h"
+#include "../Ich/System/System/KanaAliasTable.h"
 #include "../Ich/Keywords.hpp"
+#include "./DifferentialWordEngine.h"
 #include <algorithm>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
 #include <utility>
 #include <stdexcept>
+#include <thread>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -12,20 +35,1526 @@ using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 int Add(int left, int right);
 namespace UnitTest
 {
+  /// <summary>
+  /// 盤面の文字列（行ごとに続けたもの）をマスごとの文字IDに直す。全角空白は壊したマス（kInvalidKanaId）にする。
+  /// </summary>
+  static Array<KanaId> MakeCells(const String& text)
+  {
+    Array<KanaId> cells;
+    for (const char32 ch : text)
+    {
+      cells << ((ch == U'　') ? kInvalidKanaId : ToKanaId(NormalizeKanaCode(ch)));
+    }
+    return cells;
+  }
+
   TEST_CLASS(SampleTests)
   {
   public:
 
-    TEST_METHOD(Add_ReturnsSumForPositiveValues)
+    TEST_METHOD(Add_ReturnsSumForPositiveValues)
+    {
+      Assert::AreEqual(5, Add(2, 3));
+      Assert::AreEqual(0, Add(0, 0));
+    }
+
+    TEST_METHOD(Add_HandlesNegativeValues)
+    {
+      Assert::AreEqual(-1, Add(2, -3));
+      Assert::AreEqual(-5, Add(-2, -3));
+    }
+  };
+
+  TEST_CLASS(KanaTableTests)
+  {
+  public:
+
+    TEST_METHOD(NormalizeKanaCode_UsesGameRules)
+    {
+      static_assert(NormalizeKanaCode(U'が') == U'か');
+      static_assert(NormalizeKanaCode(U'ぷ') == U'ふ');
+      static_assert(NormalizeKanaCode(U'ゃ') == U'や');
+      static_assert(NormalizeKanaCode(U'ー') == kSkipKanaCode);
+
+      Assert::IsTrue(NormalizeKanaCode(U'あ') == U'あ');
+      Assert::IsTrue(NormalizeKanaCode(U'A') == U'A');
+      Assert::IsFalse(NormalizeKanaChar(U'－').has_value());
+    }
+
+    TEST_METHOD(NormalizeKana_RemovesLongVowelMarks)
+    {
+      const String hiragana = U"らーめん";
+      Array<char32> output(hiragana.size());
+
+      const size_t length = NormalizeKana(std::span<const char32>(hiragana.data(), hiragana.size()), output);
+
+      Assert::AreEqual(size_t{ 3 }, length);
+      Assert::IsTrue(String(output.data(), length) == U"らめん");
+    }
+  };
+
+  TEST_CLASS(AlphabetWordEngineTests)
+  {
+  public:
+
+    TEST_METHOD(HiraganaEngine_MatchesBlockManager)
+    {
+      BlockManager manager;
+      const HiraganaWordEngine engine(GetKeywords());
+      const Array<String> blocks = { U"か", U"わ", U"る", U"め", U"を", U"し", U"た" };
+
+      Assert::IsTrue(manager.GetHitWords(blocks, GetKeywords()) == engine.GetHitWords(blocks));
+      Assert::IsTrue(manager.GetReachWords(blocks, GetKeywords()) == engine.GetReachWords(blocks));
+    }
+
+    TEST_METHOD(KatakanaEngine_NormalizesLikeHiragana)
+    {
+      static_assert(KatakanaAlphabet::ToSymbol(U'ガ') == HiraganaAlphabet::ToSymbol(U'か'));
+      static_assert(KatakanaAlphabet::ToSymbol(U'ー') == AlphabetPolicy::kSkipSymbol);
+
+      const KatakanaWordEngine engine(Array<String>{ U"ラーメン", U"パン", U"ゲーム" });
+      const Array<String> blocks = { U"ハ", U"ン", U"メ", U"ラ" };
+
+      Assert::IsTrue(engine.GetHitWords(blocks) == Array<String>{ U"ラーメン", U"パン" });
+      Assert::IsTrue(engine.GetReachWords({ U"ケ" }) == Array<std::pair<String, String>>{ { U"ゲーム", U"ム" } });
+    }
+
+    TEST_METHOD(LatinEngine_IgnoresCaseAndHyphens)
+    {
+      const LatinWordEngine engine(Array<String>{ U"ICE-CREAM", U"rice", U"Cat" });
+      const Array<String> blocks = { U"c", U"E", U"i", U"R" };
+
+      Assert::IsTrue(engine.GetHitWords(blocks) == Array<String>{ U"rice" });
+      Assert::IsTrue(engine.GetReachWords({ U"C", U"A" }) == Array<std::pair<String, String>>{ { U"Cat", U"t" } });
+      Assert::ExpectException<std::invalid_argument>([]() { LatinWordEngine{ Array<String>{ U"ねこ" } }; });
+    }
+  };
+
+  TEST_CLASS(DictionaryIndexTests)
+  {
+  public:
+
+    TEST_METHOD(Constructor_CountsNormalizedKana)
+    {
+      const DictionaryIndex index(Array<String>{ U"すこーぷ", U"がっこう" });
+
+      Assert::AreEqual(static_cast<size_t>(2), index.GetWordCount());
+      Assert::AreEqual(static_cast<uint8>(3), index.GetLength(0));
+      Assert::AreEqual(static_cast<uint8>(4), index.GetLength(1));
+      Assert::AreEqual(static_cast<uint8>(1), index.GetCounts(0)[ToKanaId(U'ふ')]);
+      Assert::AreEqual(static_cast<uint8>(1), index.GetCounts(1)[ToKanaId(U'か')]);
+      Assert::AreEqual(static_cast<uint8>(1), index.GetCounts(1)[ToKanaId(U'つ')]);
+    }
+
+    TEST_METHOD(Constructor_PrecomputedKeywordsMatchStringDictionary)
+    {
+      const DictionaryIndex fromStrings(GetKeywords());
+      const DictionaryIndex precomputed(GetKeywordWords(), GetKeywordKanaIds(), GetKeywordOffsets());
+
+      Assert::AreEqual(fromStrings.GetWordCount(), precomputed.GetWordCount());
+      for (size_t i = 0; i < fromStrings.GetWordCount(); ++i)
+      {
+        Assert::IsTrue(fromStrings.GetWord(i) == precomputed.GetWord(i));
+        Assert::IsTrue(fromStrings.GetCounts(i) == precomputed.GetCounts(i));
+        Assert::AreEqual(fromStrings.GetLength(i), precomputed.GetLength(i));
+      }
+    }
+
+    TEST_METHOD(Constructor_BorrowsCompileTimeTables)
+    {
+      BlockManager manager;
+      const DictionaryIndex fromStrings(GetKeywords());
+      DictionaryIndex borrowed(GetKeywordTables());
+
+      Assert::IsTrue(borrowed.IsBorrowed());
+      Assert::AreEqual(fromStrings.GetWordCount(), borrowed.GetWordCount());
+      Assert::AreEqual(fromStrings.GetColumnStride(), borrowed.GetColumnStride());
+      Assert::IsTrue(std::equal(fromStrings.GetColumn(0), fromStrings.GetColumn(0) + kKanaAlphabetSize * fromStrings.GetColumnStride(), borrowed.GetColumn(0)));
+      for (size_t i = 0; i < fromStrings.GetWordCount(); ++i)
+      {
+        Assert::IsTrue(fromStrings.GetWord(i) == borrowed.GetWord(i));
+        Assert::IsTrue(fromStrings.GetCounts(i) == borrowed.GetCounts(i));
+        Assert::AreEqual(fromStrings.GetLength(i), borrowed.GetLength(i));
+      }
+      for (const size_t length : { 0, 3, 5, 1000 })
+      {
+        const auto expected = fromStrings.GetWordsUpToLength(length);
+        const auto actual = borrowed.GetWordsUpToLength(length);
+        Assert::IsTrue(std::equal(expected.begin(), expected.end(), actual.begin(), actual.end()));
+      }
+
+      // 書き換えると表を写してから変更し、借りた領域はそのまま残る。
+      const Array<String> blocks = { U"ろ", U"ん", U"り", U"ぱ" };
+      Assert::IsTrue(borrowed.RemoveWord(0));
+      Assert::AreEqual(static_cast<uint32>(fromStrings.GetWordCount()), borrowed.AddWord(U"りんぱ"));
+      Assert::IsFalse(borrowed.IsBorrowed());
+      Assert::IsTrue(borrowed.GetWord(1) == fromStrings.GetWord(1));
+      Assert::IsTrue(manager.GetHitWords(blocks, borrowed).includes(U"りんぱ"));
+      Assert::IsTrue(DictionaryIndex(GetKeywordTables()).GetCounts(0) == fromStrings.GetCounts(0));
+    }
+
+    TEST_METHOD(Constructor_RejectsNonHiraganaWords)
+    {
+      Assert::ExpectException<std::invalid_argument>([]()
+      {
+        DictionaryIndex index(Array<String>{ U"かな", U"カナ" });
+      });
+    }
+
+    TEST_METHOD(AddAndRemoveWord_MatchesRebuiltDictionary)
+    {
+      BlockManager manager;
+      const Array<String>& keywords = GetKeywords();
+      const size_t half = keywords.size() / 2;
+
+      // 前半で索引を作り、3語に1語を取り除いてから後半を1語ずつ追加する（列の拡張も起きる）。
+      DictionaryIndex index(Array<String>(keywords.begin(), keywords.begin() + half));
+      Array<String> active;
+      for (size_t i = 0; i < half; ++i)
+      {
+        if (i % 3 == 0)
+        {
+          Assert::IsTrue(index.RemoveWord(static_cast<uint32>(i)));
+        }
+        else
+        {
+          active << keywords[i];
+        }
+      }
+      Assert::IsFalse(index.RemoveWord(0));
+      for (size_t i = half; i < keywords.size(); ++i)
+      {
+        Assert::AreEqual(static_cast<uint32>(i), index.AddWord(keywords[i]));
+        active << keywords[i];
+      }
+      Assert::IsTrue(index.IsPatched());
+      Assert::AreEqual(active.size(), index.GetWordsUpToLength(1000).size());
+
+      const Array<String> blocks = { U"し", U"し", U"ん", U"ん", U"ぶ", U"つ", U"い" };
+      for (const auto backend : { BlockManager::MatchBackend::kScalar, BlockManager::MatchBackend::kSimd, BlockManager::MatchBackend::kBitset, BlockManager::MatchBackend::kAnagram })
+      {
+        manager.SetMatchBackend(backend);
+        Assert::IsTrue(manager.GetHitWords(blocks, active) == manager.GetHitWords(blocks, index));
+        Assert::IsTrue(manager.GetReachWords(blocks, active) == manager.GetReachWords(blocks, index));
+      }
+
+      const DictionaryIndex rebuilt(active);
+      const auto expected = manager.GetWordsWithinMissing(blocks, rebuilt, 2);
+      const auto actual = manager.GetWordsWithinMissing(blocks, index, 2);
+      Assert::AreEqual(expected.size(), actual.size());
+      for (size_t i = 0; i < expected.size(); ++i)
+      {
+        Assert::IsTrue(expected[i].word == actual[i].word);
+        Assert::IsTrue(expected[i].missing == actual[i].missing);
+      }
+    }
+
+    TEST_METHOD(AddAndRemoveWords_MatchesOneByOne)
+    {
+      const Array<String>& keywords = GetKeywords();
+      const size_t half = keywords.size() / 2;
+      const Array<String> head(keywords.begin(), keywords.begin() + half);
+      const Array<String> tail(keywords.begin() + half, keywords.end());
+
+      Array<uint32> removed;
+      for (uint32 i = 0; i < half; i += 3)
+      {
+        removed << i;
+      }
+
+      DictionaryIndex single(head);
+      IncrementalWordMatcher singleMatcher(single);
+      DictionaryIndex batched(head);
+      IncrementalWordMatcher batchedMatcher(batched);
+      const Array<String> blocks = { U"し", U"ん", U"ぶ", U"つ", U"い", U"か", U"く" };
+      for (const String& block : blocks)
+      {
+        singleMatcher.Push(block);
+        batchedMatcher.Push(block);
+      }
+
+      for (const uint32 id : removed)
+      {
+        singleMatcher.RemoveWord(id);
+        single.RemoveWord(id);
+      }
+      for (const String& word : tail)
+      {
+        singleMatcher.AddWord(single.AddWord(word));
+      }
+
+      batchedMatcher.RemoveWords(removed);
+      Assert::AreEqual(removed.size(), batched.RemoveWords(removed));
+      Assert::AreEqual(size_t{ 0 }, batched.RemoveWords(removed));
+      batchedMatcher.AddWords(batched.AddWords(tail));
+
+      for (const size_t maxLength : { size_t{ 0 }, size_t{ 2 }, size_t{ 4 }, size_t{ 1000 } })
+      {
+        const auto expected = single.GetWordsUpToLength(maxLength);
+        const auto actual = batched.GetWordsUpToLength(maxLength);
+        Assert::IsTrue(std::equal(expected.begin(), expected.end(), actual.begin(), actual.end()));
+      }
+      Assert::IsTrue(singleMatcher.GetHitWords() == batchedMatcher.GetHitWords());
+      Assert::IsTrue(singleMatcher.GetReachWords() == batchedMatcher.GetReachWords());
+
+      // ひらがな以外を含む単語があれば、どの単語も追加しない。
+      const size_t wordCount = batched.GetWordCount();
+      Assert::ExpectException<std::invalid_argument>([&]() { batched.AddWords(Array<String>{ U"ねこ", U"cat" }); });
+      Assert::AreEqual(wordCount, batched.GetWordCount());
+    }
+  };
+
+  TEST_CLASS(PackedDictionaryTests)
+  {
+  public:
+
+    TEST_METHOD(GetWord_RestoresOriginalForm)
+    {
+      const PackedDictionary packed(GetKeywords());
+
+      size_t utf32Size = 0;
+      Assert::AreEqual(GetKeywords().size(), packed.GetWordCount());
+      for (size_t i = 0; i < GetKeywords().size(); ++i)
+      {
+        Assert::IsTrue(GetKeywords()[i] == packed.GetWord(i));
+        utf32Size += GetKeywords()[i].size() * sizeof(char32);
+      }
+
+      // 文字本体だけと比べても、詰めた表現のほうが小さいこと。
+      Assert::IsTrue(packed.GetByteSize() < utf32Size);
+
+      const PackedDictionary variants(Array<String>{ U"らーめん", U"ぎゅうにゅう", U"ーあー" });
+      Assert::IsTrue(variants.GetWord(0) == U"らーめん");
+      Assert::IsTrue(variants.GetWord(1) == U"ぎゅうにゅう");
+      Assert::IsTrue(variants.GetWord(2) == U"ーあー");
+      Assert::AreEqual(size_t{ 3 }, variants.GetLength(0));
+    }
+
+    TEST_METHOD(CollectMatches_MatchesBlockManager)
+    {
+      BlockManager manager;
+      const PackedDictionary packed(GetKeywords());
+      const Array<String> blocks = { U"し", U"し", U"ん", U"ん", U"ぶ", U"つ", U"い" };
+      const KanaCounts held = DictionaryIndex::CountBlocks(blocks);
+
+      Array<uint32> hitIds;
+      Array<uint32> reachIds;
+      packed.CollectMatches(held, &hitIds, &reachIds);
+
+      Array<String> hits;
+      for (const uint32 id : hitIds)
+      {
+        hits << packed.GetWord(id);
+      }
+      Assert::IsTrue(manager.GetHitWords(blocks, GetKeywords()) == hits);
+
+      Array<std::pair<String, String>> reaches;
+      for (const uint32 id : reachIds)
+      {
+        reaches.emplace_back(packed.GetWord(id), packed.GetMissingCharacter(id, held));
+      }
+      Assert::IsTrue(manager.GetReachWords(blocks, GetKeywords()) == reaches);
+    }
+
+    TEST_METHOD(BlockManager_MatchesOnPackedForm)
+    {
+      BlockManager manager;
+      const PackedDictionary packed(GetKeywords());
+      const Array<String> blocks = { U"ろ", U"ん", U"り", U"ぱ", U"せ", U"て" };
+
+      Assert::IsTrue(manager.GetHitWords(blocks, GetKeywords()) == manager.GetHitWords(blocks, packed));
+      Assert::IsTrue(manager.GetReachWords(blocks, GetKeywords()) == manager.GetReachWords(blocks, packed));
+      Assert::IsFalse(manager.GetReachWords(blocks, packed).isEmpty());
+    }
+
+    TEST_METHOD(GetMissingCharacter_SkipsLongVowelMarks)
+    {
+      const PackedDictionary packed(Array<String>{ U"ばーば" });
+
+      Assert::IsTrue(packed.GetMissingCharacter(0, DictionaryIndex::CountBlocks({ U"は" })) == U"ば");
+    }
+  };
+
+  TEST_CLASS(MappedDictionaryTests)
+  {
+  public:
+
+    TEST_METHOD(Open_MatchesDictionaryIndex)
+    {
+      const DictionaryIndex index(GetKeywords());
+      const FilePath path = FileSystem::TemporaryDirectoryPath() + U"ich_mapped_dictionary_test.ichd";
+      Assert::IsTrue(MappedDictionary::Write(path, index));
+
+      {
+        MappedDictionary mapped;
+        Assert::IsTrue(mapped.Open(path));
+        Assert::AreEqual(index.GetWordCount(), mapped.GetWordCount());
+
+        for (size_t i = 0; i < index.GetWordCount(); ++i)
+        {
+          Assert::IsTrue(index.GetWord(i) == mapped.GetWord(i));
+          Assert::IsTrue(index.GetCounts(i) == mapped.GetCounts(i));
+          Assert::AreEqual(index.GetLength(i), mapped.GetLength(i));
+        }
+
+        for (const size_t maxLength : { size_t{ 0 }, size_t{ 3 }, size_t{ 7 }, size_t{ 1000 } })
+        {
+          const auto expected = index.GetWordsUpToLength(maxLength);
+          const auto actual = mapped.GetWordsUpToLength(maxLength);
+          Assert::IsTrue(std::equal(expected.begin(), expected.end(), actual.begin(), actual.end()));
+        }
+
+        const KanaCounts held = DictionaryIndex::CountBlocks({ U"し", U"し", U"ん", U"ん", U"ぶ", U"つ", U"い" });
+        Array<uint32> expectedHits, expectedReaches, hits, reaches;
+        WordMatchKernel::CollectMatches(index, held, 0, index.GetWordCount(), &expectedHits, &expectedReaches);
+        mapped.CollectMatches(held, &hits, &reaches);
+        Assert::IsTrue(expectedHits == hits);
+        Assert::IsTrue(expectedReaches == reaches);
+
+        for (const uint32 id : reaches)
+        {
+          Assert::IsTrue(index.GetMissingCharacter(id, index.FindMissingKana(id, held), held) == mapped.GetMissingCharacter(id, held));
+        }
+      }
+
+      FileSystem::Remove(path);
+    }
+
+    TEST_METHOD(OpenIndex_MatchesDictionaryIndex)
+    {
+      DictionaryIndex index(GetKeywords());
+      const uint32 removed = index.GetWordsUpToLength(3).front();
+      index.RemoveWord(removed);
+
+      const FilePath path = FileSystem::TemporaryDirectoryPath() + U"ich_mapped_dictionary_index_test.ichd";
+      Assert::IsTrue(MappedDictionary::Write(path, index));
+
+      {
+        const Optional<DictionaryIndex> mapped = MappedDictionary::OpenIndex(path);
+        Assert::IsTrue(mapped.has_value());
+        Assert::IsTrue(mapped->IsBorrowed());
+        Assert::IsTrue(mapped->IsRemoved(removed));
+        Assert::IsTrue(mapped->IsPatched());
+        Assert::AreEqual(index.GetWordCount(), mapped->GetWordCount());
+
+        for (size_t i = 0; i < index.GetWordCount(); ++i)
+        {
+          Assert::IsTrue(index.GetWord(i) == mapped->GetWord(i));
+          Assert::AreEqual(index.GetLength(i), mapped->GetLength(i));
+        }
+
+        for (const size_t maxLength : { size_t{ 0 }, size_t{ 3 }, size_t{ 7 }, size_t{ 1000 } })
+        {
+          const auto expected = index.GetWordsUpToLength(maxLength);
+          const auto actual = mapped->GetWordsUpToLength(maxLength);
+          Assert::IsTrue(std::equal(expected.begin(), expected.end(), actual.begin(), actual.end()));
+        }
+
+        const Array<String> blocks = { U"し", U"し", U"ん", U"ん", U"ぶ", U"つ", U"い" };
+        BlockManager manager;
+        Assert::IsTrue(manager.GetHitWords(blocks, index) == manager.GetHitWords(blocks, *mapped));
+        Assert::IsTrue(manager.GetReachWords(blocks, index) == manager.GetReachWords(blocks, *mapped));
+
+        // 書き換えると割り当てた列から索引側の表に移り、ファイルを閉じた後も使える。
+        DictionaryIndex patched = *mapped;
+        patched.AddWord(U"しんぶん");
+        Assert::IsFalse(patched.IsBorrowed());
+        Assert::IsTrue(manager.GetHitWords({ U"し", U"ん", U"ぶ", U"ん" }, patched).contains(U"しんぶん"));
+      }
+
+      FileSystem::Remove(path);
+    }
+
+    TEST_METHOD(Open_RejectsCorruptTables)
+    {
+      const DictionaryIndex index(GetKeywords());
+      const FilePath path = FileSystem::TemporaryDirectoryPath() + U"ich_mapped_dictionary_corrupt.ichd";
+      Assert::IsTrue(MappedDictionary::Write(path, index));
+
+      Array<uint8> original;
+      {
+        BinaryReader reader{ path };
+        original.resize(static_cast<size_t>(reader.size()));
+        reader.read(original.data(), static_cast<int64>(original.size()));
+      }
+
+      // 先頭の情報のうち、単語の開始位置表（40 バイト目）と長さ順の並び（72 バイト目）の位置を読む。
+      const auto sectionAt = [&](const size_t headerOffset)
+        {
+          uint64 offset = 0;
+          std::memcpy(&offset, original.data() + headerOffset, sizeof(offset));
+          return static_cast<size_t>(offset);
+        };
+      const auto openCorrupted = [&](const size_t byteOffset, const uint32 value)
+        {
+          Array<uint8> corrupted = original;
+          std::memcpy(corrupted.data() + byteOffset, &value, sizeof(value));
+          {
+            BinaryWriter writer{ path };
+            writer.write(corrupted.data(), static_cast<int64>(corrupted.size()));
+          }
+
+          MappedDictionary mapped;
+          return mapped.Open(path);
+        };
+
+      Assert::IsTrue(openCorrupted(sectionAt(40), 0));
+      // 2 番目の単語の開始位置を 1 番目より前に戻す（単調でない）
+      Assert::IsFalse(openCorrupted(sectionAt(40) + sizeof(uint32) * 2, 0));
+      // 長さ順の並びに単語数以上の番号を入れる
+      Assert::IsFalse(openCorrupted(sectionAt(72), static_cast<uint32>(index.GetWordCount())));
+      // 長さ順の並びの先頭（最も短い単語）に最も長い単語を入れる
+      Assert::IsFalse(openCorrupted(sectionAt(72), index.GetWordsUpToLength(1000).back()));
+      Assert::IsFalse(MappedDictionary::OpenIndex(path).has_value());
+
+      FileSystem::Remove(path);
+    }
+
+    TEST_METHOD(Open_RejectsInvalidFile)
+    {
+      const FilePath path = FileSystem::TemporaryDirectoryPath() + U"ich_mapped_dictionary_invalid.ichd";
+      {
+        BinaryWriter writer{ path };
+        const Array<uint8> garbage(256, 0xAB);
+        writer.write(garbage.data(), static_cast<int64>(garbage.size()));
+      }
+
+      MappedDictionary mapped;
+      Assert::IsFalse(mapped.Open(path));
+      Assert::IsFalse(mapped.IsOpen());
+      Assert::AreEqual(size_t{ 0 }, mapped.GetWordCount());
+      Assert::IsFalse(mapped.Open(FileSystem::TemporaryDirectoryPath() + U"ich_mapped_dictionary_missing.ichd"));
+
+      FileSystem::Remove(path);
+    }
+
+    TEST_METHOD(Compile_ReadsWordListLikeHotReload)
+    {
+      const FilePath input = FileSystem::TemporaryDirectoryPath() + U"ich_dictionary_compiler_test.txt";
+      const FilePath output = FileSystem::TemporaryDirectoryPath() + U"ich_dictionary_compiler_test.ichd";
+      {
+        const std::string text = String{ U"# 単語一覧\r\nりんご\r\n\r\n  みかん \nabc\nりんご\nらーめん" }.toUTF8();
+        BinaryWriter writer{ input };
+        writer.write(text.data(), static_cast<int64>(text.size()));
+      }
+
+      // ひらがな以外の行は読み飛ばし、重複した単語は1つにまとめる（ファイル全体を失敗にはしない）。
+      const Optional<size_t> rejectedLineCount = DictionaryCompiler::Compile(input, output);
+      Assert::IsTrue(rejectedLineCount.has_value());
+      Assert::AreEqual(size_t{ 1 }, *rejectedLineCount);
+
+      MappedDictionary mapped;
+      Assert::IsTrue(mapped.Open(output));
+      Assert::AreEqual(size_t{ 3 }, mapped.GetWordCount());
+      Assert::IsTrue(mapped.GetWord(0) == U"りんご");
+      Assert::IsTrue(mapped.GetWord(1) == U"みかん");
+      Assert::IsTrue(mapped.GetWord(2) == U"らーめん");
+      mapped.Close();
+
+      FileSystem::Remove(input);
+      FileSystem::Remove(output);
+    }
+  };
+
+  TEST_CLASS(DictionaryLoaderTests)
+  {
+  public:
+
+    static std::span<const uint8> AsBytes(const std::string& text)
+    {
+      return { reinterpret_cast<const uint8*>(text.data()), text.size() };
+    }
+
+    TEST_METHOD(ParseWordList_NormalizesAndSkipsInvalidLines)
+    {
+      const std::string text = "\xEF\xBB\xBF" + String{ U"# 単語一覧\r\nらーめん\r\n\r\n　ぎゅうにゅう \nabc\nーー\nらーめん\nばば" }.toUTF8();
+      const DictionaryLoader::WordList wordList = DictionaryLoader::ParseWordList(AsBytes(text));
+
+      Assert::AreEqual(size_t{ 3 }, wordList.GetWordCount());
+      Assert::IsTrue(wordList.GetWord(0) == U"らーめん");
+      Assert::IsTrue(wordList.GetWord(1) == U"ぎゅうにゅう");
+      Assert::IsTrue(wordList.GetWord(2) == U"ばば");
+      Assert::AreEqual(size_t{ 2 }, wordList.rejected_line_count);
+
+      const DictionaryIndex loaded = DictionaryLoader::BuildIndex(wordList);
+      const DictionaryIndex expected(Array<String>{ U"らーめん", U"ぎゅうにゅう", U"ばば" });
+      for (size_t i = 0; i < expected.GetWordCount(); ++i)
+      {
+        Assert::IsTrue(expected.GetCounts(i) == loaded.GetCounts(i));
+        Assert::AreEqual(expected.GetLength(i), loaded.GetLength(i));
+      }
+    }
+
+    TEST_METHOD(ParseWordList_RejectsWordsOfRemovedLength)
+    {
+      // 長さ 255 は取り除いた単語の印なので、254 文字までの単語だけを読み込む。
+      const String longest(DictionaryIndex::kRemovedLength - 1, U'あ');
+      const String tooLong(DictionaryIndex::kRemovedLength, U'あ');
+      const std::string text = (longest + U"\n" + tooLong + U"\n").toUTF8();
+      const DictionaryLoader::WordList wordList = DictionaryLoader::ParseWordList(AsBytes(text));
+
+      Assert::AreEqual(size_t{ 1 }, wordList.GetWordCount());
+      Assert::IsTrue(wordList.GetWord(0) == longest);
+      Assert::AreEqual(size_t{ 1 }, wordList.rejected_line_count);
+
+      const DictionaryIndex index = DictionaryLoader::BuildIndex(wordList);
+      Assert::IsFalse(index.IsRemoved(0));
+      Assert::AreEqual(uint8{ DictionaryIndex::kRemovedLength - 1 }, index.GetLength(0));
+    }
+
+    TEST_METHOD(ParseWordList_ChunksKeepFileOrder)
+    {
+      std::string text;
+      Array<String> expected;
+      for (const String& word : GetKeywords())
+      {
+        text += word.toUTF8() + "\n";
+        if (!expected.includes(word))
+        {
+          expected << word;
+        }
+      }
+      // 先頭の単語を末尾にもう一度置き、別の塊にある重複も取り除かれることを確かめる。
+      text += GetKeywords().front().toUTF8();
+
+      const DictionaryLoader::WordList wordList = DictionaryLoader::ParseWordList(AsBytes(text), 64);
+
+      Assert::AreEqual(expected.size(), wordList.GetWordCount());
+      Assert::AreEqual(size_t{ 0 }, wordList.rejected_line_count);
+      for (size_t i = 0; i < expected.size(); ++i)
+      {
+        Assert::IsTrue(expected[i] == wordList.GetWord(i));
+      }
+    }
+  };
+
+  TEST_CLASS(DictionaryHotReloaderTests)
+  {
+  public:
+
+    static void WriteWordList(const FilePath& path, const Array<String>& words)
+    {
+      std::string text;
+      for (const auto& word : words)
+      {
+        text += word.toUTF8() + "\n";
+      }
+
+      BinaryWriter writer{ path };
+      writer.write(text.data(), static_cast<int64>(text.size()));
+    }
+
+    static void UpdateUntilIdle(DictionaryHotReloader& reloader, DictionaryIndex& index, IncrementalWordMatcher& matcher)
+    {
+      reloader.RequestReload();
+      reloader.Update(index, matcher);
+      for (int32 i = 0; i < 10000 && reloader.IsBusy(); ++i)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+        reloader.Update(index, matcher);
+      }
+      Assert::IsFalse(reloader.IsBusy());
+    }
+
+    static Array<String> Sorted(Array<String> words)
+    {
+      std::sort(words.begin(), words.end());
+      return words;
+    }
+
+    static Array<String> Merged(const Array<String>& dictionary, const Array<String>& words)
+    {
+      Array<String> merged = dictionary;
+      const HashSet<String> known(dictionary.begin(), dictionary.end());
+      for (const auto& word : words)
+      {
+        if (!known.contains(word))
+        {
+          merged << word;
+        }
+      }
+      return merged;
+    }
+
+    TEST_METHOD(Update_AddsFileWordsOnTopOfDictionary)
+    {
+      BlockManager manager;
+      const Array<String>& keywords = GetKeywords();
+      const FilePath path = FileSystem::TemporaryDirectoryPath() + U"ich_hot_reload_test.txt";
+
+      const Array<String> dictionary(keywords.begin(), keywords.begin() + keywords.size() / 2);
+      DictionaryIndex index(dictionary);
+      IncrementalWordMatcher matcher(index);
+      const Array<String> blocks = { U"し", U"ん", U"ぶ", U"つ", U"い", U"か", U"く" };
+      for (const auto& block : blocks)
+      {
+        matcher.Push(block);
+      }
+
+      DictionaryHotReloader reloader(path, std::chrono::milliseconds{ 0 });
+
+      // 後半の単語と、元の辞書の先頭 10 語をファイルの内容にする。元の辞書の単語は残ったまま、後半の単語が加わる。
+      Array<String> words(keywords.begin() + keywords.size() / 2, keywords.end());
+      words.insert(words.end(), keywords.begin(), keywords.begin() + 10);
+      WriteWordList(path, words);
+      UpdateUntilIdle(reloader, index, matcher);
+
+      Array<String> expected = Merged(dictionary, words);
+      Assert::IsTrue(Sorted(manager.GetHitWords(blocks, expected)) == Sorted(matcher.GetHitWords()));
+      Assert::AreEqual(expected.size(), index.GetWordsUpToLength(1000).size());
+
+      // 単語を減らして読み込み直す。取り除かれるのはファイルから追加した単語だけ。
+      words.erase(words.begin(), words.begin() + words.size() / 3);
+      WriteWordList(path, words);
+      UpdateUntilIdle(reloader, index, matcher);
+
+      expected = Merged(dictionary, words);
+      Assert::IsTrue(Sorted(manager.GetHitWords(blocks, expected)) == Sorted(matcher.GetHitWords()));
+      Assert::AreEqual(expected.size(), index.GetWordsUpToLength(1000).size());
+
+      FileSystem::Remove(path);
+    }
+
+    TEST_METHOD(Reset_AddsFileWordsToSwappedDictionary)
+    {
+      const Array<String>& keywords = GetKeywords();
+      const FilePath path = FileSystem::TemporaryDirectoryPath() + U"ich_hot_reload_reset_test.txt";
+
+      DictionaryIndex index(Array<String>(keywords.begin(), keywords.begin() + 100));
+      IncrementalWordMatcher matcher(index);
+      DictionaryHotReloader reloader(path, std::chrono::milliseconds{ 0 });
+
+      const Array<String> words(keywords.begin() + 200, keywords.begin() + 210);
+      WriteWordList(path, words);
+      UpdateUntilIdle(reloader, index, matcher);
+
+      // 別の辞書に差し替えると、その辞書の単語は残したままファイルの単語だけが加わる。
+      const Array<String> swapped(keywords.begin() + 100, keywords.begin() + 200);
+      index = DictionaryIndex(swapped);
+      matcher = IncrementalWordMatcher(index);
+      reloader.Reset();
+      UpdateUntilIdle(reloader, index, matcher);
+
+      Assert::AreEqual(swapped.size() + words.size(), index.GetWordsUpToLength(1000).size());
+      for (size_t word = 0; word < swapped.size(); ++word)
+      {
+        Assert::IsFalse(index.IsRemoved(word));
+      }
+
+      FileSystem::Remove(path);
+    }
+  };
+
+  TEST_CLASS(WordMatchKernelTests)
+  {
+  public:
+
+    TEST_METHOD(CollectMatches_AllInstructionSetsAgree)
+    {
+      const DictionaryIndex index(GetKeywords());
+      const Array<Array<String>> blockSets = {
+        { U"か", U"わ", U"る", U"め", U"を", U"し", U"た" },
+        { U"す", U"こ", U"つ", U"ふ" },
+        { U"あ", U"い", U"う", U"え", U"お", U"ん", U"ん" },
+        {},
+      };
+
+      for (const auto& blocks : blockSets)
+      {
+        const KanaCounts held = DictionaryIndex::CountBlocks(blocks);
+
+        Array<uint32> expectedHits, expectedReaches;
+        WordMatchKernel::CollectMatches(WordMatchKernel::InstructionSet::kScalar, index, held, 0, index.GetWordCount(), &expectedHits, &expectedReaches);
+
+        for (const auto instructionSet : { WordMatchKernel::InstructionSet::kSse2, WordMatchKernel::InstructionSet::kAvx2 })
+        {
+          Array<uint32> hits, reaches;
+          WordMatchKernel::CollectMatches(instructionSet, index, held, 0, index.GetWordCount(), &hits, &reaches);
+
+          Assert::IsTrue(expectedHits == hits);
+          Assert::IsTrue(expectedReaches == reaches);
+        }
+      }
+    }
+
+    TEST_METHOD(CollectMatches_IgnoresPaddingAfterLastWord)
+    {
+      // 単語数が列の切り上げ単位に満たない場合、0 埋めの部分をヒット扱いしないこと。
+      const DictionaryIndex index(Array<String>{ U"かな", U"はな", U"ながい" });
+      const KanaCounts held = DictionaryIndex::CountBlocks({ U"か", U"な" });
+
+      Array<uint32> hits, reaches;
+      WordMatchKernel::CollectMatches(index, held, 0, index.GetWordCount(), &hits, &reaches);
+
+      Assert::IsTrue(hits == Array<uint32>{ 0 });
+      Assert::IsTrue(reaches == Array<uint32>{ 1, 2 });
+    }
+  };
+
+  TEST_CLASS(KanaBitsetIndexTests)
+  {
+  public:
+
+    TEST_METHOD(CollectMatches_CountsRepeatedKanaThresholds)
+    {
+      // 「ここ」は こ を2個、「こここ」は3個必要とする。
+      const DictionaryIndex index(Array<String>{ U"こ", U"ここ", U"こここ", U"ごご" });
+
+      Array<uint32> hits, reaches;
+      index.GetBitsetIndex().CollectMatches(DictionaryIndex::CountBlocks({ U"こ", U"こ" }), &hits, &reaches);
+
+      Assert::IsTrue(hits == Array<uint32>{ 0, 1, 3 });
+      Assert::IsTrue(reaches == Array<uint32>{ 2 });
+    }
+  };
+
+  TEST_CLASS(AnagramIndexTests)
+  {
+  public:
+
+    TEST_METHOD(CollectHits_FindsAllWordsOfAnagramClass)
+    {
+      const DictionaryIndex index(Array<String>{ U"かい", U"いか", U"がい", U"かいか", U"いかだ" });
+
+      Array<uint32> hits;
+      Assert::IsTrue(index.GetAnagramIndex().CollectHits(index, DictionaryIndex::CountBlocks({ U"い", U"か", U"た" }), hits));
+
+      Assert::IsTrue(hits == Array<uint32>{ 0, 1, 2, 4 });
+    }
+
+    TEST_METHOD(CollectHits_ChecksWordsLongerThanSignature)
+    {
+      const DictionaryIndex index(Array<String>{ U"あいうえおかきくけこさ", U"あい" });
+
+      Array<uint32> hits;
+      Assert::IsTrue(index.GetAnagramIndex().CollectHits(index, DictionaryIndex::CountBlocks({ U"あいうえおかきくけこさ" }), hits));
+
+      Assert::IsTrue(hits == Array<uint32>{ 0, 1 });
+    }
+
+    TEST_METHOD(CollectHits_DeclinesTooManySubMultisets)
+    {
+      const DictionaryIndex index(Array<String>{ U"あい" });
+
+      Array<uint32> hits;
+      Assert::IsFalse(index.GetAnagramIndex().CollectHits(index, DictionaryIndex::CountBlocks({ U"あいうえおかきくけこさしすせ" }), hits));
+      Assert::IsTrue(hits.isEmpty());
+    }
+
+    TEST_METHOD(GetAnagramIndex_IsNotSharedWithPatchedCopy)
+    {
+      const DictionaryIndex index(Array<String>{ U"かい", U"いか" });
+      DictionaryIndex patched = index;
+      patched.AddWord(U"かいか");
+
+      // 変更したコピーが先に補助索引を作っても、元の索引は自分の表から作り直す。
+      Array<uint32> patchedHits;
+      patched.GetAnagramIndex().CollectHits(patched, DictionaryIndex::CountBlocks({ U"か", U"い", U"か" }), patchedHits);
+
+      Array<uint32> hits;
+      Assert::IsTrue(index.GetAnagramIndex().CollectHits(index, DictionaryIndex::CountBlocks({ U"か", U"い", U"か" }), hits));
+      Assert::IsTrue(hits == Array<uint32>{ 0, 1 });
+    }
+  };
+
+  TEST_CLASS(WordPackingSolverTests)
+  {
+  public:
+
+    /// <summary>
+    /// ヒット単語から重ならない組み合わせをすべて試して、得点（文字数の合計）の最大値を求める。
+    /// </summary>
+    static int32 BruteForceBestScore(const DictionaryIndex& index, const Array<uint32>& hits, const size_t first, KanaCounts& rest)
+    {
+      int32 best = 0;
+      for (size_t i = first; i < hits.size(); ++i)
+      {
+        const KanaCounts& required = index.GetCounts(hits[i]);
+        if (!std::equal(required.begin(), required.end(), rest.begin(), [](const uint8 r, const uint8 h) { return r <= h; }))
+        {
+          continue;
+        }
+
+        for (size_t id = 0; id < kKanaAlphabetSize; ++id) rest[id] -= required[id];
+        best = std::max(best, index.GetLength(hits[i]) + BruteForceBestScore(index, hits, i + 1, rest));
+        for (size_t id = 0; id < kKanaAlphabetSize; ++id) rest[id] += required[id];
+      }
+      return best;
+    }
+
+    TEST_METHOD(Solve_MatchesBruteForce)
+    {
+      const DictionaryIndex index(GetKeywords());
+
+      for (const auto& hand : { U"かわるめをした", U"いかだかいし", U"あいうえおかき", U"たがくこうぷす", U"しかいかいし", U"ん" })
+      {
+        const KanaCounts held = DictionaryIndex::CountBlocks({ String{ hand } });
+        const auto result = WordPackingSolver::Solve(index, held);
+        Assert::IsTrue(result.has_value());
+
+        Array<uint32> hits;
+        WordMatchKernel::CollectMatches(index, held, 0, index.GetWordCount(), &hits, nullptr);
+        KanaCounts rest = held;
+        Assert::AreEqual(BruteForceBestScore(index, hits, 0, rest), result->score);
+
+        // 選んだ単語は手持ちを重複なく分け合っている。
+        KanaCounts used{};
+        int32 score = 0;
+        for (const uint32 word : result->word_ids)
+        {
+          for (size_t id = 0; id < kKanaAlphabetSize; ++id) used[id] += index.GetCounts(word)[id];
+          score += index.GetLength(word);
+        }
+        Assert::IsTrue(used == result->used);
+        Assert::AreEqual(score, result->score);
+        Assert::IsTrue(std::equal(used.begin(), used.end(), held.begin(), [](const uint8 u, const uint8 h) { return u <= h; }));
+      }
+    }
+
+    TEST_METHOD(Solve_UsesScorerAndPatchedIndex)
+    {
+      DictionaryIndex index(Array<String>{ U"いか", U"いかだ", U"だし" });
+      const KanaCounts held = DictionaryIndex::CountBlocks({ U"い", U"か", U"だ", U"し" });
+
+      // 文字数なら「いか」＋「だし」の 4 文字。
+      auto result = WordPackingSolver::Solve(index, held);
+      Assert::IsTrue(result->word_ids == Array<uint32>{ 0, 2 });
+      Assert::AreEqual(int32{ 4 }, result->score);
+
+      // 単語ごとの得点を変えると組み合わせも変わる。
+      const auto scorer = [](const DictionaryIndex&, const uint32 word) { return (word == 1) ? 10 : 1; };
+      result = WordPackingSolver::Solve(index, held, scorer);
+      Assert::IsTrue(result->word_ids == Array<uint32>{ 1 });
+      Assert::AreEqual(int32{ 10 }, result->score);
+
+      // 差分更新後の索引ではヒット単語の走査に切り替わる。取り除いた単語は選ばない。
+      index.RemoveWord(0);
+      index.AddWord(U"しかいだ");
+      result = WordPackingSolver::Solve(index, held);
+      Assert::IsTrue(result->word_ids == Array<uint32>{ 3 });
+      Assert::AreEqual(int32{ 4 }, result->score);
+    }
+
+    TEST_METHOD(CashIn_UsesWordsAlreadyCompletedInAnyOrderMode)
+    {
+      const DictionaryIndex index(Array<String>{ U"いか", U"いかし", U"たし" });
+      IncrementalWordMatcher matcher(index);
+      WordStateSnapshot snapshot;
+      Array<KanaId> held(5, kInvalidKanaId);
+      Array<String> completed;
+
+      // Game::update の順不同モードと同じく、ブロックを壊すたびに手持ちへ加え、作れた単語はその場で完成にする。
+      for (const char32 kana : U"いかたしく")
+      {
+        if (kana == U'\0')
+        {
+          break;
+        }
+
+        held.push_back(ToKanaId(kana));
+        matcher.Push(held.back());
+        while (held.size() > 5)
+        {
+          matcher.Evict(held.front());
+          held.erase(held.begin());
+        }
+
+        snapshot.Refresh(matcher, held, completed);
+        for (const uint32 hitId : snapshot.GetMatches().hit_ids)
+        {
+          const String word{ index.GetWord(hitId) };
+          if (!completed.includes(word))
+          {
+            completed << word;
+          }
+        }
+      }
+      Assert::IsTrue(completed.includes(U"いか") && completed.includes(U"たし"));
+
+      // 完成済みでも、手持ちで作れる単語は換金でき、使った文字が手持ちと判定器から消える。
+      const auto result = WordPackingSolver::CashIn(index, matcher, held);
+      Assert::IsTrue(result.has_value());
+      Assert::IsTrue(result->word_ids == Array<uint32>{ 0, 2 });
+      Assert::IsTrue(held == Array<KanaId>{ ToKanaId(U'く') });
+      Assert::IsTrue(matcher.GetHeldCounts() == DictionaryIndex::CountBlocks({ U"く" }));
+
+      // 作れる単語がなければ手持ちは変わらない。
+      Assert::IsTrue(WordPackingSolver::CashIn(index, matcher, held)->word_ids.isEmpty());
+      Assert::AreEqual(size_t{ 1 }, held.size());
+    }
+
+    TEST_METHOD(Solve_DeclinesTooManySubMultisets)
+    {
+      const DictionaryIndex index(Array<String>{ U"あい" });
+      Assert::IsFalse(WordPackingSolver::Solve(index, DictionaryIndex::CountBlocks({ U"あいうえおかきくけこ" })).has_value());
+    }
+  };
+
+  TEST_CLASS(DeletionIndexTests)
+  {
+  public:
+
+    TEST_METHOD(CollectReaches_ReturnsLastOccurrenceOfMissingKana)
+    {
+      const DictionaryIndex index(Array<String>{ U"はば", U"かいか", U"かい", U"いか" });
+
+      Array<DeletionIndex::Reach> reaches;
+      Assert::IsTrue(index.GetDeletionIndex().CollectReaches(index, DictionaryIndex::CountBlocks({ U"は", U"か", U"い" }), reaches));
+
+      // かい・いか は手持ちだけで完成するのでヒットであり、リーチには含まれない。
+      Assert::AreEqual(size_t{ 2 }, reaches.size());
+      Assert::AreEqual(uint32{ 0 }, reaches[0].word);
+      Assert::IsTrue(reaches[0].character == U'ば');
+      Assert::AreEqual(uint32{ 1 }, reaches[1].word);
+      Assert::IsTrue(reaches[1].character == U'か');
+    }
+
+    TEST_METHOD(CollectReaches_ChecksWordsLongerThanSignature)
+    {
+      const DictionaryIndex index(Array<String>{ U"あいうえおかきくけこさし", U"あいうえおかきくけこさ" });
+
+      Array<DeletionIndex::Reach> reaches;
+      Assert::IsTrue(index.GetDeletionIndex().CollectReaches(index, DictionaryIndex::CountBlocks({ U"あいうえおかきくけこ" }), reaches));
+      Assert::AreEqual(size_t{ 1 }, reaches.size());
+      Assert::AreEqual(uint32{ 1 }, reaches[0].word);
+      Assert::IsTrue(reaches[0].character == U'さ');
+
+      reaches.clear();
+      Assert::IsTrue(index.GetDeletionIndex().CollectReaches(index, DictionaryIndex::CountBlocks({ U"あいうえおかきくけこさ" }), reaches));
+      Assert::AreEqual(size_t{ 1 }, reaches.size());
+      Assert::AreEqual(uint32{ 0 }, reaches[0].word);
+      Assert::IsTrue(reaches[0].character == U'し');
+    }
+  };
+
+  TEST_CLASS(OrderedWordAutomatonTests)
+  {
+  public:
+
+    static Array<KanaId> ToKanaIds(const String& word)
+    {
+      Array<KanaId> ids;
+      for (const char32 ch : word)
+      {
+        if (const auto normalized = NormalizeKanaChar(ch))
+        {
+          ids << ToKanaId(*normalized);
+        }
+      }
+      return ids;
+    }
+
+    TEST_METHOD(Next_ReportsWordsEndingAtEachStep)
+    {
+      const DictionaryIndex index(GetKeywords());
+      const OrderedWordAutomaton automaton(index);
+
+      Array<Array<KanaId>> words;
+      for (size_t i = 0; i < index.GetWordCount(); ++i)
+      {
+        words << ToKanaIds(String{ index.GetWord(i) });
+      }
+
+      // 辞書の単語をつなげた列に余計な文字を挟み、各時点で末尾に一致する単語を総当たりと比べる。
+      Array<KanaId> stream;
+      for (size_t i = 0; i < words.size(); i += 7)
+      {
+        stream.insert(stream.end(), words[i].begin(), words[i].end());
+        stream << static_cast<KanaId>(i % kKanaAlphabetSize);
+      }
+
+      OrderedWordAutomaton::State state = OrderedWordAutomaton::kRootState;
+      for (size_t pos = 0; pos < stream.size(); ++pos)
+      {
+        state = automaton.Next(state, stream[pos]);
+
+        Array<uint32> actual;
+        automaton.ForEachMatch(state, [&](const uint32 word) { actual << word; });
+        std::sort(actual.begin(), actual.end());
+
+        Array<uint32> expected;
+        for (size_t word = 0; word < words.size(); ++word)
+        {
+          const auto& kana = words[word];
+          if (!kana.isEmpty() && kana.size() <= pos + 1 && std::equal(kana.begin(), kana.end(), stream.begin() + (pos + 1 - kana.size())))
+          {
+            expected << static_cast<uint32>(word);
+          }
+        }
+
+        Assert::IsTrue(expected == actual);
+      }
+    }
+
+    TEST_METHOD(ForEachMatch_ListsWordsWithSameNormalizedForm)
+    {
+      DictionaryIndex index(Array<String>{ U"はし", U"ばし", U"し", U"はしご" });
+      index.RemoveWord(2);
+      const OrderedWordAutomaton automaton(index);
+
+      OrderedWordAutomaton::State state = OrderedWordAutomaton::kRootState;
+      for (const KanaId id : ToKanaIds(U"ぱし"))
+      {
+        state = automaton.Next(state, id);
+      }
+
+      Array<uint32> matches;
+      automaton.ForEachMatch(state, [&](const uint32 word) { matches << word; });
+      Assert::IsTrue(matches == Array<uint32>{ 0, 1 });
+
+      Assert::AreEqual(OrderedWordAutomaton::kRootState, automaton.Next(state, kInvalidKanaId));
+    }
+  };
+
+  TEST_CLASS(ShiritoriGraphTests)
+  {
+  public:
+
+    /// <summary>
+    /// まだ使っていない単語を1つずつ試して、続けられる鎖の最長の長さを求める。
+    /// </summary>
+    static int32 BruteForceLongestChain(const ShiritoriGraph& graph, const size_t wordCount, const KanaId last, Array<bool>& used)
+    {
+      int32 best = 0;
+      for (uint32 word = 0; word < wordCount; ++word)
+      {
+        if (!used[word] && graph.CanFollow(last, word))
+        {
+          used[word] = true;
+          best = std::max(best, 1 + BruteForceLongestChain(graph, wordCount, graph.GetLastKana(word), used));
+          used[word] = false;
+        }
+      }
+      return best;
+    }
+
+    TEST_METHOD(FindLongestChain_MatchesBruteForce)
+    {
+      const Array<String> words = { U"りんご", U"ごりら", U"らっぱ", U"ぱいなっぷる", U"るすばん", U"らくだ", U"だるま", U"まり", U"りす", U"すいか", U"かかし", U"しまうま", U"まくら" };
+      const DictionaryIndex index(words);
+      const ShiritoriGraph graph(index);
+
+      // 最初・最後の文字は正規化後の文字（濁点・半濁点は外す）。
+      Assert::AreEqual(ToKanaId(U'は'), graph.GetFirstKana(3));
+      Assert::AreEqual(ToKanaId(U'こ'), graph.GetLastKana(0));
+      Assert::IsTrue(graph.CanFollow(ToKanaId(U'ら'), 5));
+      Assert::IsFalse(graph.CanFollow(ToKanaId(U'ら'), 0));
+
+      Array<bool> used(words.size(), false);
+      auto result = graph.FindLongestChain(kInvalidKanaId, {});
+      Assert::IsTrue(result.is_exact);
+      Assert::AreEqual(BruteForceLongestChain(graph, words.size(), kInvalidKanaId, used), result.length);
+
+      // 「りんご」「ごりら」を使った後、「ら」から続ける。
+      const Array<uint32> chain = { 0, 1 };
+      used[0] = used[1] = true;
+      result = graph.FindLongestChain(ToKanaId(U'ら'), chain);
+      Assert::IsTrue(result.is_exact);
+      Assert::AreEqual(BruteForceLongestChain(graph, words.size(), ToKanaId(U'ら'), used), result.length);
+      Assert::AreEqual(int32{ 0 }, graph.FindLongestChain(ToKanaId(U'ん'), chain).length);
+    }
+
+    TEST_METHOD(FindLongestChain_StopsAtBudget)
+    {
+      const DictionaryIndex index(GetKeywords());
+      const ShiritoriGraph graph(index);
+
+      const auto result = graph.FindLongestChain(kInvalidKanaId, {}, 1000);
+      Assert::IsFalse(result.is_exact);
+      Assert::IsTrue(result.length > 0);
+    }
+
+    TEST_METHOD(ChainSearcher_ReturnsLatestRequest)
+    {
+      const DictionaryIndex index(Array<String>{ U"りんご", U"ごりら", U"らっぱ", U"ぱんだ", U"だるま" });
+      const auto graph = std::make_shared<const ShiritoriGraph>(index);
+      ShiritoriChainSearcher searcher;
+
+      searcher.Request(graph, kInvalidKanaId, {});
+      searcher.Request(graph, ToKanaId(U'こ'), { 0 });
+      Assert::IsFalse(searcher.GetResult().has_value());
+
+      while (searcher.IsBusy())
+      {
+        searcher.Update();
+        std::this_thread::yield();
+      }
+
+      // 最後の依頼（「りんご」の後、「ごりら」「らっぱ」「ぱんだ」「だるま」）の結果だけが残る。
+      Assert::IsTrue(searcher.GetResult().has_value());
+      Assert::AreEqual(int32{ 4 }, searcher.GetResult()->length);
+    }
+  };
+
+  TEST_CLASS(PathWordFinderTests)
+  {
+  public:
+
+    static constexpr int32 kRows = 6;
+    static constexpr int32 kColumns = 6;
+
+    /// <summary>
+    /// 単語の文字を、隣り合うマスを一度ずつたどって並べられるか。
+    /// </summary>
+    static bool HasPath(const Array<KanaId>& cells, const Array<KanaId>& word, const size_t depth, const int32 cell, Array<bool>& visited, const int32 rowBegin, const int32 rowEnd)
+    {
+      const int32 row = cell / kColumns;
+      if (row < rowBegin || row >= rowEnd || visited[cell] || cells[cell] != word[depth])
+      {
+        return false;
+      }
+      if (depth + 1 == word.size())
+      {
+        return true;
+      }
+
+      visited[cell] = true;
+      bool found = false;
+      for (int32 dr = -1; dr <= 1 && !found; ++dr)
+      {
+        for (int32 dc = -1; dc <= 1 && !found; ++dc)
+        {
+          const int32 r = row + dr;
+          const int32 c = cell % kColumns + dc;
+          if ((dr != 0 || dc != 0) && r >= 0 && r < kRows && c >= 0 && c < kColumns)
+          {
+            found = HasPath(cells, word, depth + 1, r * kColumns + c, visited, rowBegin, rowEnd);
+          }
+        }
+      }
+      visited[cell] = false;
+      return found;
+    }
+
+    static Array<uint32> BruteForceFind(const DictionaryIndex& index, const Array<KanaId>& cells, const int32 rowBegin, const int32 rowEnd)
+    {
+      Array<uint32> found;
+      for (size_t word = 0; word < index.GetWordCount(); ++word)
+      {
+        const StringView text = index.GetWord(word);
+        Array<char32> normalized(text.size());
+        normalized.resize(NormalizeKana(std::span<const char32>(text.data(), text.size()), normalized));
+        Array<KanaId> kana;
+        for (const char32 ch : normalized)
+        {
+          kana << ToKanaId(ch);
+        }
+
+        Array<bool> visited(cells.size(), false);
+        for (int32 cell = 0; cell < static_cast<int32>(cells.size()); ++cell)
+        {
+          if (!kana.isEmpty() && HasPath(cells, kana, 0, cell, visited, rowBegin, rowEnd))
+          {
+            found << static_cast<uint32>(word);
+            break;
+          }
+        }
+      }
+      return found;
+    }
+
+    TEST_METHOD(SetGrid_MatchesBruteForce)
+    {
+      const DictionaryIndex index(GetKeywords());
+      const Array<KanaId> cells = MakeCells(U"かいしたらめ" U"わるこうすか" U"くにんをてい" U"まさとおきし" U"のりあかつな" U"はやえせもろ");
+
+      PathWordFinder finder(index);
+      finder.SetVisibleRows(0, kRows);
+      finder.SetGrid(kRows, kColumns, cells);
+      Assert::IsFalse(finder.GetFoundWords().isEmpty());
+      Assert::IsTrue(BruteForceFind(index, cells, 0, kRows) == finder.GetFoundWords());
+
+      // 見えている行の外を通る経路は数えない。
+      finder.SetVisibleRows(1, 4);
+      Assert::IsTrue(BruteForceFind(index, cells, 1, 4) == finder.GetFoundWords());
+    }
+
+    TEST_METHOD(ClearCell_MatchesFullSearch)
+    {
+      const DictionaryIndex index(GetKeywords());
+      Array<KanaId> cells = MakeCells(U"かいしたらめ" U"わるこうすか" U"くにんをてい" U"まさとおきし" U"のりあかつな" U"はやえせもろ");
+
+      PathWordFinder finder(index);
+      finder.SetVisibleRows(0, kRows);
+      finder.SetGrid(kRows, kColumns, cells);
+
+      for (const int32 cell : { 7, 14, 0, 21, 8, 35 })
+      {
+        const Array<uint32> before = finder.GetFoundWords();
+        const Array<uint32> claimed = finder.ClearCell(cell / kColumns, cell % kColumns);
+        cells[cell] = kInvalidKanaId;
+
+        const Array<uint32> expected = BruteForceFind(index, cells, 0, kRows);
+        Assert::IsTrue(expected == finder.GetFoundWords());
+
+        // 消えた単語はすべて壊したマスを通っていた。壊したマスを通る単語は壊す前にできていた単語に限る。
+        for (const uint32 word : before)
+        {
+          if (!expected.includes(word))
+          {
+            Assert::IsTrue(claimed.includes(word));
+          }
+        }
+        for (const uint32 word : claimed)
+        {
+          Assert::IsTrue(before.includes(word));
+        }
+      }
+    }
+  };
+
+  TEST_CLASS(IncrementalWordMatcherTests)
+  {
+  public:
+
+    TEST_METHOD(PushAndEvict_MatchesFullScanOverSlidingWindow)
     {
-      Assert::AreEqual(5, Add(2, 3));
-      Assert::AreEqual(0, Add(0, 0));
+      BlockManager manager;
+      const DictionaryIndex index(GetKeywords());
+      IncrementalWordMatcher matcher(index);
+
+      const Array<String> stream = {
+        U"か", U"わ", U"る", U"め", U"を", U"し", U"た", U"が", U"く", U"こ", U"う", U"ぷ", U"す", U"つ", U"ん", U"い", U"ー",
+      };
+      const size_t windowSize = 7;
+      Array<String> window;
+
+      for (const auto& block : stream)
+      {
+        window << block;
+        matcher.Push(block);
+
+        while (window.size() > windowSize)
+        {
+          matcher.Evict(window.front());
+          window.erase(window.begin());
+        }
+
+        Assert::IsTrue(manager.GetHitWords(window, GetKeywords()) == matcher.GetHitWords());
+        Assert::IsTrue(manager.GetReachWords(window, GetKeywords()) == matcher.GetReachWords());
+      }
     }
 
-    TEST_METHOD(Add_HandlesNegativeValues)
+    TEST_METHOD(AddAndRemoveWord_MatchesFullScan)
     {
-      Assert::AreEqual(-1, Add(2, -3));
-      Assert::AreEqual(-5, Add(-2, -3));
+      BlockManager manager;
+      const Array<String>& keywords = GetKeywords();
+      const size_t half = keywords.size() / 2;
+      DictionaryIndex index(Array<String>(keywords.begin(), keywords.begin() + half));
+      IncrementalWordMatcher matcher(index);
+
+      Array<String> window = { U"か", U"わ", U"る", U"め", U"を", U"し" };
+      for (const auto& block : window)
+      {
+        matcher.Push(block);
+      }
+
+      // 手持ちがある状態で辞書を変更する。取り除く単語は索引より先に判定器から外しても後でもよい。
+      Array<String> active;
+      for (size_t i = 0; i < half; ++i)
+      {
+        if (i % 2 == 0)
+        {
+          matcher.RemoveWord(static_cast<uint32>(i));
+          index.RemoveWord(static_cast<uint32>(i));
+        }
+        else if (i % 5 == 0)
+        {
+          index.RemoveWord(static_cast<uint32>(i));
+          matcher.RemoveWord(static_cast<uint32>(i));
+        }
+        else
+        {
+          active << keywords[i];
+        }
+      }
+      for (size_t i = half; i < keywords.size(); ++i)
+      {
+        matcher.AddWord(index.AddWord(keywords[i]));
+        active << keywords[i];
+      }
+
+      Assert::IsTrue(manager.GetHitWords(window, active) == matcher.GetHitWords());
+      Assert::IsTrue(manager.GetReachWords(window, active) == matcher.GetReachWords());
+
+      for (const auto& block : { U"た", U"が", U"く", U"こ", U"う", U"ぷ", U"す", U"つ", U"ん", U"い" })
+      {
+        window << block;
+        matcher.Push(String{ block });
+        matcher.Evict(window.front());
+        window.erase(window.begin());
+
+        Assert::IsTrue(manager.GetHitWords(window, active) == matcher.GetHitWords());
+        Assert::IsTrue(manager.GetReachWords(window, active) == matcher.GetReachWords());
+      }
+    }
+
+    TEST_METHOD(QueryMatches_MatchesBlockManagerQuery)
+    {
+      BlockManager manager;
+      const DictionaryIndex index(GetKeywords());
+      IncrementalWordMatcher matcher(index);
+      const Array<String> blocks = { U"か", U"わ", U"る", U"め", U"を", U"し", U"た" };
+
+      for (const auto& block : blocks)
+      {
+        matcher.Push(block);
+      }
+
+      WordMatchBuffers expected;
+      WordMatchBuffers actual;
+      manager.QueryMatches(blocks, index, expected, false);
+      matcher.QueryMatches(actual, false);
+
+      Assert::IsTrue(expected.hit_ids == actual.hit_ids);
+      Assert::IsTrue(expected.reach_ids == actual.reach_ids);
+      Assert::IsTrue(expected.reach_missing == actual.reach_missing);
+    }
+
+    TEST_METHOD(Evict_IgnoresKanaThatIsNotHeld)
+    {
+      const DictionaryIndex index(Array<String>{ U"かな", U"な" });
+      IncrementalWordMatcher matcher(index);
+
+      matcher.Push(U"な");
+      matcher.Evict(U"か");
+
+      Assert::IsTrue(matcher.GetHitWords() == Array<String>{ U"な" });
+      Assert::IsTrue(matcher.GetReachWords() == Array<std::pair<String, String>>{ { U"かな", U"か" } });
+    }
+  };
+
+  TEST_CLASS(NextBlockAdvisorTests)
+  {
+  public:
+
+    TEST_METHOD(Step_FindsBlockThatCompletesMostWords)
+    {
+      const DictionaryIndex index(Array<String>{ U"いか", U"たいかい", U"しま" });
+      NextBlockAdvisor advisor(index, NextBlockAdvisor::Settings{ 1, 3, 8 });
+
+      // 「か」を壊せば「いか」、さらに「た」「い」を壊せば「たいかい」もできる。「し」は周囲の外。
+      const Array<KanaId> held = { ToKanaId(U'い') };
+      advisor.Start(3, 4, MakeCells(U"ねかたし" U"の　いし" U"ぬねのし"), 1, 1, held, 7, {});
+      while (!advisor.Step()) {}
+
+      Assert::IsTrue(advisor.GetAdvice().has_value());
+      Assert::AreEqual(int32{ 0 }, advisor.GetAdvice()->row);
+      Assert::AreEqual(int32{ 1 }, advisor.GetAdvice()->column);
+      Assert::AreEqual(int32{ 6 }, advisor.GetAdvice()->score);
+
+      // 完成済みの単語は数えないので、「たいかい」の手順だけが得点になる。
+      advisor.Start(3, 4, MakeCells(U"ねかたし" U"の　いし" U"ぬねのし"), 1, 1, held, 7, { U"いか" });
+      while (!advisor.Step()) {}
+      Assert::AreEqual(int32{ 4 }, advisor.GetAdvice()->score);
+    }
+
+    TEST_METHOD(Step_SplitsSearchIntoTimeSlices)
+    {
+      const DictionaryIndex index(GetKeywords());
+      NextBlockAdvisor advisor(index, NextBlockAdvisor::Settings{ 2, 3, 4 });
+
+      const Array<KanaId> held = { ToKanaId(U'か'), ToKanaId(U'い'), ToKanaId(U'し') };
+      advisor.Start(5, 5, MakeCells(U"たらめわる" U"こうすかく" U"にんをてい" U"まさとおき" U"のりあかつ"), 2, 2, held, 7, {});
+
+      // 時間の上限が 0 でも、1回の Step で1つの手順は展開するので必ず終わる。
+      size_t stepCount = 1;
+      while (!advisor.Step(std::chrono::microseconds{ 0 }))
+      {
+        ++stepCount;
+      }
+      Assert::IsTrue(stepCount > 1);
+      Assert::IsFalse(advisor.IsRunning());
+      Assert::IsTrue(advisor.GetAdvice().has_value());
+    }
+
+    TEST_METHOD(Start_CarriesMatcherOverBetweenHands)
+    {
+      const DictionaryIndex index(GetKeywords());
+      const Array<KanaId> cells = MakeCells(U"たらめわる" U"こうすかく" U"にんをてい" U"まさとおき" U"のりあかつ");
+      const Array<KanaId> first = { ToKanaId(U'か'), ToKanaId(U'い'), ToKanaId(U'し'), ToKanaId(U'し') };
+      const Array<KanaId> second = { ToKanaId(U'い'), ToKanaId(U'た'), ToKanaId(U'ん'), kInvalidKanaId };
+
+      // 判定器は前の探索の手持ちから差分で合わせるので、新しく作った提案器と同じ結果になる。
+      NextBlockAdvisor reused(index, NextBlockAdvisor::Settings{ 2, 3, 4 });
+      reused.Start(5, 5, cells, 2, 2, first, 7, {});
+      while (!reused.Step()) {}
+      reused.Start(5, 5, cells, 1, 3, second, 7, {});
+      while (!reused.Step()) {}
+
+      NextBlockAdvisor fresh(index, NextBlockAdvisor::Settings{ 2, 3, 4 });
+      fresh.Start(5, 5, cells, 1, 3, second, 7, {});
+      while (!fresh.Step()) {}
+
+      Assert::IsTrue(fresh.GetAdvice().has_value());
+      Assert::IsTrue(reused.GetAdvice().has_value());
+      Assert::AreEqual(fresh.GetAdvice()->row, reused.GetAdvice()->row);
+      Assert::AreEqual(fresh.GetAdvice()->column, reused.GetAdvice()->column);
+      Assert::AreEqual(fresh.GetAdvice()->score, reused.GetAdvice()->score);
+      Assert::AreEqual(fresh.GetAdvice()->reach_count, reused.GetAdvice()->reach_count);
+    }
+  };
+
+  TEST_CLASS(WordStateSnapshotTests)
+  {
+  public:
+
+    TEST_METHOD(Refresh_RecomputesOnlyWhenInputsChange)
+    {
+      const DictionaryIndex index(Array<String>{ U"いか", U"かい", U"いかだ" });
+      IncrementalWordMatcher matcher(index);
+      WordStateSnapshot snapshot;
+
+      Array<KanaId> held = { ToKanaId(U'い'), ToKanaId(U'か') };
+      Array<String> completed;
+      for (const KanaId id : held)
+      {
+        matcher.Push(id);
+      }
+
+      Assert::IsTrue(snapshot.Refresh(matcher, held, completed));
+      Assert::IsFalse(snapshot.Refresh(matcher, held, completed));
+      Assert::AreEqual(uint64{ 1 }, snapshot.GetVersion());
+
+      Assert::IsTrue(snapshot.GetMatches().hit_ids == Array<uint32>{ 0, 1 });
+      Assert::IsTrue(snapshot.GetMatches().reach_ids == Array<uint32>{ 2 });
+      Assert::IsFalse(snapshot.IsInCompletedWord(0));
+
+      // 完成済みの単語が増えると、ブロックの色分けだけ計算し直す。
+      completed << U"いか";
+      Assert::IsTrue(snapshot.Refresh(matcher, held, completed));
+      Assert::IsTrue(snapshot.IsInCompletedWord(0));
+      Assert::IsTrue(snapshot.IsInCompletedWord(1));
+
+      held << ToKanaId(U'た');
+      matcher.Push(ToKanaId(U'た'));
+      Assert::IsTrue(snapshot.Refresh(matcher, held, completed));
+      Assert::IsTrue(snapshot.GetMatches().hit_ids == Array<uint32>{ 0, 1, 2 });
+      Assert::IsFalse(snapshot.IsInCompletedWord(2));
+    }
+
+    TEST_METHOD(Refresh_PicksHintOnlyWhenRequested)
+    {
+      const DictionaryIndex index(Array<String>{ U"いか", U"かい", U"いかだ", U"いかり" });
+      IncrementalWordMatcher matcher(index);
+      WordStateSnapshot snapshot;
+
+      const Array<KanaId> held = { ToKanaId(U'い'), ToKanaId(U'か') };
+      const Array<String> completed;
+      for (const KanaId id : held)
+      {
+        matcher.Push(id);
+      }
+
+      Assert::IsTrue(snapshot.Refresh(matcher, held, completed));
+      Assert::IsFalse(snapshot.GetMatches().hint.has_value());
+
+      // 入力が同じでも、ヒントを求めれば問い合わせ直してリーチ単語から1件選ぶ。
+      Assert::IsTrue(snapshot.Refresh(matcher, held, completed, true));
+      const WordMatchBuffers& matches = snapshot.GetMatches();
+      Assert::IsTrue(matches.hint.has_value());
+      Assert::IsTrue(*matches.hint < matches.reach_ids.size());
+      Assert::IsTrue(matches.reach_ids == Array<uint32>{ 2, 3 });
     }
   };
 
@@ -90,7 +1619,7 @@ namespace UnitTest
       BlockManager manager;
       const Array<String> blocks = { U"か", U"わ", U"る", U"め", U"を" };
 
-      const auto result = manager.GetHitWords(blocks, keywords);
+      const auto result = manager.GetHitWords(blocks, GetKeywords());
 
       Assert::AreEqual(static_cast<size_t>(1), result.size());
       Assert::IsTrue(result.contains(U"わかめ"));
@@ -102,11 +1631,301 @@ namespace UnitTest
       BlockManager manager;
       const Array<String> blocks = { U"か", U"わ", U"る", U"め", U"を" };
 
-      const auto result = manager.GetReachWords(blocks, keywords);
+      const auto result = manager.GetReachWords(blocks, GetKeywords());
 
       Assert::IsTrue(result.contains(std::make_pair(String(U"わかれる"), String(U"れ"))));
     }
 
+    TEST_METHOD(GetHitWords_IndexMatchesArrayDictionary)
+    {
+      BlockManager manager;
+      const DictionaryIndex index(GetKeywords());
+      const Array<String> blocks = { U"か", U"わ", U"る", U"め", U"を", U"し", U"た" };
+
+      const auto expected = manager.GetHitWords(blocks, GetKeywords());
+      const auto actual = manager.GetHitWords(blocks, index);
+
+      Assert::IsTrue(expected == actual);
+    }
+
+    TEST_METHOD(GetReachWords_IndexMatchesArrayDictionary)
+    {
+      BlockManager manager;
+      const DictionaryIndex index(GetKeywords());
+      const Array<String> blocks = { U"か", U"わ", U"る", U"め", U"を", U"し", U"た" };
+
+      const auto expected = manager.GetReachWords(blocks, GetKeywords());
+      const auto actual = manager.GetReachWords(blocks, index);
+
+      Assert::IsTrue(expected == actual);
+    }
+
+    TEST_METHOD(GetHitWords_AllBackendsAgree)
+    {
+      BlockManager manager;
+      const DictionaryIndex index(GetKeywords());
+      const Array<Array<String>> blockSets = {
+        { U"か", U"わ", U"る", U"め", U"を", U"し", U"た" },
+        { U"し", U"し", U"ん", U"ん", U"ぶ", U"つ", U"い" },
+        { U"す", U"こ", U"ぷ" },
+      };
+
+      for (const auto& blocks : blockSets)
+      {
+        const auto expectedHits = manager.GetHitWords(blocks, GetKeywords());
+        const auto expectedReaches = manager.GetReachWords(blocks, GetKeywords());
+
+        for (const auto backend : { BlockManager::MatchBackend::kScalar, BlockManager::MatchBackend::kSimd, BlockManager::MatchBackend::kBitset, BlockManager::MatchBackend::kAnagram })
+        {
+          manager.SetMatchBackend(backend);
+          Assert::IsTrue(expectedHits == manager.GetHitWords(blocks, index));
+          Assert::IsTrue(expectedReaches == manager.GetReachWords(blocks, index));
+        }
+      }
+    }
+
+    TEST_METHOD(GetHitWords_ParallelScanKeepsDictionaryOrder)
+    {
+      BlockManager manager;
+      const DictionaryIndex index(GetKeywords());
+      const Array<String> blocks = { U"し", U"し", U"ん", U"ん", U"ぶ", U"つ", U"い" };
+
+      const auto expectedHits = manager.GetHitWords(blocks, GetKeywords());
+      const auto expectedReaches = manager.GetReachWords(blocks, GetKeywords());
+
+      // 小さな区間に分けて並列走査させても、結果は辞書順のまま変わらないこと。
+      manager.SetParallelScanOptions({ 0, 100 });
+
+      for (const auto backend : { BlockManager::MatchBackend::kScalar, BlockManager::MatchBackend::kSimd })
+      {
+        manager.SetMatchBackend(backend);
+        Assert::IsTrue(expectedHits == manager.GetHitWords(blocks, index));
+        Assert::IsTrue(expectedReaches == manager.GetReachWords(blocks, index));
+      }
+    }
+
+    TEST_METHOD(GetReachWords_IndexReturnsOriginalCharacterForm)
+    {
+      BlockManager manager;
+      const DictionaryIndex index(Array<String>{ U"すこっぷ", U"がく" });
+      const Array<String> blocks = { U"す", U"こ", U"つ", U"く" };
+
+      const auto result = manager.GetReachWords(blocks, index);
+
+      Assert::AreEqual(static_cast<size_t>(2), result.size());
+      Assert::IsTrue(result[0].second == U"ぷ");
+      Assert::IsTrue(result[1].second == U"が");
+    }
+
+    TEST_METHOD(QueryMatches_MatchesHitAndReachWords)
+    {
+      BlockManager manager;
+      const DictionaryIndex index(GetKeywords());
+      const Array<String> blocks = { U"し", U"し", U"ん", U"ん", U"ぶ", U"つ", U"い" };
+
+      const auto expectedHits = manager.GetHitWords(blocks, GetKeywords());
+      const auto expectedReaches = manager.GetReachWords(blocks, GetKeywords());
+      const KanaCounts held = DictionaryIndex::CountBlocks(blocks);
+
+      WordMatchBuffers buffers;
+      for (const auto backend : { BlockManager::MatchBackend::kScalar, BlockManager::MatchBackend::kSimd, BlockManager::MatchBackend::kBitset, BlockManager::MatchBackend::kAnagram })
+      {
+        manager.SetMatchBackend(backend);
+        manager.QueryMatches(blocks, index, buffers, true);
+
+        Array<String> hits;
+        for (const uint32 id : buffers.hit_ids)
+        {
+          hits << String{ index.GetWord(id) };
+        }
+        Assert::IsTrue(expectedHits == hits);
+
+        Array<std::pair<String, String>> reaches;
+        for (size_t i = 0; i < buffers.reach_ids.size(); ++i)
+        {
+          reaches.emplace_back(index.GetWord(buffers.reach_ids[i]), index.GetMissingCharacter(buffers.reach_ids[i], buffers.reach_missing[i], held));
+        }
+        Assert::IsTrue(expectedReaches == reaches);
+
+        Assert::IsTrue(buffers.hint.has_value() == !reaches.isEmpty());
+        if (buffers.hint)
+        {
+          Assert::IsTrue(*buffers.hint < buffers.reach_ids.size());
+        }
+      }
+    }
+
+    TEST_METHOD(QueryMatches_OmitsHintUnlessRequested)
+    {
+      BlockManager manager;
+      const DictionaryIndex index(Array<String>{ U"いか", U"かい" });
+
+      WordMatchBuffers buffers;
+      manager.QueryMatches(Array<String>{ U"い" }, index, buffers, false);
+
+      Assert::AreEqual(size_t{ 2 }, buffers.reach_ids.size());
+      Assert::IsFalse(buffers.hint.has_value());
+    }
+
+    TEST_METHOD(GetWordsWithinMissing_MatchesHitAndReachWords)
+    {
+      BlockManager manager;
+      const DictionaryIndex index(GetKeywords());
+      const Array<String> blocks = { U"か", U"わ", U"る", U"め", U"を", U"し", U"た" };
+
+      Array<String> hits;
+      for (const auto& found : manager.GetWordsWithinMissing(blocks, index, 0))
+      {
+        Assert::IsTrue(found.missing.isEmpty());
+        hits << found.word;
+      }
+      Assert::IsTrue(manager.GetHitWords(blocks, GetKeywords()) == hits);
+
+      Array<std::pair<String, String>> reaches;
+      for (const auto& found : manager.GetWordsWithinMissing(blocks, index, 1))
+      {
+        if (found.missing.size() == 1)
+        {
+          reaches.emplace_back(found.word, found.missing.front());
+        }
+      }
+      Assert::IsTrue(manager.GetReachWords(blocks, GetKeywords()) == reaches);
+    }
+
+    TEST_METHOD(GetWordsWithinMissing_ReturnsAllMissingCharactersInOriginalForm)
+    {
+      BlockManager manager;
+      const DictionaryIndex index(Array<String>{ U"ばばあ", U"はは", U"あいうえお", U"あ" });
+      const Array<String> blocks = { U"は", U"あ" };
+
+      const auto found = manager.GetWordsWithinMissing(blocks, index, 2);
+
+      Assert::AreEqual(size_t{ 3 }, found.size());
+      Assert::IsTrue(found[0].word == U"ばばあ");
+      Assert::IsTrue(found[0].missing == Array<String>{ U"ば" });
+      Assert::IsTrue(found[1].word == U"はは");
+      Assert::IsTrue(found[1].missing == Array<String>{ U"は" });
+      Assert::IsTrue(found[2].word == U"あ");
+      Assert::IsTrue(found[2].missing.isEmpty());
+
+      Assert::IsTrue(manager.GetWordsWithinMissing(Array<String>{}, index, 3)[0].missing == Array<String>{ U"ば", U"ば", U"あ" });
+    }
+
+    TEST_METHOD(GenerateKanaGrid_UsesNormalizedKanaIds)
+    {
+      BlockManager manager;
+      const Array<String> dictionary = { U"がっこう", U"ぱん" };
+
+      const auto grid = manager.GenerateKanaGrid(2, 3, 6, dictionary);
+
+      Assert::AreEqual(size_t{ 2 }, grid.size());
+
+      Array<KanaId> cells;
+      for (const auto& line : grid)
+      {
+        Assert::AreEqual(size_t{ 3 }, line.size());
+        cells.insert(cells.end(), line.begin(), line.end());
+      }
+      std::sort(cells.begin(), cells.end());
+
+      Array<KanaId> expected = { ToKanaId(U'か'), ToKanaId(U'つ'), ToKanaId(U'こ'), ToKanaId(U'う'), ToKanaId(U'は'), ToKanaId(U'ん') };
+      std::sort(expected.begin(), expected.end());
+      Assert::IsTrue(expected == cells);
+      Assert::IsTrue(GetKanaString(grid[0][0]) == String(1, FromKanaId(grid[0][0])));
+    }
+
+    TEST_METHOD(GenerateKanaGrid_FromIndexSkipsRemovedWords)
+    {
+      BlockManager manager;
+      DictionaryIndex index(Array<String>{ U"がっこう", U"ぱん", U"ぬ" });
+      index.RemoveWord(2);
+
+      const auto grid = manager.GenerateKanaGrid(2, 3, 6, index);
+
+      Array<KanaId> cells;
+      for (const auto& line : grid)
+      {
+        Assert::AreEqual(size_t{ 3 }, line.size());
+        cells.insert(cells.end(), line.begin(), line.end());
+      }
+      std::sort(cells.begin(), cells.end());
+
+      Array<KanaId> expected = { ToKanaId(U'か'), ToKanaId(U'つ'), ToKanaId(U'こ'), ToKanaId(U'う'), ToKanaId(U'は'), ToKanaId(U'ん') };
+      std::sort(expected.begin(), expected.end());
+      Assert::IsTrue(expected == cells);
+    }
+
+    TEST_METHOD(GenerateKanaGrid_UsesEveryWordOnceWithinBatch)
+    {
+      // 部分 Fisher–Yates で非復元抽出するので、1 バッチ内で同じ語が2回使われることはない。
+      BlockManager manager;
+      const Array<String> dictionary = { U"あ", U"い", U"う", U"え", U"お", U"か" };
+
+      for (int32 trial = 0; trial < 20; ++trial)
+      {
+        const auto grid = manager.GenerateKanaGrid(2, 3, 6, dictionary);
+
+        Array<KanaId> cells;
+        for (const auto& line : grid)
+        {
+          cells.insert(cells.end(), line.begin(), line.end());
+        }
+        std::sort(cells.begin(), cells.end());
+
+        Array<KanaId> expected = { ToKanaId(U'あ'), ToKanaId(U'い'), ToKanaId(U'う'), ToKanaId(U'え'), ToKanaId(U'お'), ToKanaId(U'か') };
+        std::sort(expected.begin(), expected.end());
+        Assert::IsTrue(expected == cells);
+      }
+    }
+
+    TEST_METHOD(KanaAliasTable_FollowsDictionaryFrequency)
+    {
+      const DictionaryIndex index(Array<String>{ U"かか", U"かき", U"がき" });
+      const KanaAliasTable table(index);
+
+      Assert::IsFalse(table.IsEmpty());
+      Assert::AreEqual(4.0 / 6.0, table.GetProbability(ToKanaId(U'か')), 1e-9);
+      Assert::AreEqual(2.0 / 6.0, table.GetProbability(ToKanaId(U'き')), 1e-9);
+      Assert::AreEqual(0.0, table.GetProbability(ToKanaId(U'あ')), 1e-9);
+
+      // 重み 0 の文字は選ばれない。
+      size_t kaCount = 0;
+      const size_t sampleCount = 6000;
+      for (size_t i = 0; i < sampleCount; ++i)
+      {
+        const KanaId id = table.Sample();
+        Assert::IsTrue(id == ToKanaId(U'か') || id == ToKanaId(U'き'));
+        kaCount += (id == ToKanaId(U'か')) ? 1 : 0;
+      }
+      Assert::IsTrue(3600 < kaCount && kaCount < 4400);
+
+      Assert::IsTrue(KanaAliasTable().IsEmpty());
+      Assert::IsTrue(KanaAliasTable().Sample() == kInvalidKanaId);
+    }
+
+    TEST_METHOD(GenerateKanaGrid_WithAliasTableFillsEveryCell)
+    {
+      BlockManager manager;
+      std::array<uint64, kKanaAlphabetSize> weights{};
+      weights[ToKanaId(U'ぬ')] = 3;
+      weights[ToKanaId(U'ね')] = 1;
+      const KanaAliasTable table(weights);
+
+      const auto grid = manager.GenerateKanaGrid(30, 40, table);
+
+      Assert::AreEqual(size_t{ 30 }, grid.size());
+      for (const auto& line : grid)
+      {
+        Assert::AreEqual(size_t{ 40 }, line.size());
+        for (const KanaId id : line)
+        {
+          Assert::IsTrue(id == ToKanaId(U'ぬ') || id == ToKanaId(U'ね'));
+        }
+      }
+
+      Assert::IsTrue(manager.GenerateKanaGrid(3, 3, KanaAliasTable()).isEmpty());
+    }
+
     TEST_METHOD(GenerateBlockGrid_ReturnsGridWithRequestedSize)
     {
       BlockManager manager;
@@ -229,5 +2048,26 @@ namespace UnitTest
       return flattened;
     }
   };
-}
 
+  /// <summary>
+  /// 高速化した各判定方式を、配列版の BlockManager::GetHitWords / GetReachWords（基準実装）と突き合わせる差分テスト。
+  /// 濁点・半濁点・小文字・長音記号を含む手持ちと、辞書の部分集合を乱数（固定の種）で作り、
+  /// ヒット単語・リーチ単語・足りない文字の表記と順番がすべて一致することを確かめる。
+  /// </summary>
+  TEST_CLASS(DifferentialWordEngineTests)
+  {
+  public:
+
+    TEST_METHOD(AllEngines_MatchReferenceOnRandomInputs)
+    {
+      // 本体は DifferentialWordEngine.cpp（Linux では DifferentialMain.cpp から同じものを実行する）。
+      const DifferentialWordEngine::Report report = DifferentialWordEngine::Run();
+
+      const std::wstring message = report.mismatch ? DifferentialWordEngine::Describe(*report.mismatch).toWstr() : std::wstring{};
+      Assert::IsFalse(report.mismatch.has_value(), message.c_str());
+
+      // 乱数の入力が空振りばかりでないこと。
+      Assert::IsTrue(report.non_empty_query_count > report.query_count / 4);
+    }
+  };
+}